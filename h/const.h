@@ -26,7 +26,7 @@
 
 #define MAXDEVICES          49              /* maximum number of external devices, plus additional semaphore for pseudo-clock */
 #define PCLOCKIDX           MAXDEVICES - 1  /* index of the pseudo-clock */
-#define MAXPROC             20              /* Max concurrent processes supported */
+#define MAXPROC             20              /* Max concurrent processes (phase 1/2 static tables; phase 5 uses slab caches) */
 
 #define NUCLEUSSTACKTOP     0x20001000      /* top of the nucleus stack */
 
@@ -42,10 +42,14 @@
 #define DIRTYON             0x00000400          /* dirty bit on */
 #define VALIDON             0x00000200          /* valid bit on */
 #define VALIDOFF            0xFFFFFDFF          /* valid bit off */
+#define DIRTYOFF            0xFFFFFBFF          /* dirty bit off: the page is read-only */
+#define PFNMASK             0xFFFFF000          /* entry LO: physical frame address */
 
 /******************************* Timer Constants *****************************/
 
 #define INITIALPLT          5000                /* time slice for scheduler in milliseconds (5ms) */
+#define TARGETLATENCY       20000               /* phase 5: every ready process runs within 20ms */
+#define MINGRANULARITY      1000                /* phase 5: shortest time slice (1ms) */
 #define INITIALINTTIMER     100000              /* time slice for system-wide Internal Timer (100ms) */   
 #define INFINITE            0x7FFFFFFF          /* infinite time */
 
@@ -120,6 +124,7 @@
 #define CAUSESHIFT          2                   /* number of bits to shift right to get exception code */
 
 /* Cause register constants for interrupt lines */
+#define LINE0INT            0x00000100          /* interrupt line 0: inter-processor interrupts */
 #define LINE1INT            0x00000200          /* interrupt line 1 */
 #define LINE2INT            0x00000400          /* interrupt line 2 */
 #define LINE3INT            0x00000800          /* interrupt line 3 */
@@ -128,7 +133,15 @@
 #define LINE6INT            0x00004000          /* interrupt line 6 */
 #define LINE7INT            0x00008000          /* interrupt line 7 */
 
+/* Cause.IP: bit 8 + n is set while interrupt line n is pending */
+#define IPSHIFT             8                   /* shift the pending lines down to bits 0..7 */
+#define INTLINEBITS         0xFF                /* lines 0..7, once shifted (line 0 only carries TLB shootdowns) */
+#define DEVLINEBITS         0xF8                /* lines 3..7, once shifted */
+#define BYTEMASK            0xFF
+#define NOBIT               8                   /* lowestBit[0]: no bit set */
+
 /* Interrupt line number */
+#define	LINE0			    0
 #define	LINE1			    1				
 #define	LINE2			    2			
 #define	LINE3			    3			
@@ -181,6 +194,52 @@
 #define SYS16CALL           16                  /* read from flash */
 #define SYS17CALL           17                  /* write to flash */
 #define SYS18CALL           18                  /* delay process */
+#define SYS19CALL           19                  /* dump the kernel trace ring */
+#define SYS20CALL           20                  /* export the PC sampling profile */
+#define SYS21CALL           21                  /* CPU utilization over the last N pseudo-clock ticks */
+#define SYS22CALL           22                  /* peripheral interrupt statistics */
+#define SYS23CALL           23                  /* set the caller's stride tickets */
+#define SYS24CALL           24                  /* enter or leave the real-time class */
+#define SYS25CALL           25                  /* real-time deadline misses */
+#define SYS26CALL           26                  /* duplicate the caller, copy-on-write */
+#define SYS27CALL           27                  /* start a U-proc from a flash device */
+#define SYS28CALL           28                  /* compressed swap tier statistics */
+#define SYS29CALL           29                  /* turn load control off or on */
+
+/* Kernel-mode nucleus services beyond SYS8 (not passed up) */
+#define SYS30CALL           30                  /* lock a priority-inheritance mutex */
+#define SYS31CALL           31                  /* unlock a priority-inheritance mutex */
+#define SYS32CALL           32                  /* set the stride tickets of the caller or its newest child */
+#define SYS33CALL           33                  /* enter or leave the real-time class */
+#define SYS34CALL           34                  /* real-time deadline misses */
+
+/* Process priorities (SYS1 a3): ready and mutex queues are kept highest priority first */
+#define DEFAULTPRIORITY     0
+#define MAXPRIORITY         7
+#define MUTEXFREE           1                   /* mx_value of an unlocked mutex */
+
+/* Fair-share groups: a U-Proc (a process created with a support structure) and the processes
+   it creates form the group of its ASID; the kernel's own processes form group 0 */
+#define MAXGROUPS           (MAXASID + 1)
+#define KERNELGROUP         0
+#define DEFAULTSHARE        1                   /* share weight when sup_share is not positive */
+
+/* Stride scheduling within a group: a process's pass advances by STRIDE1 / p_tickets for
+   each microsecond it runs, and the group's ready process with the least pass runs next */
+#define DEFAULTTICKETS      1
+#define MAXTICKETS          100
+#define STRIDE1             MAXTICKETS
+#define STRIDELAG           (INITIALPLT * STRIDE1)  /* pass a waking process may lag its group by */
+#define STRIDEMAX           0x40000000          /* most a pass advances per settlement, so passes stay within 2^31 */
+
+/* Earliest-deadline-first real-time class (SYS33): an admitted process with budget left in
+   its period runs at RTPRIORITY, above every SYS1 priority, earliest deadline first */
+#define RTPRIORITY          (MAXPRIORITY + 1)
+#define MAXRTPROCS          16                  /* real-time processes admitted at once */
+#define RTMINPERIOD         1000                /* shortest period, in microseconds */
+#define RTMAXPERIOD         4000000             /* longest period: budget * RTLOADSCALE fits in 32 bits */
+#define RTLOADSCALE         1000                /* loads are budget / period in thousandths */
+#define RTMAXLOAD           900                 /* load admitted per processor */
 
 /******************************* Exception Handling Constants *****************************/
 
@@ -217,7 +276,7 @@
 
 /******************************* Paging & Virtual Memory Constants *****************************/
 
-#define NUMPAGES            32                  /* pages per process private page table */
+#define NUMPAGES            32                  /* pages per process private page table (phase 3/4 flat layout) */
 #define VPNMASK             0xFFFFF000          /* virtual page number mask */
 #define VPNSHIFT            12                  /* virtual page number shift */
 #define PFNSHIFT            6                   /* physical frame number shift */ 
@@ -225,16 +284,40 @@
 #define INDEXMASK           0x80000000          /* mask for Index.P bit */
 
 /* User Process Configuration */
-#define UPROCMAX            8                   /* max concurrent user processes */
+#define MAXASID             63                  /* largest ASID: EntryHi.ASID is 6 bits and ASID 0 is the kernel's */
 #define UPROCTEXTSTART      0x800000B0          /* start address of user text segment */
+#define AOUTTEXTSIZE        0x0014              /* aout header: byte offset of the .text file size */
 #define USERSTACKTOP        0xC0000000          /* user stack top address */
 #define ASIDSHIFT           6                   /* address space identifier shift */
+#define ASIDMASK            0x3F                /* address space identifier, once shifted down */
 #define STACKTOP            499                 /* top of stack area for exception handler */
 
 /* Virtual Page Number Boundaries */
 #define VPNSTART            0x80000             /* virtual page number start address */
 #define STACKPAGEVPN        0xBFFFF             /* virtual page number for user stack */
 
+/* Two-level Page Tables: text/data grows up from VPNSTART, stack grows down from STACKPAGEVPN */
+#define PTESPERTABLE        128                 /* entries per second-level table (1.5KB) */
+#define PTESHIFT            7                   /* log2(PTESPERTABLE): page offset -> directory slot */
+#define PTEMASK             0x0000007F          /* page offset -> entry within a second-level table */
+#define TEXTTABLES          16                  /* directory slots for the text/data/heap region */
+#define STACKTABLES         4                   /* directory slots for the stack region */
+#define MAXTEXTPAGES        (TEXTTABLES * PTESPERTABLE)     /* text/data/heap pages per U-proc (8MB) */
+#define MAXSTACKPAGES       (STACKTABLES * PTESPERTABLE)    /* stack pages per U-proc (2MB) */
+
+/* Backing-store locations: a page table entry names the flash device and block its page
+   is paged from, so pages duplicated by SYS26 can share blocks until one side writes */
+#define BACKINGSHIFT        24                  /* pt_backing: flash device above this bit... */
+#define BACKINGBLOCK        0x00FFFFFF          /* ...and block below it */
+#define BACKING(DEV, BLOCK) (((DEV) << BACKINGSHIFT) | ((BLOCK) & BACKINGBLOCK))
+#define BACKINGDEV(B)       ((unsigned int) (B) >> BACKINGSHIFT)
+#define BACKINGBLK(B)       ((B) & BACKINGBLOCK)
+#define MAXSHAREDBLOCKS     PAGESIZE            /* largest flash device SYS26 shares: one frame of 1-byte block counts */
+
+/* Image page sharing: resident .text pages are found by an FNV-1a hash of their words */
+#define FNVBASIS            0x811C9DC5          /* FNV-1a 32-bit offset basis */
+#define FNVPRIME            0x01000193          /* FNV-1a 32-bit prime */
+
 /******************************* I/O & Device Constants *****************************/
 
 #define MAXIODEVICES        48                  /* max external I/O devices */
@@ -258,13 +341,45 @@
 #define READBLK             2                   /* flash read block command */
 #define WRITEBLK            3                   /* flash write block command */
 #define BLOCKSHIFT          8                   /* shift for flash block operations */
+#define BADBLOCKSTATUS      -1                  /* flashTransfer's status for a block past the device's end */
 
 /******************************* Swap Pool Constants *****************************/
 
-#define SWAPPOOLSTART       0x20020000          /* swap pool's starting address */
-#define SWAPPOOLSIZE        (2 * UPROCMAX)      /* swap pool's size (frames) */
+#define SWAPPOOLSHARE       2                   /* the swap pool takes 1/SWAPPOOLSHARE of the free frames at boot */
 #define EMPTYFRAME          -1                  /* indicator of empty frame in swap pool */
 
+/* Compressed swap tier: evicted dirty pages are kept compressed in RAM, in chunks */
+#define ZSWAPSHARE          4                   /* the tier takes 1/ZSWAPSHARE of the frames left after the swap pool */
+#define ZCHUNKWORDS         64                  /* words per chunk (256 bytes) */
+#define ZMAXWORDS           ((PAGESIZE / WORDLEN) * 3 / 4)  /* pages that do not compress to 3/4 go to flash */
+#define ZMINRUN             3                   /* shortest run of one word worth a run token */
+#define ZBUCKETS            64                  /* hash buckets over (flash device, block) */
+#define ZNONE               -1                  /* end of a chunk or entry list */
+#define ZCLUSTER            8                   /* most pages written back under one hold of a flash device */
+#define ZCLUSTERSCAN        32                  /* a write-back batch is taken from this many of the oldest pages */
+
+/* Load control: U-Procs are suspended while their working sets overflow the Swap Pool */
+#define LOADFAULTGAP        10000               /* cpu microseconds between faults that keep the working set steady */
+#define LOADRESUME          7                   /* resume a U-Proc once the working sets fit in 7/8 of the pool... */
+#define LOADRESUMESCALE     8
+#define LOADMAXSUSPEND      2000000             /* ...or once it has waited 2s, to take turns */
+
+/******************************* Kernel Memory Constants *****************************/
+
+#define DMASTART            0x20020000          /* first byte past the kernel image: DMA buffers, then the page pool */
+#define RESERVEDSTACKS      2                   /* frames at the top of RAM kept for the boot and test() stacks */
+#define SLABMAXPAGES        4                   /* largest slab a cache grows by (frames) */
+#define CACHELINE           32                  /* alignment for objects touched on every pass up (support_t) */
+
+/* Support Level exception stacks: each U-Proc takes one block of EXCSTACKPAGES frames from the
+ * stack pool, split into its TLB stack (lower half) and general stack (upper half). The lowest
+ * STACKGUARDSIZE bytes of each stack are a canary band standing in for a guard page, since
+ * kseg0 is unmapped and a real guard page could never fault */
+#define EXCSTACKPAGES       1                                   /* frames per U-Proc stack block */
+#define EXCSTACKSIZE        ((EXCSTACKPAGES * PAGESIZE) / 2)    /* bytes per handler stack, guard band included */
+#define STACKGUARDSIZE      128                                 /* bytes of canary at the bottom of each stack */
+#define STACKCANARY         0x57ACC0DE                          /* guard band fill pattern */
+
 /******************************* Disk Constants *****************************/
 
 #define CYLINDERSHIFT       16                  /* shift to retrieve cylinder number */
@@ -278,8 +393,17 @@
 #define SECTORNUMSHIFT      8                   /* shift for sector number */
 #define HEADNUMSHIFT        16                  /* shift for head number */
 
+#ifdef LEGACYSUPPORT
+/* Phases 3 and 4 (built with -DLEGACYSUPPORT): UPROCMAX U-Procs and a fixed Swap Pool below the DMA buffers */
+#define UPROCMAX            8                   /* max concurrent user processes */
+#define SWAPPOOLSTART       0x20020000          /* swap pool's starting address */
+#define SWAPPOOLSIZE        (2 * UPROCMAX)      /* swap pool's size (frames) */
 #define DISKSTART           (SWAPPOOLSTART + (SWAPPOOLSIZE * PAGESIZE))     /* start address of disk */
+#else
+#define DISKSTART           DMASTART                                        /* start address of disk */
+#endif
 #define FLASHSTART          (DISKSTART + (DEVPERINT * PAGESIZE))            /* start address of flash memory */
+#define PAGEPOOLSTART       (FLASHSTART + (DEVPERINT * PAGESIZE))           /* first frame managed by the page allocator */
 
 /******************************* Delay Constants *****************************/
 
@@ -287,6 +411,83 @@
 #define DELAYTIME           1000                /* delay time in milliseconds */
 #define UNITCONVERT         1000000             /* unit conversion factor (milliseconds to seconds) */
 
+/******************************* Trace Constants *****************************/
+
+/* Kernel trace ring (built with -DKTRACE): each record is one trace_t */
+#define TRACEENTRIES        256                 /* records in the ring (power of two: indices wrap by masking) */
+#define TRACEMAGIC          0x54524331          /* "TRC1": first word of the ring, for dump decoders */
+#define TRACEEVENTSHIFT     8                   /* tr_event = (event << TRACEEVENTSHIFT) | ASID */
+
+/* Trace event types: what tr_arg0 / tr_arg1 hold */
+#define TREXCEPTION         1                   /* TLB or program trap: exception code / EPC */
+#define TRINTERRUPT         2                   /* interrupt: Cause register / EPC */
+#define TRDISPATCH          3                   /* scheduler dispatch: PC / CPU time used so far */
+#define TRIDLE              4                   /* scheduler WAIT: softBlockCount / processCount */
+#define TRSYSCALL           5                   /* nucleus SYSCALL: number / a1 */
+#define TRSUPSYSCALL        6                   /* support level SYSCALL: number / a1 */
+#define TRPAGEFAULT         7                   /* pager fill: missing VPN / swap pool frame */
+#define TRDEADLINE          8                   /* real-time deadline missed: deadline / misses so far */
+#define TRSUSPEND           9                   /* load control suspended a U-Proc: working sets / pool frames */
+#define TRRESUME            10                  /* load control resumed a U-Proc: working sets / pool frames */
+
+/******************************* Utilization Constants *****************************/
+
+/* Classes the nucleus keeps blocked time for: device lines 3..7 in order, then the pseudo-clock */
+#define BLOCKCLASSES        6                   /* disk, flash, network, printer, terminal, pseudo-clock */
+#define TERMCLASS           4                   /* both terminal sub-devices */
+#define CLOCKCLASS          5                   /* SYS7 waiters */
+#define UTILTICKS           64                  /* pseudo-clock ticks of history kept for SYS21 */
+
+/* Lines the idle scheduler can find already latched (interval timer and devices; the PLT is
+ * silenced first), and how many latched interrupts it handles directly before it WAITs anyway */
+#define IDLEWAKELINES       (LINE2INT | LINE3INT | LINE4INT | LINE5INT | LINE6INT | LINE7INT)
+#define IDLENESTMAX         4
+
+/******************************* Multiprocessor Constants *****************************/
+
+/* Processors the nucleus runs on (build with -DNCPUS=n, at most the machine configuration's) */
+#ifndef NCPUS
+#define NCPUS               1
+#endif
+
+/* An idle processor with nothing to steal WAITs with its PLT on, for this long, before looking
+ * again; alone it has nobody to steal from, and waits for an interrupt as before */
+#if NCPUS > 1
+#define IDLETIMER           INITIALPLT
+#define IDLEPLT             PLTON
+#else
+#define IDLETIMER           INFINITE
+#define IDLEPLT             ALLOFF
+#endif
+
+/* A process alone on its processor runs until it blocks; on a multiprocessor it still comes
+ * back to the nucleus every TARGETLATENCY, where a SYS2 from elsewhere is carried out */
+#if NCPUS > 1
+#define LONESLICE           TARGETLATENCY
+#else
+#define LONESLICE           INFINITE
+#endif
+
+#define PASSUPSTRIDE        0x10                /* bytes between the processors' Pass Up Vectors */
+#define IRTBASE             0x10000300          /* Interrupt Routing Table: one word per source */
+#define IRTENTRIES          48                  /* interval timer and device lines 2..7, 8 each */
+#define IRTDYNAMIC          0x10000000          /* route to the least busy processor in the mask */
+#define IPIINBOX            0x10000400          /* this processor's oldest IPI message; a write acknowledges it */
+#define IPIOUTBOX           0x10000404          /* a write sends an IPI: recipients mask and message */
+#define IPIRECIPSHIFT       16                  /* recipients mask position in an Outbox word */
+#define IPITLBFLUSH         1                   /* message: clear your TLB (see shootdownTLB) */
+#define LOCKFREE            0                   /* kernel lock values */
+#define LOCKHELD            1
+
+/******************************* Profiler Constants *****************************/
+
+/* PC sampling profiler (built with -DKPROFILE): an open-addressed table of (ASID, PC) counts */
+#define PROFSLOTS           1024                /* table slots (power of two: hashes wrap by masking) */
+#define PROFPROBES          8                   /* slots tried before a sample is dropped */
+#define PROFMAGIC           0x50524631          /* "PRF1": first word of the table, for dump decoders */
+#define PROFHASH            0x9E3779B1          /* multiplicative hash constant (2^32 / golden ratio) */
+#define PROFHASHSHIFT       22                  /* 32 - log2(PROFSLOTS): keep the hash's top bits */
+
 /******************************* Miscellaneous Constants *****************************/
 
 #define MAXSTRINGLENGTH     128                 /* max length for terminal I/O strings */
@@ -4,7 +4,7 @@
 /************************* DEVICESUPPORTDMA.h *****************************
  *
  * Written by   : Uyen Nguyen
- * Last update  : 2025/05/09
+ * Last update  : 2025/06/09
  *
  *****************************************************************/
 
@@ -24,4 +24,10 @@ extern void flashGet(support_t *currentSupportStruct); /* Flash get operation */
 /* Flash operation function */
 extern int  flashOperation(support_t *currentSupportStruct, int logicalAddress, int flashNumber, int blockNumber, int operation);
 
+/* Back-to-back flash operations under one hold of the device */
+extern int  flashBlockValid(int flashNumber, int blockNumber);
+extern void flashLock(int flashNumber);
+extern int  flashTransfer(int logicalAddress, int flashNumber, int blockNumber, int operation);
+extern void flashUnlock(int flashNumber);
+
 #endif /* DEVICESUPPORTDMA */
\ No newline at end of file
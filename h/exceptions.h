@@ -15,9 +15,15 @@
 #include "../h/const.h"
 #include "../h/types.h"
 
+extern int   killCount;                     /* Processes killed by the most recent SYS2 */
+extern cpu_t killTime;                      /* TOD ticks that teardown took */
+
 extern void programTrapExceptionHandler();
 extern void TLBExceptionHandler();
 extern void syscallExceptionHandler();
 extern void uTLB_RefillHandler();
 
+extern void requeueByPriority(pcb_PTR p);   /* Move p after its p_priority changed */
+extern void settlePriority(pcb_PTR p);      /* Recompute p_priority from its base and mutexes */
+
 #endif /* EXCEPTIONS */
\ No newline at end of file
@@ -0,0 +1,30 @@
+#ifndef FAIRSHARE_H
+#define FAIRSHARE_H
+
+/************************* FAIRSHARE.h *****************************
+ *
+ * This header declares the fair-share group accounting used by the
+ * scheduler. Every U-Proc and the processes it creates form one group,
+ * indexed by the U-Proc's ASID and weighted by its sup_share; the
+ * scheduler charges the running group at every entry and dispatches
+ * from the group with the least cpu time per unit of share, and within
+ * it the process with the least stride pass
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/06/01
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+extern group_t groups[MAXGROUPS];               /* One group per ASID; group 0 is the kernel's */
+
+extern void initGroups(void);                   /* Empty every group */
+extern void joinGroup(pcb_PTR p, pcb_PTR parent, support_t *supportStruct);   /* p is created */
+extern void leaveGroup(pcb_PTR p);              /* p is terminated */
+extern int assignTickets(pcb_PTR p, int tickets);   /* Set p's stride tickets */
+extern void chargeRunningGroup(void);           /* The dispatched process left the processor */
+extern pcb_PTR removeFairShare(pcb_PTR *tp);    /* Take the next process to dispatch */
+
+#endif /* FAIRSHARE_H */
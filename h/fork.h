@@ -0,0 +1,20 @@
+#ifndef FORK_H
+#define FORK_H
+
+/************************* FORK.h *****************************
+ *
+ * This header declares SYS26, which duplicates the calling U-Proc.
+ * The child shares the parent's pages copy-on-write (see vmSupport.c)
+ * and is launched by test(), so it outlives its parent
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/06/04
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+extern void forkUserProcess(state_PTR savedState, support_t *currentSupportStruct);    /* SYS26 */
+
+#endif /* FORK_H */
@@ -5,12 +5,15 @@
  *
  * This header declares the global variables and entry point for the Phase 3
  * initialization for Pandos kernal. It includes masterSemaphore for synchronization,
- * devSemaphores array for mutual exclusion, and test() function that set up the 
+ * devSemaphores array for mutual exclusion, the support structure cache,
+ * and test() function that set up the 
  * Swap Pool structures, related semaphores, builds initial proccess states,
- * and launch U-Procs via SYS1
+ * and launch U-Procs via SYS1, along with the helpers SYS26 uses to build
+ * a U-Proc's support structure and have test() launch it, which SYS27
+ * shares
  * 
  * Written by   : Uyen Nguyen
- * Last update  : 2025/04/17
+ * Last update  : 2025/06/05
  *
  *****************************************************************/
 
@@ -19,9 +22,18 @@
 
 /* Global variables */
 extern int masterSemaphore;                    /* Semaphore for synchronization */
-extern int devSemaphores[MAXIODEVICES];        /* Semaphore for mutual exclusion */
+#ifdef LEGACYSUPPORT
+extern int devSemaphores[MAXIODEVICES];        /* Semaphore for mutual exclusion (phases 3 and 4) */
+#else
+extern mutex_t devSemaphores[MAXIODEVICES];    /* Mutex for mutual exclusion */
+#endif
+extern slab_t supportCache;                    /* Support structure cache */
 
 /* Function declaration */
 extern void test();                            /* Instantiator process function */
+extern support_t *newSupport(int flashDev, int printerDev, int termDev);    /* Build a support structure, or NULL */
+extern void freeSupport(support_t *supportStruct);                          /* Free one that never ran */
+extern void initialUProcState(state_PTR initialState, int asid);          /* State a load image starts in */
+extern int launchUProc(state_PTR initialState, support_t *supportStruct);   /* Have test() SYS1 a U-Proc */
 
 #endif /* INITPROC */
\ No newline at end of file
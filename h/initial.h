@@ -18,8 +18,10 @@
 
 extern int processCount;                    /* Number of active processes in the system */
 extern int softBlockCount;                  /* Number of processes that are currently blocked */
+#ifndef SMP_H                               /* Per processor in phase 5 (see smp.h) */
 extern pcb_PTR readyQueue;                  /* Pointer to the queue of processes that are ready to run */
 extern pcb_PTR currentProcess;              /* Pointer to the currently executing process */
+#endif
 extern int deviceSemaphores[MAXDEVICES];    /* Array of semaphores for device synchronization */
 
 #endif /* INITIAL */
@@ -16,4 +16,6 @@
 
 extern void interruptHandler();
 
+extern intstat_t deviceIntStats;                /* Peripheral interrupt entries / devices serviced */
+
 #endif  /* INTERRUPTS */
\ No newline at end of file
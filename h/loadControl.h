@@ -0,0 +1,25 @@
+#ifndef LOADCONTROL_H
+#define LOADCONTROL_H
+
+/************************* LOADCONTROL.h *****************************
+ *
+ * This header declares the per-ASID working set estimator and the load
+ * controller that suspends U-Procs while their working sets overflow
+ * the Swap Pool. The pager calls them with the Swap Pool semaphore held;
+ * the Delay Daemon calls loadTick every 100ms; SYS29 turns it off or on
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/06/09
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+extern void noteFault(support_t *currentSupportStruct);        /* Update the faulting U-Proc's working set */
+extern void loadControl(void);                                  /* Suspend or resume one U-Proc if needed */
+extern void loadCheckpoint(support_t *currentSupportStruct);    /* Wait here while suspended */
+extern void loadTick(void);                                     /* Periodic loadControl, from the Delay Daemon */
+extern void setLoadControl(state_PTR savedState);               /* SYS29 */
+
+#endif /* LOADCONTROL_H */
@@ -0,0 +1,35 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/************************* PROFILE.h *****************************
+ *
+ * This header declares the PC sampling profiler. When the kernel is built
+ * with -DKPROFILE (make KFLAGS=-DKPROFILE), every PLT and Interval Timer
+ * interrupt counts the interrupted (ASID, PC) pair in profileTable;
+ * otherwise PROFSAMPLE compiles to nothing. SYS20 copies the counts out
+ * and host/profsym maps them to symbols
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/05/28
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+#ifdef KPROFILE
+
+extern profiletable_t profileTable;             /* The histogram, laid out for dump decoders */
+extern void profileSample(state_PTR interrupted);   /* Count one sample */
+
+#define PROFSAMPLE(STATE)   profileSample(STATE)
+
+#else
+
+#define PROFSAMPLE(STATE)
+
+#endif /* KPROFILE */
+
+extern void exportProfile(state_PTR savedState, support_t *currentSupportStruct);    /* SYS20 */
+
+#endif /* PROFILE_H */
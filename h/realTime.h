@@ -0,0 +1,32 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+/************************* REALTIME.h *****************************
+ *
+ * This header declares the earliest-deadline-first real-time class.
+ * A process admitted with a period and a budget (SYS33) runs at
+ * RTPRIORITY, earliest deadline first, until it has used its budget
+ * for the period; it then runs at its own priority until the next
+ * period starts. Periods that end with the job still runnable are
+ * counted as deadline misses (SYS34)
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/06/09
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+extern int rtLoad;                              /* Admitted budget / period, in thousandths */
+extern int rtMisses;                            /* Deadline misses since boot */
+
+extern void initRealTime(void);                 /* Admit nobody */
+extern int admitRealTime(pcb_PTR p, cpu_t period, cpu_t budget);   /* p enters (or leaves) the class */
+extern void leaveRealTime(pcb_PTR p);           /* p is terminated */
+extern void settleRealTime(void);               /* Charge budgets and start new periods */
+extern pcb_PTR removeEarliestDeadline(pcb_PTR *tp); /* Take the real-time process to dispatch */
+extern cpu_t nextRelease(void);                 /* Time until the next period starts */
+extern cpu_t startBudget(pcb_PTR p, cpu_t slice);   /* p is dispatched: its time slice */
+
+#endif /* REALTIME_H */
@@ -7,14 +7,20 @@
  * used in the scheduler module. 
  * 
  * Written by   : Uyen Nguyen
- * Last update  : 2025/02/28 
+ * Last update  : 2025/06/09
  *
  *******************************************************************/
 
+#ifndef SMP_H                       /* Per processor in phase 5 (see smp.h) */
 extern cpu_t startTOD;              /* Hold TOD value at process dispatch */
 extern cpu_t currentTOD;            /* Hold current TOD when STCK */
+#endif
 
 extern void copyState();            /* Helper function to copy a processor state */
 extern void scheduler();            /* Round-robin scheduler */
+extern void boundSlice(void);       /* A process became ready: end an unbounded slice (phase 5) */
+extern void preemptSlice(pcb_PTR p); /* p is requeued without blocking: no credit (phase 5) */
+extern void makeReady(pcb_PTR p);   /* Onto this processor's ready queue, counted (phase 5) */
+extern void leaveReady(pcb_PTR p);  /* Off whichever ready queue p is on, counted (phase 5) */
 
 #endif /* SCHEDULER */
\ No newline at end of file
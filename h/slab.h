@@ -0,0 +1,37 @@
+#ifndef SLAB
+#define SLAB
+
+/************************* SLAB.h *****************************
+ *
+ * This header declares the kernel memory allocator: a boot-time page
+ * allocator over the RAM left after the kernel image and DMA buffers,
+ * and slab caches that carve those pages into fixed-size objects
+ * (pcb_t, semd_t, delayd_t, support_t, page tables) on demand, and
+ * the page-granular pool the U-Procs' exception stacks come from
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/05/20
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+/* Page allocator */
+extern void initMemory(memaddr ramTop);                         /* Hand the free RAM to the page allocator */
+extern void *allocPages(int pageCount);                         /* Contiguous frames (boot-time carve-outs) */
+extern void *allocPage(void);                                   /* One frame */
+extern void freePage(void *page);                               /* Return one frame */
+extern int  freePageCount(void);                                /* Frames still available */
+
+/* Slab caches */
+extern void slabInit(slab_t *cache, int objSize, int align);    /* Set up an (empty) cache */
+extern void *slabAlloc(slab_t *cache);                          /* Take an object, growing by one slab if needed */
+extern void slabFree(slab_t *cache, void *obj);                 /* Return an object to its cache */
+
+/* Exception stack pool */
+extern void *allocStacks(void);                                 /* One U-Proc's stack block, guards armed */
+extern void freeStacks(void *stackBlock);                       /* Return a stack block to the pool */
+extern int  stackIntact(memaddr stackTop);                      /* Is the guard band below stackTop untouched? */
+
+#endif /* SLAB */
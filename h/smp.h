@@ -0,0 +1,81 @@
+#ifndef SMP_H
+#define SMP_H
+
+/************************* SMP.h *****************************
+ *
+ * This header declares the nucleus's per-processor state and its
+ * big kernel lock. The nucleus globals that belong to one processor
+ * (the running process, the ready queue, the dispatch TOD, ...) are
+ * fields of cpus[CPUID()], under their old names, so the handlers
+ * read the same on one processor as on several. With NCPUS 1 (the
+ * default) CPUID() is 0 and the lock operations compile away
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/06/09
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+extern percpu_t cpus[NCPUS];                    /* One entry per processor */
+extern unsigned int tlbEpoch;                   /* Bumped when a mapping may be stale in some TLB */
+
+#if NCPUS > 1
+#define CPUID()             getPRID()
+#else
+#define CPUID()             0
+#endif
+
+/* This processor's nucleus state */
+#define thisCPU             (cpus[CPUID()])
+#define currentProcess      (thisCPU.pc_current)
+#define readyQueue          (thisCPU.pc_readyQueue)
+#define startTOD            (thisCPU.pc_startTOD)
+#define currentTOD          (thisCPU.pc_currentTOD)
+#define remainingTime       (thisCPU.pc_remainingTime)
+
+/* The state this processor saved on its last exception */
+#define EXCSTATE            ((state_PTR) (BIOSDATAPAGE + (CPUID() * sizeof(state_t))))
+
+/* Leave the nucleus: release the kernel lock, then load the state */
+#define RESUME(STATE) do {                                                          \
+    leaveNucleus();                                                                 \
+    LDST(STATE);                                                                    \
+} while (0)
+
+extern void initCPUs(void);                     /* Empty every processor's state */
+extern unsigned int lockNucleus(void);          /* Interrupts off, kernel lock held */
+extern void unlockNucleus(unsigned int status); /* Undo lockNucleus */
+
+#if NCPUS > 1
+
+extern void startCPUs(void);                    /* Start the other processors */
+extern void enterNucleus(void);                 /* Take the kernel lock on nucleus entry */
+extern void leaveNucleus(void);                 /* Release it on the way out */
+extern void reapTerminated(void);               /* Free pc_current if it was terminated elsewhere */
+extern int reapElsewhere(pcb_PTR p);            /* Have another processor free p, if it runs it */
+extern int onReadyQueue(pcb_PTR p);             /* Is p on some processor's ready queue */
+extern void stealWork(void);                    /* Refill an empty ready queue from another's */
+extern int othersRunning(void);                 /* Does another processor run a process */
+extern void noteDispatch(pcb_PTR p);            /* Clear a stale TLB before p runs */
+extern void shootdownTLB(unsigned int asid);    /* Wait until no TLB maps asid's old pages */
+extern void ipiInterrupt(void);                 /* Clear this TLB on another processor's request */
+
+#else
+
+#define startCPUs()
+#define enterNucleus()
+#define leaveNucleus()
+#define reapTerminated()
+#define reapElsewhere(P)    FALSE
+#define onReadyQueue(P)     ((P)->p_queue == &readyQueue)
+#define stealWork()
+#define othersRunning()     FALSE
+#define noteDispatch(P)
+#define shootdownTLB(ASID)
+
+#endif /* NCPUS > 1 */
+
+#endif /* SMP_H */
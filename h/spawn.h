@@ -0,0 +1,21 @@
+#ifndef SPAWN_H
+#define SPAWN_H
+
+/************************* SPAWN.h *****************************
+ *
+ * This header declares SYS27, which starts a new U-Proc from a load
+ * image on any free flash device, at any block offset, while the
+ * system runs. Like SYS26 children, spawned U-Procs are launched by
+ * test(), which waits for them before halting
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/06/05
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+extern void spawnUserProcess(state_PTR savedState);    /* SYS27 */
+
+#endif /* SPAWN_H */
@@ -0,0 +1,25 @@
+#ifndef SYSBENCH_H
+#define SYSBENCH_H
+
+/************************* SYSBENCH.h *****************************
+ *
+ * This header declares the syscall microbenchmark, built only when the
+ * kernel is compiled with -DSYSBENCH (make KFLAGS=-DSYSBENCH). test()
+ * launches it before any U-Proc so the measurement runs on an idle machine
+ * 
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/05/22
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+#define BENCHCALLS          100000              /* syscalls timed per run */
+#define BENCHTERM           0                   /* terminal the report is written to */
+#define BENCHKILLDEPTH      64                  /* processes in the chain killed by one SYS2 */
+#define BENCHKILLSTACK      256                 /* stack bytes per chain member (they only P) */
+
+extern void launchSysBench(void);               /* Create the benchmark process and wait for it */
+
+#endif /* SYSBENCH_H */
@@ -19,7 +19,11 @@
 #include "../h/types.h"
  
 /* Function declarations */
-extern void VMgeneralExceptionHandler(void);                                          /* General exception handler */
+#ifdef LEGACYSUPPORT
+extern void VMgeneralExceptionHandler(void);                                          /* General exception handler (phases 3 and 4) */
+#else
+extern void VMgeneralExceptionHandler(support_t *currentSupportStruct);              /* General exception handler */
+#endif
 extern void VMsyscallExceptionHandler(state_PTR savedState, support_t *currentSupportStruct);  /* SYSCALL exception handler */
 extern void VMprogramTrapExceptionHandler(support_t *currentSupportStruct);                                      /* Program Trap exception handler */
 
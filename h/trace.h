@@ -0,0 +1,56 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/************************* TRACE.h *****************************
+ *
+ * This header declares the kernel trace ring. When the kernel is built
+ * with -DKTRACE (make KFLAGS=-DKTRACE), the nucleus and the Support Level
+ * append a trace_t record to traceRing at every exception, interrupt,
+ * dispatch, idle, SYSCALL and page fill; otherwise TRACE and SUPTRACE
+ * compile to nothing. TRACE must run with interrupts disabled and the
+ * kernel lock held (as the nucleus always does); SUPTRACE takes both
+ * around the append itself (see lockNucleus)
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/05/27
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/smp.h"
+
+#ifdef KTRACE
+
+extern tracering_t traceRing;                   /* The ring, laid out for dump decoders */
+
+/* Append one record: a few loads and stores, no call */
+#define TRACE(EVENT, ASID, ARG0, ARG1) do {                                         \
+    trace_t *rec_ = &traceRing.tb_rec[traceRing.tb_head & (TRACEENTRIES - 1)];     \
+    traceRing.tb_head++;                                                            \
+    rec_->tr_tod   = *((unsigned int *) TODLOADDR);                                 \
+    rec_->tr_event = ((EVENT) << TRACEEVENTSHIFT) | (ASID);                         \
+    rec_->tr_arg0  = (unsigned int) (ARG0);                                         \
+    rec_->tr_arg1  = (unsigned int) (ARG1);                                         \
+} while (0)
+
+/* Append one record from code that runs with interrupts enabled, outside the nucleus */
+#define SUPTRACE(EVENT, ASID, ARG0, ARG1) do {                                      \
+    unsigned int status_ = lockNucleus();                                           \
+    TRACE(EVENT, ASID, ARG0, ARG1);                                                 \
+    unlockNucleus(status_);                                                         \
+} while (0)
+
+#else
+
+#define TRACE(EVENT, ASID, ARG0, ARG1)
+#define SUPTRACE(EVENT, ASID, ARG0, ARG1)
+
+#endif /* KTRACE */
+
+/* ASID field of an EntryHi value */
+#define TRACEASID(ENTRYHI)  (((ENTRYHI) >> ASIDSHIFT) & ASIDMASK)
+
+extern void dumpTrace(state_PTR savedState, support_t *currentSupportStruct);  /* SYS19 */
+
+#endif /* TRACE_H */
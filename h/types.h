@@ -116,8 +116,12 @@ typedef struct context_t {
 typedef struct pte_t {
 	unsigned int	pt_entryHI;					/* entry HI value */
 	unsigned int	pt_entryLO;					/* entry LO value */	
+	unsigned int	pt_backing;					/* BACKING(flash device, block) the page is paged from */
 } pte_t;
 
+#ifdef LEGACYSUPPORT
+
+/* phases 3 and 4 (built with -DLEGACYSUPPORT): a flat page table and the handlers' stacks inline */
 typedef struct support_t {
 	int				sup_asid;					/* process ID (asid)   */
 	state_t			sup_exceptState[2];			/* stored excpt states */
@@ -130,6 +134,56 @@ typedef struct support_t {
 	int 			sup_privateSemaphore;		/* private semaphore for the process */
 } support_t;
 
+#else
+
+typedef struct support_t {
+	int				sup_asid;					/* process ID (asid)   */
+	int				sup_flashDev;				/* flash device (0..7) backing this address space */
+	int				sup_blockBase;				/* block of the flash device the load image starts at */
+	int				sup_printerDev;				/* printer device (0..7) used by SYS11 */
+	int				sup_termDev;				/* terminal device (0..7) used by SYS12/SYS13 */
+	state_t			sup_exceptState[2];			/* stored excpt states */
+	context_t		sup_exceptContext[2];		/* pass up contexts    */
+
+	pte_t			*sup_textPgTbl[TEXTTABLES];	/* page directory: text/data/heap tables (grow up)  */
+	pte_t			*sup_stackPgTbl[STACKTABLES];	/* page directory: stack tables (grow down)         */
+	int				sup_textPages;				/* text/data pages touched so far (high-water mark) */
+	int				sup_stackPages;				/* stack pages touched so far (high-water mark)     */
+	int				sup_imageText;				/* read-only .text pages of the load image, 0 until page 0 is in */
+
+	int				sup_wsPages;				/* working set estimate, from the intervals between faults */
+	cpu_t			sup_lastFault;				/* cpu time of the U-Proc's last page fault */
+	int				sup_suspended;				/* TRUE while the load controller holds the U-Proc back */
+	int				sup_parked;					/* TRUE while it waits on sup_loadSemaphore */
+	int				sup_loadSemaphore;			/* where a suspended U-Proc waits */
+	cpu_t			sup_loadTOD;				/* TOD it was last suspended or resumed */
+
+	int 			sup_privateSemaphore;		/* private semaphore for the process */
+	int				sup_share;					/* fair-share weight of the U-Proc's group, and its tickets */
+} support_t;
+
+#endif /* LEGACYSUPPORT */
+
+/************************* MUTEX STRUCTURE *****************************/
+
+/* priority-inheritance mutex (SYS30 / SYS31); mx_value works like a semaphore's value and
+   must stay first, since the ASL keys the mutex's waiters on its address */
+typedef struct mutex_t {
+	int				mx_value;			/* MUTEXFREE, 0 when held, -n with n waiters */
+	struct pcb_t	*mx_owner;			/* holder, or NULL */
+	struct mutex_t	*mx_next;			/* next mutex held by the same owner */
+} mutex_t;
+
+/************************* FAIR-SHARE GROUP STRUCTURE *****************************/
+
+/* a fair-share group (phase 5); the scheduler favours the lowest g_time / g_share */
+typedef struct group_t {
+	cpu_t			g_time;				/* cpu time the group's processes used */
+	int				g_share;			/* share weight, at least 1 */
+	int				g_members;			/* live processes in the group */
+	unsigned int	g_pass;				/* stride pass of the member dispatched last */
+} group_t;
+
 /************************* PROCESS CONTROL BLOCK STRUCTURE *****************************/
 
 /* process Control Block (PCB) type */
@@ -143,23 +197,70 @@ typedef struct pcb_t {
 					*p_child,			/* pointer to 1st child */
 					*p_sibNext,			/* pointer to next sibling */
 					*p_sibPrev;			/* pointer to prev sibling */
+	struct pcb_t	**p_queue;			/* tail pointer of the queue holding p, NULL if none (phase 5) */
 	
 	/* process status information */
 	state_t			p_s;				/* processor state */
 	cpu_t			p_time;				/* cpu time used by proc */
 	int				*p_semAdd;			/* pointer to sema4 on which process blocked */
+	cpu_t			p_blockTOD;			/* TOD when it last blocked on a device or the pseudo-clock */
+
+	/* priority information (phase 5) */
+	int				p_priority;			/* effective priority: base, raised by inheritance */
+	int				p_basePriority;		/* priority given at creation (SYS1 a3) */
+	mutex_t			*p_mutexes;			/* mutexes held, most recent first */
+	mutex_t			*p_mutexWait;		/* mutex blocked on, or NULL */
+	group_t			*p_group;			/* fair-share group (phase 5) */
+	int				p_tickets;			/* stride tickets, in its group's currency (SYS32) */
+	unsigned int	p_pass;				/* stride pass; compared modulo 2^32 */
+	cpu_t			p_passTime;			/* p_time already charged to p_pass */
+	cpu_t			p_slice;			/* time slice granted at its last dispatch, 0 if unbounded or given up */
+	cpu_t			p_sliceStart;		/* p_time at that dispatch */
+
+	/* real-time class information (phase 5) */
+	cpu_t			p_period;			/* real-time period in microseconds, 0 if not real-time */
+	cpu_t			p_budget;			/* cpu time it may use per period */
+	cpu_t			p_deadline;			/* TOD the current period ends at */
+	cpu_t			p_rtLeft;			/* budget left this period; RTPRIORITY while positive */
+	int				p_rtDone;			/* blocked since the period started: the job is done */
+	int				p_misses;			/* periods that ended with the job still runnable */
 	
 	/* support layer information */
 	support_t		*p_supportStruct; 	/* pointer to support struct */
 } pcb_t, *pcb_PTR;
 
+/************************* PER-PROCESSOR STRUCTURE *****************************/
+
+/* nucleus state private to one processor (phase 5); see smp.c */
+typedef struct percpu_t {
+	pcb_PTR			pc_current;			/* process running here, or NULL */
+	pcb_PTR			pc_readyQueue;		/* tail pointer of this processor's ready queue */
+	int				pc_readyCount;		/* processes on it (makeReady, leaveReady, the dispatch) */
+	cpu_t			pc_startTOD;		/* TOD of the last dispatch here */
+	cpu_t			pc_currentTOD;		/* TOD read by the handler running here */
+	cpu_t			pc_remainingTime;	/* quantum left when the last interrupt arrived */
+	int				pc_idleNesting;		/* latched interrupts handled in a row without WAIT */
+	int				pc_idling;			/* TRUE between startIdle and endIdle */
+	cpu_t			pc_idleStart;		/* TOD at startIdle */
+	group_t			*pc_runningGroup;	/* fair-share group of pc_current, or NULL */
+	cpu_t			pc_groupStart;		/* TOD that group's charge started at */
+	pcb_PTR			pc_rtProc;			/* real-time process dispatched on its budget, or NULL */
+	cpu_t			pc_rtStart;			/* TOD its budget charge started at */
+	int				pc_lockDepth;		/* kernel lock holds by this processor */
+	int				pc_reap;			/* pc_current was terminated elsewhere: free it on entry */
+	unsigned int	pc_asid;			/* ASID of pc_current */
+	unsigned int	pc_tlbEpoch;		/* tlbEpoch when this processor's TLB was last cleared */
+} percpu_t;
+
 /************************* SEMAPHORE DESCRIPTOR STRUCTURE *****************************/
 
 /* semaphore descriptor type */
 typedef struct semd_t {
-	struct semd_t	*s_next;			/* next element on the ASL */
+	pcb_t			*s_procQ;			/* tail pointer to a process queue; must stay first, so
+										   a blocked pcb's p_queue also addresses its descriptor */
+	struct semd_t	*s_next,			/* next element on the ASL */
+					*s_prev;			/* previous element on the ASL (phase 5) */
 	int				*s_semAdd;			/* pointer to the semaphore */
-	pcb_t			*s_procQ;			/* tail pointer to a process queue */
 } semd_t, *semd_PTR;
 
 /************************* SWAP POOL STRUCTURE *****************************/
@@ -167,9 +268,39 @@ typedef struct semd_t {
 typedef struct swap_t {
 	int				asid;				/* occupant's ASID, or -1 if free */
 	int				vpn;				/* occupant's VPN */
+	int				flash;				/* occupant's backing flash device */
+	int				block;				/* occupant's backing-store block on its flash device */
 	pte_t			*pte;				/* pointer to occupant's page table entry */
+	int				refs;				/* page table entries mapping the frame (SYS26 shares frames) */
+	int				dirty;				/* TRUE if the frame may be newer than its backing block */
+	unsigned int	hash;				/* content hash of a read-only .text page, 0 if not shareable */
 } swap_t;
 
+/************************* COMPRESSED SWAP STRUCTURES *****************************/
+
+typedef struct zentry_t {
+	int				ze_flash;			/* flash device of the page's backing block */
+	int				ze_block;			/* the block */
+	int				ze_first;			/* first chunk of the compressed page */
+	int				ze_words;			/* compressed length in words */
+	int				ze_hashNext;		/* next entry in the bucket, or on the free list */
+	int				ze_older;			/* neighbours in age order: the oldest is written */
+	int				ze_newer;			/* back to flash first when the tier is full */
+} zentry_t;
+
+typedef struct zswapstat_t {
+	unsigned int	zs_stores;			/* dirty pages kept in the tier */
+	unsigned int	zs_rejects;			/* dirty pages written to flash: not compressed to 3/4, or no room */
+	unsigned int	zs_hits;			/* page-ins served from the tier */
+	unsigned int	zs_misses;			/* page-ins read from flash */
+	unsigned int	zs_writebacks;		/* pages the tier wrote to flash to make room */
+	unsigned int	zs_clusters;		/* write-back batches, each under one hold of a device */
+	unsigned int	zs_inBytes;			/* bytes of the pages stored, before compression */
+	unsigned int	zs_outBytes;		/* and after */
+	unsigned int	zs_usedChunks;		/* chunks holding pages now */
+	unsigned int	zs_chunks;			/* chunks in the tier */
+} zswapstat_t;
+
 /************************* DELAY DAEMON STRUCTURE *****************************/
 
 typedef struct delayd_t {
@@ -178,4 +309,61 @@ typedef struct delayd_t {
 	support_t 		*d_supStruct;		/* pointer to support struct */
 } delayd_t;
 
+/************************* SLAB CACHE STRUCTURE *****************************/
+
+typedef struct slab_t {
+	memaddr			sl_free;			/* free objects, linked through their first word */
+	int				sl_objSize;			/* object size in bytes (word multiple) */
+	int				sl_slabPages;		/* frames taken from the page allocator per slab */
+	int				sl_inUse;			/* objects currently handed out */
+	int				sl_total;			/* objects carved so far */
+} slab_t;
+
+/************************* TRACE RING STRUCTURE *****************************/
+
+typedef struct trace_t {
+	unsigned int	tr_tod;				/* low word of the raw TOD clock */
+	unsigned int	tr_event;			/* (event type << TRACEEVENTSHIFT) | ASID */
+	unsigned int	tr_arg0;			/* event argument (see the TR* constants) */
+	unsigned int	tr_arg1;			/* event argument (see the TR* constants) */
+} trace_t;
+
+typedef struct tracering_t {
+	unsigned int	tb_magic;			/* TRACEMAGIC */
+	unsigned int	tb_head;			/* records ever written; the next goes to tb_head % TRACEENTRIES */
+	trace_t			tb_rec[TRACEENTRIES];
+} tracering_t;
+
+/************************* UTILIZATION STRUCTURE *****************************/
+
+typedef struct utilsample_t {
+	cpu_t			us_span;			/* microseconds covered, times NCPUS */
+	cpu_t			us_idle;			/* of which the processor waited idle */
+	cpu_t			us_blocked[BLOCKCLASSES];	/* process-microseconds spent blocked, per class,
+										   charged when each wait ends */
+} utilsample_t;
+
+/************************* INTERRUPT STATISTICS STRUCTURE *****************************/
+
+typedef struct intstat_t {
+	unsigned int	is_entries;			/* peripheral (line 3-7) interrupt handler entries */
+	unsigned int	is_services;		/* device interrupts acknowledged by those entries */
+} intstat_t;
+
+/************************* PROFILE STRUCTURE *****************************/
+
+typedef struct profile_t {
+	unsigned int	pf_asid;			/* ASID the sample was taken in */
+	unsigned int	pf_pc;				/* interrupted PC */
+	unsigned int	pf_count;			/* samples at this (ASID, PC); 0 marks an empty slot */
+} profile_t;
+
+typedef struct profiletable_t {
+	unsigned int	pt_magic;			/* PROFMAGIC */
+	unsigned int	pt_samples;			/* timer interrupts that took a sample */
+	unsigned int	pt_idle;			/* timer interrupts that found the processor idle */
+	unsigned int	pt_dropped;			/* samples lost to a full probe sequence */
+	profile_t		pt_slot[PROFSLOTS];
+} profiletable_t;
+
 #endif /* TYPES */
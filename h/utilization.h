@@ -0,0 +1,32 @@
+#ifndef UTILIZATION_H
+#define UTILIZATION_H
+
+/************************* UTILIZATION.h *****************************
+ *
+ * This header declares the nucleus's idle and blocked time accounting.
+ * The scheduler brackets each idle WAIT with startIdle / endIdle, the
+ * SYS5 / SYS7 paths stamp p_blockTOD and the interrupt handlers charge
+ * the wait to its device class when they unblock a process. Every
+ * pseudo-clock tick closes a utilsample_t in a ring that SYS21 reads
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/05/29
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+extern cpu_t idleTime;                          /* Microseconds spent idle since boot */
+extern cpu_t blockedTime[BLOCKCLASSES];         /* Process-microseconds blocked since boot, per class */
+
+extern void initUtilization(void);              /* Start the first tick */
+extern void startIdle(void);                    /* The scheduler is about to WAIT */
+extern void endIdle(cpu_t now);                 /* An interrupt arrived: close any idle interval */
+extern int  blockClassOf(int semIndex);         /* Class of a deviceSemaphores index */
+extern void accountBlocked(pcb_PTR p, int blockClass, cpu_t now);  /* p's wait is over */
+extern void utilTick(cpu_t now);                /* Close the current pseudo-clock tick */
+extern void getUtilization(state_PTR savedState, support_t *currentSupportStruct);  /* SYS21 */
+extern void getInterruptStats(state_PTR savedState, support_t *currentSupportStruct);   /* SYS22 */
+
+#endif /* UTILIZATION_H */
@@ -6,10 +6,11 @@
  * This header declares the global data structures and function prototypes
  * for Pandos kernel's Phase 3 virtual memory implementation, which includes
  * Swap Pool table and semaphore, initSwapStructs() to initialize those two
- * at boot, and the pager() function that handle TLB misses and page faults
+ * at boot, the pager() function that handle TLB misses and page faults,
+ * and the ASID registry that SYS26 duplicates address spaces through
  * 
  * Written by   : Uyen Nguyen
- * Last update  : 2025/04/17
+ * Last update  : 2025/06/08
  *
  *****************************************************************/
 
@@ -18,6 +19,19 @@
 
 /* Function declarations */
 extern void initSwapStructs(void);                  /* Initialize the Swap Pool table */
-extern void pager(void);                            /* Pager function */
+
+#ifdef LEGACYSUPPORT
+extern void pager(void);                            /* Pager function (phases 3 and 4) */
+#else
+extern mutex_t swapPoolSemaphore;                   /* Mutex for the Swap Pool Table */
+extern int swapPoolSize;                            /* Frames in the Swap Pool */
+extern support_t *addressSpaces[MAXASID + 1];       /* Live address spaces by ASID */
+
+extern void pager(support_t *currentSupportStruct); /* Pager function */
+extern void mutex(mutex_t *semaphore, int doLock);  /* Lock (TRUE) or unlock (FALSE) a support-level mutex */
+extern void releaseAddressSpace(support_t *currentSupportStruct);   /* Free a terminating U-Proc's frames and page tables */
+extern int registerAddressSpace(support_t *currentSupportStruct);   /* Give a new U-Proc an ASID */
+extern int duplicateAddressSpace(support_t *parent, support_t *child);  /* Share parent's pages copy-on-write */
+#endif /* LEGACYSUPPORT */
 
 #endif /* VMSUPPORT */
\ No newline at end of file
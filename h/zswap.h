@@ -0,0 +1,25 @@
+#ifndef ZSWAP_H
+#define ZSWAP_H
+
+/************************* ZSWAP.h *****************************
+ *
+ * This header declares the compressed swap tier that sits between
+ * the pager and the flash devices. The pager pages out and in through
+ * zswapPageOut / zswapPageIn, always holding the Swap Pool semaphore;
+ * SYS28 reports the tier's statistics
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/06/07
+ *
+ *****************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+extern void initZswap(void);                    /* Carve out the tier, after the Swap Pool */
+extern int  zswapPageOut(support_t *currentSupportStruct, memaddr frameAddress, int flash, int block);  /* Keep or write a page */
+extern int  zswapPageIn(support_t *currentSupportStruct, memaddr frameAddress, int flash, int block);   /* Fetch a page */
+extern void zswapPurge(int flash);              /* Forget every page of a flash device */
+extern void getSwapStats(state_PTR savedState, support_t *currentSupportStruct);    /* SYS28 */
+
+#endif /* ZSWAP_H */
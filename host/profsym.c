@@ -0,0 +1,336 @@
+/******************************* PROFSYM.c ***************************************
+ *
+ * Host symbolizer for the kernel's PC sampling profile (kernel built with
+ * -DKPROFILE). It reads the (ASID, PC, count) histogram and maps every PC to
+ * the function containing it, using the symbol table of an ELF32 executable:
+ * the kernel ELF for PCs below KUSEG (the nucleus, the Support Level, and
+ * kernel-mode processes), and a U-Proc's ELF (before umps3-elf2umps turns it
+ * into a .aout) for PCs in KUSEG. Samples are summed per (ASID, function) and
+ * printed hottest first, each with the hottest PC inside the function, which
+ * is usually the loop worth looking at.
+ *
+ * By default the input is a raw memory dump, scanned for the table's
+ * PROFMAGIC word; with -r it is a plain array of profile_t entries, as SYS20
+ * copies them out. Both are little-endian, as uMPS3 is.
+ *
+ * Usage       : profsym [-r] [-k kernel] [-u [asid:]uproc] ... dumpfile
+ *               -k  ELF for kernel-space PCs
+ *               -u  ELF for the user-space PCs of one ASID, or of every ASID
+ *                   that has no ELF of its own
+ * Exit status : 0 on success, 1 if a file cannot be read or holds no table
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/05/28
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+/******************************* CONSTANTS *****************************/
+
+#define ANYASID             -1                  /* -u without an ASID */
+#define MAXELFS             (MAXASID + 2)       /* the kernel, a default, and one per ASID */
+#define MAXROWS             (PROFSLOTS + 1)     /* at most one row per slot */
+
+/* ELF32 layout (little-endian): only what a symbol lookup needs */
+#define EI_NIDENT           16
+#define EH_SHOFF            32                  /* offsets into the file header */
+#define EH_SHENTSIZE        46
+#define EH_SHNUM            48
+#define SH_TYPE             4                   /* offsets into a section header */
+#define SH_OFFSET           16
+#define SH_SIZE             20
+#define SH_LINK             24
+#define SHT_SYMTAB          2
+#define SYMSIZE             16                  /* bytes per symbol */
+#define STT_NOTYPE          0
+#define STT_FUNC            2
+#define SHN_LORESERVE       0xFF00
+
+/******************************* TYPES *****************************/
+
+typedef struct symbol_t {
+    unsigned int    value;
+    unsigned int    size;
+    char            *name;
+} symbol_t;
+
+typedef struct elf_t {
+    int             asid;                       /* ANYASID for the default U-Proc ELF */
+    int             kernel;                     /* TRUE for the kernel ELF */
+    char            *path;
+    symbol_t        *symbols;                   /* sorted by value */
+    int             count;
+} elf_t;
+
+typedef struct row_t {
+    unsigned int    asid;
+    char            *name;                      /* function, or 0 if unknown */
+    elf_t           *elf;
+    unsigned int    count;                      /* samples in the function */
+    unsigned int    hotPc;                      /* its most sampled PC */
+    unsigned int    hotCount;
+} row_t;
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+HIDDEN elf_t elfs[MAXELFS];
+HIDDEN int elfCount;
+HIDDEN row_t rows[MAXROWS];
+HIDDEN int rowCount;
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+/* Read a whole file; NULL is the kernel's sentinel here, so failures return 0 */
+HIDDEN unsigned char *readFile(char *path, long *size) {
+    FILE *file = fopen(path, "rb");
+    unsigned char *data;
+
+    if (file == 0) {
+        perror(path);
+        return 0;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    data = malloc(*size + 1);
+    if (data == 0 || fread(data, 1, *size, file) != (size_t) *size) {
+        fprintf(stderr, "profsym: cannot read %s\n", path);
+        fclose(file);
+        return 0;
+    }
+    fclose(file);
+    return data;
+}
+
+HIDDEN unsigned int read16(unsigned char *p) {
+    return p[0] | (p[1] << 8);
+}
+
+HIDDEN unsigned int read32(unsigned char *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+HIDDEN int bySymbolValue(const void *a, const void *b) {
+    unsigned int x = ((symbol_t *) a)->value, y = ((symbol_t *) b)->value;
+    return (x > y) - (x < y);
+}
+
+HIDDEN int byCount(const void *a, const void *b) {
+    unsigned int x = ((row_t *) a)->count, y = ((row_t *) b)->count;
+    return (x < y) - (x > y);
+}
+
+/* Load the function (and untyped code label) symbols of an ELF32 file; FALSE on error */
+HIDDEN int loadElf(elf_t *elf) {
+    unsigned char *data, *section, *symtab, *strtab, *sym;
+    unsigned int shoff, shentsize, shnum, type, i, j, n;
+    long size;
+
+    if ((data = readFile(elf->path, &size)) == 0) {
+        return FALSE;
+    }
+    if (size < 52 || data[0] != 0x7F || data[1] != 'E' || data[2] != 'L' || data[3] != 'F' || data[4] != 1) {
+        fprintf(stderr, "profsym: %s is not an ELF32 file\n", elf->path);
+        return FALSE;
+    }
+
+    shoff = read32(data + EH_SHOFF);
+    shentsize = read16(data + EH_SHENTSIZE);
+    shnum = read16(data + EH_SHNUM);
+    for (i = 0; i < shnum; i++) {
+        section = data + shoff + (i * shentsize);
+        if (read32(section + SH_TYPE) != SHT_SYMTAB) {
+            continue;
+        }
+        symtab = data + read32(section + SH_OFFSET);
+        n = read32(section + SH_SIZE) / SYMSIZE;
+        strtab = data + read32(data + shoff + (read32(section + SH_LINK) * shentsize) + SH_OFFSET);
+
+        elf->symbols = malloc(n * sizeof(symbol_t));
+        for (j = 0; j < n; j++) {
+            sym = symtab + (j * SYMSIZE);
+            type = sym[12] & 0xF;
+            if ((type != STT_FUNC && type != STT_NOTYPE) || read16(sym + 14) == 0 ||
+                read16(sym + 14) >= SHN_LORESERVE || strtab[read32(sym)] == EOS) {
+                continue;
+            }
+            elf->symbols[elf->count].value = read32(sym + 4);
+            elf->symbols[elf->count].size  = read32(sym + 8);
+            elf->symbols[elf->count].name  = (char *) strtab + read32(sym);
+            elf->count++;
+        }
+        qsort(elf->symbols, elf->count, sizeof(symbol_t), bySymbolValue);
+        return TRUE;
+    }
+    fprintf(stderr, "profsym: %s has no symbol table\n", elf->path);
+    return FALSE;
+}
+
+/* The ELF that describes pc in asid, or 0 */
+HIDDEN elf_t *elfFor(unsigned int asid, unsigned int pc) {
+    elf_t *fallback = 0;
+    int i;
+
+    for (i = 0; i < elfCount; i++) {
+        if (pc < KUSEG) {
+            if (elfs[i].kernel) return &elfs[i];
+        } else if (!elfs[i].kernel) {
+            if (elfs[i].asid == (int) asid) return &elfs[i];
+            if (elfs[i].asid == ANYASID) fallback = &elfs[i];
+        }
+    }
+    return fallback;
+}
+
+/* The function of elf that contains pc, or 0 */
+HIDDEN char *symbolFor(elf_t *elf, unsigned int pc) {
+    int low = 0, high, mid;
+    char *label;
+
+    if (elf == 0 || elf->count == 0) {
+        return 0;
+    }
+    /* Last symbol at or below pc */
+    high = elf->count - 1;
+    if (pc < elf->symbols[0].value) {
+        return 0;
+    }
+    while (low < high) {
+        mid = (low + high + 1) / 2;
+        if (elf->symbols[mid].value <= pc) low = mid; else high = mid - 1;
+    }
+    /* Of the symbols at that address, prefer a function that covers pc over a label (no size) */
+    label = 0;
+    for (mid = low; mid >= 0 && elf->symbols[mid].value == elf->symbols[low].value; mid--) {
+        if (elf->symbols[mid].size == 0) {
+            label = elf->symbols[mid].name;
+        } else if (pc < elf->symbols[mid].value + elf->symbols[mid].size) {
+            return elf->symbols[mid].name;
+        }
+    }
+    return label;
+}
+
+/* Add one histogram entry to its (ASID, function) row */
+HIDDEN void addSample(profile_t *entry) {
+    elf_t *elf = elfFor(entry->pf_asid, entry->pf_pc);
+    char *name = symbolFor(elf, entry->pf_pc);
+    row_t *row = 0;
+    int i;
+
+    for (i = 0; i < rowCount; i++) {
+        if (rows[i].asid == entry->pf_asid && rows[i].name == name && rows[i].elf == elf &&
+            (name != 0 || rows[i].hotPc == entry->pf_pc)) {
+            row = &rows[i];
+            break;
+        }
+    }
+    if (row == 0) {
+        if (rowCount == MAXROWS) {
+            return;
+        }
+        row = &rows[rowCount++];
+        row->asid = entry->pf_asid;
+        row->name = name;
+        row->elf = elf;
+        row->count = 0;
+        row->hotCount = 0;
+    }
+    row->count += entry->pf_count;
+    if (entry->pf_count > row->hotCount) {
+        row->hotCount = entry->pf_count;
+        row->hotPc = entry->pf_pc;
+    }
+}
+
+/******************************* MAIN *****************************/
+
+int main(int argc, char *argv[]) {
+    int recordsOnly = FALSE;
+    char *path = 0, *colon;
+    unsigned char *dump;
+    long size, offset;
+    profiletable_t *table = 0;
+    profile_t *entries;
+    unsigned int count, total, i;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (argv[arg][0] == '-' && argv[arg][1] == 'r') {
+            recordsOnly = TRUE;
+        } else if (argv[arg][0] == '-' && (argv[arg][1] == 'k' || argv[arg][1] == 'u') && arg + 1 < argc) {
+            elf_t *elf = &elfs[elfCount];
+            if (elfCount == MAXELFS) {
+                fprintf(stderr, "profsym: too many ELF files\n");
+                return 1;
+            }
+            elf->kernel = (argv[arg][1] == 'k');
+            elf->asid = ANYASID;
+            elf->path = argv[++arg];
+            colon = elf->path;
+            while (*colon >= '0' && *colon <= '9') colon++;
+            if (!elf->kernel && colon != elf->path && *colon == ':') {
+                elf->asid = atoi(elf->path);
+                elf->path = colon + 1;
+            }
+            if (!loadElf(elf)) {
+                return 1;
+            }
+            elfCount++;
+        } else {
+            path = argv[arg];
+        }
+    }
+    if (path == 0) {
+        fprintf(stderr, "usage: profsym [-r] [-k kernel] [-u [asid:]uproc] ... dumpfile\n");
+        return 1;
+    }
+    if ((dump = readFile(path, &size)) == 0) {
+        return 1;
+    }
+
+    if (recordsOnly) {
+        /* A SYS20 copy: the non-empty entries */
+        entries = (profile_t *) dump;
+        count = size / sizeof(profile_t);
+    } else {
+        /* A raw dump: find the table by its magic word */
+        for (offset = 0; offset + (long) sizeof(profiletable_t) <= size; offset += WORDLEN) {
+            if (*((unsigned int *) (dump + offset)) == PROFMAGIC) {
+                table = (profiletable_t *) (dump + offset);
+                break;
+            }
+        }
+        if (table == 0) {
+            fprintf(stderr, "profsym: no profile table in %s\n", path);
+            return 1;
+        }
+        entries = table->pt_slot;
+        count = PROFSLOTS;
+        printf("table at offset 0x%lx: %u samples, %u idle, %u dropped\n",
+               offset, table->pt_samples, table->pt_idle, table->pt_dropped);
+    }
+
+    total = 0;
+    for (i = 0; i < count; i++) {
+        if (entries[i].pf_count != 0) {
+            addSample(&entries[i]);
+            total += entries[i].pf_count;
+        }
+    }
+    qsort(rows, rowCount, sizeof(row_t), byCount);
+
+    printf("%8s %6s %4s  %-32s %s\n", "samples", "%", "asid", "function", "hottest pc");
+    for (i = 0; i < (unsigned int) rowCount; i++) {
+        printf("%8u %6.2f %4u  %-32s 0x%08x (%u)\n", rows[i].count, (100.0 * rows[i].count) / total,
+               rows[i].asid, (rows[i].name != 0) ? rows[i].name : "?", rows[i].hotPc, rows[i].hotCount);
+    }
+    return 0;
+}
+
+/******************************* END OF PROFSYM.c *****************************/
@@ -0,0 +1,152 @@
+/******************************* QMBENCH.c ***************************************
+ *
+ * Host benchmark for the queue manager (pcb.c / asl.c), built natively by
+ * host/Makefile against the phase chosen at build time. For each depth it
+ * reports the average cost, in nanoseconds, of:
+ *  - removeProcQ + insertProcQ  on a queue holding depth PCBs
+ *  - outProcQ + insertProcQ     of the PCB at the middle of that queue
+ *  - headProcQ                  of that queue
+ *  - removeBlocked + insertBlocked on an ASL with depth active semaphores
+ *                                  (the semaphore leaves and rejoins the ASL)
+ *  - outBlocked + insertBlocked    of the PCB blocked on the middle semaphore
+ *  - headBlocked                   of the middle semaphore
+ * A depth is skipped once the queue manager cannot allocate that many PCBs
+ * (phase 1 stops at MAXPROC).
+ *
+ * Usage       : qmbench [iterations]
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/05/24
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/pcb.h"
+#include "../h/asl.h"
+
+/******************************* CONSTANTS *****************************/
+
+#define BENCHMAXDEPTH       4096                /* deepest queue measured */
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+HIDDEN pcb_PTR pcbs[BENCHMAXDEPTH];         /* PCBs allocated so far */
+HIDDEN int pcbCount;
+HIDDEN int semaphores[BENCHMAXDEPTH];
+HIDDEN volatile unsigned long sink;             /* keeps headProcQ/headBlocked loops alive */
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+HIDDEN double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1e9) + ts.tv_nsec;
+}
+
+/* Make sure at least count PCBs exist; FALSE if the queue manager runs out */
+HIDDEN int ensurePcbs(int count) {
+    while (pcbCount < count) {
+        if ((pcbs[pcbCount] = allocPcb()) == NULL) {
+            return FALSE;
+        }
+        pcbCount++;
+    }
+    return TRUE;
+}
+
+/******************************* BENCHMARKS *****************************/
+
+HIDDEN void benchDepth(int depth, long iterations) {
+    pcb_PTR tail = mkEmptyProcQ();
+    pcb_PTR middle;
+    double start, insRem, outIns, head, blkRem, outBlk, headBlk;
+    long n;
+    int i;
+
+    /* ---- process queue holding depth PCBs ---- */
+    for (i = 0; i < depth; i++) {
+        insertProcQ(&tail, pcbs[i]);
+    }
+    middle = pcbs[depth / 2];
+
+    start = now();
+    for (n = 0; n < iterations; n++) {
+        insertProcQ(&tail, removeProcQ(&tail));     /* rotate: the depth stays constant */
+    }
+    insRem = (now() - start) / iterations;
+
+    start = now();
+    for (n = 0; n < iterations; n++) {
+        insertProcQ(&tail, outProcQ(&tail, middle));
+    }
+    outIns = (now() - start) / iterations;
+
+    start = now();
+    for (n = 0; n < iterations; n++) {
+        sink += (unsigned long) headProcQ(tail);
+    }
+    head = (now() - start) / iterations;
+
+    while (!emptyProcQ(tail)) {
+        removeProcQ(&tail);
+    }
+
+    /* ---- ASL holding depth active semaphores, one PCB each ---- */
+    for (i = 0; i < depth; i++) {
+        insertBlocked(&semaphores[i], pcbs[i]);
+    }
+    middle = pcbs[depth / 2];
+
+    start = now();
+    for (n = 0; n < iterations; n++) {
+        insertBlocked(&semaphores[depth / 2], removeBlocked(&semaphores[depth / 2]));
+    }
+    blkRem = (now() - start) / iterations;
+
+    start = now();
+    for (n = 0; n < iterations; n++) {
+        insertBlocked(&semaphores[depth / 2], outBlocked(middle));
+    }
+    outBlk = (now() - start) / iterations;
+
+    start = now();
+    for (n = 0; n < iterations; n++) {
+        sink += (unsigned long) headBlocked(&semaphores[depth / 2]);
+    }
+    headBlk = (now() - start) / iterations;
+
+    for (i = 0; i < depth; i++) {
+        while (removeBlocked(&semaphores[i]) != NULL) {
+            ;
+        }
+    }
+
+    printf("%6d %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", depth, insRem, outIns, head, blkRem, outBlk, headBlk);
+}
+
+/******************************* MAIN *****************************/
+
+int main(int argc, char *argv[]) {
+    long iterations = (argc > 1) ? atol(argv[1]) : 200000;
+    int depth;
+
+    initPcbs();
+    initASL();
+
+    printf("ns/op   %10s %10s %10s %10s %10s %10s\n", "rem+ins", "out+ins", "headQ", "rem+blk", "out+blk", "headBlk");
+    for (depth = 1; depth <= BENCHMAXDEPTH; depth *= 4) {
+        if (ensurePcbs(depth) == FALSE) {
+            printf("%6d (skipped: only %d PCBs available)\n", depth, pcbCount);
+            break;
+        }
+        benchDepth(depth, iterations);
+    }
+    return 0;
+}
+
+/******************************* END OF QMBENCH.c *****************************/
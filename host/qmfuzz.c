@@ -0,0 +1,265 @@
+/******************************* QMFUZZ.c ***************************************
+ *
+ * Randomized differential fuzzer for the queue manager (pcb.c / asl.c), built
+ * natively by host/Makefile against the phase chosen at build time. A stream of
+ * random insertProcQ / removeProcQ / outProcQ / insertBlocked / removeBlocked /
+ * outBlocked calls is applied both to the real queue manager and to a simple
+ * array-based reference model; every return value is compared, and after each
+ * step the process queues are walked link by link (both directions) and every
+ * semaphore's head is checked. At the end the ASL is drained and compared in
+ * FIFO order. outProcQ is deliberately fed PCBs that sit in other queues (or in
+ * none), which the queue manager must reject with NULL.
+ *
+ * Usage       : qmfuzz [steps] [seed]
+ * Exit status : 0 if the queue manager agreed with the model throughout, 1 otherwise
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/05/24
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/pcb.h"
+#include "../h/asl.h"
+
+/******************************* CONSTANTS *****************************/
+
+#define FUZZPCBS            20                  /* PCBs in play (phase 1's MAXPROC) */
+#define FUZZQUEUES          4                   /* process queues in play */
+#define FUZZSEMS            6                   /* semaphores in play */
+#define FREEOWNER           -1                  /* model owner of a PCB in no queue */
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+HIDDEN pcb_PTR pcbs[FUZZPCBS];                  /* every PCB the queue manager handed out */
+HIDDEN int owner[FUZZPCBS];                     /* model: queue (0..) or semaphore (FUZZQUEUES..) holding each PCB */
+
+HIDDEN pcb_PTR queueTail[FUZZQUEUES];           /* real process queues */
+HIDDEN int model[FUZZQUEUES + FUZZSEMS][FUZZPCBS]; /* model: FIFO of PCB indices per queue / semaphore */
+HIDDEN int modelLength[FUZZQUEUES + FUZZSEMS];
+
+HIDDEN int semaphores[FUZZSEMS];                /* the semaphores' addresses are what the ASL keys on */
+
+HIDDEN unsigned int rngState;                   /* xorshift32 state */
+HIDDEN long step;                               /* current step, for error reports */
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+HIDDEN unsigned int rng(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+HIDDEN void fail(char *what) {
+    fprintf(stderr, "qmfuzz: step %ld: %s\n", step, what);
+    exit(1);
+}
+
+/* Append PCB i to model list l */
+HIDDEN void modelPush(int l, int i) {
+    model[l][modelLength[l]++] = i;
+    owner[i] = l;
+}
+
+/* Remove PCB i from model list l */
+HIDDEN void modelOut(int l, int i) {
+    int j, k;
+    for (j = 0; j < modelLength[l]; j++) {
+        if (model[l][j] == i) {
+            for (k = j; k < modelLength[l] - 1; k++) {
+                model[l][k] = model[l][k + 1];
+            }
+            modelLength[l]--;
+            owner[i] = FREEOWNER;
+            return;
+        }
+    }
+}
+
+/* A random PCB that is in no queue, or -1 */
+HIDDEN int randomFree(void) {
+    int start = rng() % FUZZPCBS;
+    int i;
+    for (i = 0; i < FUZZPCBS; i++) {
+        if (owner[(start + i) % FUZZPCBS] == FREEOWNER) {
+            return (start + i) % FUZZPCBS;
+        }
+    }
+    return -1;
+}
+
+/* Walk queue q link by link and compare it with the model */
+HIDDEN void checkQueue(int q) {
+    pcb_PTR tail = queueTail[q];
+    pcb_PTR curr;
+    int j;
+
+    if (emptyProcQ(tail) != (modelLength[q] == 0)) {
+        fail("emptyProcQ disagrees with the model");
+    }
+    if (modelLength[q] == 0) {
+        if (headProcQ(tail) != NULL) {
+            fail("headProcQ of an empty queue is not NULL");
+        }
+        return;
+    }
+    if (headProcQ(tail) != pcbs[model[q][0]]) {
+        fail("headProcQ disagrees with the model");
+    }
+    if (tail != pcbs[model[q][modelLength[q] - 1]]) {
+        fail("tail pointer disagrees with the model");
+    }
+
+    curr = tail->p_next;
+    for (j = 0; j < modelLength[q]; j++) {
+        if (curr != pcbs[model[q][j]]) {
+            fail("forward walk disagrees with the model");
+        }
+        if (curr->p_next->p_prev != curr) {
+            fail("p_next / p_prev links are inconsistent");
+        }
+        curr = curr->p_next;
+    }
+    if (curr != tail->p_next) {
+        fail("queue is not circular");
+    }
+}
+
+/* Compare every semaphore's head with the model */
+HIDDEN void checkSemaphores(void) {
+    int s;
+    for (s = 0; s < FUZZSEMS; s++) {
+        pcb_PTR expected = (modelLength[FUZZQUEUES + s] == 0) ? NULL : pcbs[model[FUZZQUEUES + s][0]];
+        if (headBlocked(&semaphores[s]) != expected) {
+            fail("headBlocked disagrees with the model");
+        }
+    }
+}
+
+/******************************* FUZZ STEPS *****************************/
+
+HIDDEN void fuzzStep(void) {
+    int q = rng() % FUZZQUEUES;
+    int s = rng() % FUZZSEMS;
+    int i;
+    pcb_PTR result;
+
+    switch (rng() % 6) {
+        case 0:                                 /* insertProcQ */
+            if ((i = randomFree()) >= 0) {
+                insertProcQ(&queueTail[q], pcbs[i]);
+                modelPush(q, i);
+            }
+            break;
+
+        case 1:                                 /* removeProcQ */
+            result = removeProcQ(&queueTail[q]);
+            if (modelLength[q] == 0) {
+                if (result != NULL) fail("removeProcQ of an empty queue is not NULL");
+            } else {
+                if (result != pcbs[model[q][0]]) fail("removeProcQ returned the wrong PCB");
+                modelOut(q, model[q][0]);
+            }
+            break;
+
+        case 2:                                 /* outProcQ: any PCB, member or not */
+            i = rng() % FUZZPCBS;
+            result = outProcQ(&queueTail[q], pcbs[i]);
+            if (owner[i] == q) {
+                if (result != pcbs[i]) fail("outProcQ missed a member");
+                modelOut(q, i);
+            } else if (result != NULL) {
+                fail("outProcQ removed a PCB that was not in the queue");
+            }
+            break;
+
+        case 3:                                 /* insertBlocked */
+            if ((i = randomFree()) >= 0) {
+                if (insertBlocked(&semaphores[s], pcbs[i]) != FALSE) fail("insertBlocked ran out of descriptors");
+                if (pcbs[i]->p_semAdd != &semaphores[s]) fail("insertBlocked did not set p_semAdd");
+                modelPush(FUZZQUEUES + s, i);
+            }
+            break;
+
+        case 4:                                 /* removeBlocked */
+            result = removeBlocked(&semaphores[s]);
+            if (modelLength[FUZZQUEUES + s] == 0) {
+                if (result != NULL) fail("removeBlocked of an inactive semaphore is not NULL");
+            } else {
+                if (result != pcbs[model[FUZZQUEUES + s][0]]) fail("removeBlocked returned the wrong PCB");
+                if (result->p_semAdd != NULL) fail("removeBlocked did not clear p_semAdd");
+                modelOut(FUZZQUEUES + s, model[FUZZQUEUES + s][0]);
+            }
+            break;
+
+        case 5:                                 /* outBlocked: any PCB that is not on a process queue */
+            i = rng() % FUZZPCBS;
+            if ((owner[i] != FREEOWNER) && (owner[i] < FUZZQUEUES)) {
+                break;
+            }
+            if (owner[i] == FREEOWNER) {
+                pcbs[i]->p_semAdd = NULL;       /* as the nucleus leaves a running process */
+            }
+            result = outBlocked(pcbs[i]);
+            if (owner[i] >= FUZZQUEUES) {
+                if (result != pcbs[i]) fail("outBlocked missed a blocked PCB");
+                modelOut(owner[i], i);
+            } else if (result != NULL) {
+                fail("outBlocked removed a PCB that was not blocked");
+            }
+            break;
+    }
+}
+
+/******************************* MAIN *****************************/
+
+int main(int argc, char *argv[]) {
+    long steps = (argc > 1) ? atol(argv[1]) : 1000000;
+    int i, q, s;
+
+    rngState = (argc > 2) ? (unsigned int) strtoul(argv[2], 0, 0) : 0x2545F491;
+    if (rngState == 0) {
+        rngState = 1;
+    }
+
+    initPcbs();
+    initASL();
+    for (i = 0; i < FUZZPCBS; i++) {
+        if ((pcbs[i] = allocPcb()) == NULL) {
+            fprintf(stderr, "qmfuzz: allocPcb failed after %d PCBs\n", i);
+            return 1;
+        }
+        owner[i] = FREEOWNER;
+    }
+    for (q = 0; q < FUZZQUEUES; q++) {
+        queueTail[q] = mkEmptyProcQ();
+    }
+
+    for (step = 0; step < steps; step++) {
+        fuzzStep();
+        for (q = 0; q < FUZZQUEUES; q++) {
+            checkQueue(q);
+        }
+        checkSemaphores();
+    }
+
+    /* Drain the ASL in FIFO order */
+    for (s = 0; s < FUZZSEMS; s++) {
+        while (modelLength[FUZZQUEUES + s] > 0) {
+            if (removeBlocked(&semaphores[s]) != pcbs[model[FUZZQUEUES + s][0]]) fail("drain order disagrees with the model");
+            modelOut(FUZZQUEUES + s, model[FUZZQUEUES + s][0]);
+        }
+        if (removeBlocked(&semaphores[s]) != NULL) fail("semaphore still active after draining");
+    }
+
+    printf("qmfuzz: %ld steps, seed 0x%08X: ok\n", steps, (argc > 2) ? (unsigned int) strtoul(argv[2], 0, 0) : 0x2545F491);
+    return 0;
+}
+
+/******************************* END OF QMFUZZ.c *****************************/
@@ -0,0 +1,161 @@
+/******************************* QMKILL.c ***************************************
+ *
+ * Host benchmark that kills deep process trees through the queue manager
+ * (pcb.c / asl.c), built natively by host/Makefile against the phase chosen
+ * at build time. Each tree is built with insertChild, and its members are
+ * spread round-robin over the ready queue and a few semaphores, so the queues
+ * the teardown removes from are as long as the tree is large. The tree is then
+ * torn down exactly as the nucleus's SYS2 does it: an iterative post-order
+ * walk that unlinks each leaf from its parent, then outBlocked or
+ * outProcQ(&readyQueue), then freePcb.
+ * Two shapes are measured for each size:
+ *  - chain  every process has one child (depth = size)
+ *  - 4-ary  every process has up to four children (depth = log4 size)
+ * and the average cost, in nanoseconds per killed process, is reported.
+ * A size is skipped once the queue manager cannot allocate that many PCBs
+ * (phase 1 stops at MAXPROC).
+ *
+ * Usage       : qmkill [processes]   (processes killed per measurement)
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/05/26
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/pcb.h"
+#include "../h/asl.h"
+
+/******************************* CONSTANTS *****************************/
+
+#define KILLMAXSIZE         4096                /* largest tree measured */
+#define KILLSEMS            4                   /* semaphores the blocked members share */
+#define KILLFANOUT          4                   /* children per process in the 4-ary shape */
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+HIDDEN pcb_PTR tree[KILLMAXSIZE];               /* members of the tree being built */
+HIDDEN pcb_PTR readyQueue;                      /* stands in for the nucleus's ready queue */
+HIDDEN int semaphores[KILLSEMS];
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+HIDDEN double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (ts.tv_sec * 1e9) + ts.tv_nsec;
+}
+
+/* The nucleus's terminateProcess, minus the semaphore and process count bookkeeping */
+HIDDEN void killTree(pcb_PTR proc) {
+    pcb_PTR victim, parent;
+
+    if (proc->p_prnt != NULL) {
+        outChild(proc);
+    }
+    victim = proc;
+    while (victim != NULL) {
+        while (!emptyChild(victim)) {
+            victim = victim->p_child;
+        }
+        parent = victim->p_prnt;
+        if (parent != NULL) {
+            removeChild(parent);
+        }
+        if (victim->p_semAdd != NULL) {
+            outBlocked(victim);
+        } else {
+            outProcQ(&readyQueue, victim);
+        }
+        freePcb(victim);
+        victim = parent;
+    }
+}
+
+/*
+ * Build a tree of size processes: member i's parent is member (i - 1) / fanout.
+ * Members alternate between the ready queue and the semaphores. Returns the
+ * root, or NULL if the queue manager ran out of PCBs (the partial tree is killed).
+ */
+HIDDEN pcb_PTR buildTree(int size, int fanout) {
+    int i;
+
+    for (i = 0; i < size; i++) {
+        if ((tree[i] = allocPcb()) == NULL) {
+            if (i > 0) {
+                killTree(tree[0]);
+            }
+            return NULL;
+        }
+        if (i > 0) {
+            insertChild(tree[(i - 1) / fanout], tree[i]);
+        }
+        if ((i % (KILLSEMS + 1)) == 0) {
+            insertProcQ(&readyQueue, tree[i]);
+        } else {
+            insertBlocked(&semaphores[i % (KILLSEMS + 1) - 1], tree[i]);
+        }
+    }
+    return tree[0];
+}
+
+/* Average ns per killed process over enough trees to kill about processes PCBs; < 0 if skipped */
+HIDDEN double benchShape(int size, int fanout, long processes) {
+    long trees = (processes / size > 0) ? processes / size : 1;
+    double elapsed = 0, start;
+    pcb_PTR root;
+    long n;
+
+    for (n = 0; n < trees; n++) {
+        if ((root = buildTree(size, fanout)) == NULL) {
+            return -1;
+        }
+        start = now();
+        killTree(root);
+        elapsed += now() - start;
+
+        if (!emptyProcQ(readyQueue)) {
+            fprintf(stderr, "qmkill: ready queue not empty after the kill\n");
+            exit(1);
+        }
+    }
+    return elapsed / ((double) trees * size);
+}
+
+/******************************* MAIN *****************************/
+
+int main(int argc, char *argv[]) {
+    long processes = (argc > 1) ? atol(argv[1]) : 200000;
+    double chain, bushy;
+    int size, s;
+
+    initPcbs();
+    initASL();
+    readyQueue = mkEmptyProcQ();
+
+    printf("ns/kill %10s %10s\n", "chain", "4-ary");
+    for (size = 16; size <= KILLMAXSIZE; size *= 4) {
+        chain = benchShape(size, 1, processes);
+        bushy = benchShape(size, KILLFANOUT, processes);
+        if (chain < 0 || bushy < 0) {
+            printf("%6d (skipped: not enough PCBs)\n", size);
+            break;
+        }
+        printf("%6d %10.1f %10.1f\n", size, chain, bushy);
+    }
+
+    for (s = 0; s < KILLSEMS; s++) {
+        if (headBlocked(&semaphores[s]) != NULL) {
+            fprintf(stderr, "qmkill: semaphore %d still active after the kills\n", s);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/******************************* END OF QMKILL.c *****************************/
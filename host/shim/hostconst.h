@@ -0,0 +1,37 @@
+#ifndef HOSTCONST
+#define HOSTCONST
+
+/************************* HOSTCONST.h *****************************
+ *
+ * Host (x86-64 Linux) shim for h/const.h, force-included ahead of every
+ * queue manager source by host/Makefile. The kernel's constants assume
+ * 32-bit pointers: the ASL tail sentinel (MAXINT) must compare above every
+ * address, and NULL is a 32-bit all-ones pointer. Both are widened here;
+ * everything else comes from the real h/const.h unchanged. The harnesses
+ * must not include any libc header this file does not, or NULL reverts to 0.
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/05/24
+ *
+ *****************************************************************/
+
+/* The harnesses' libc headers come first: each of them resets NULL to 0 */
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* h/const.h only defines MAXINT if it is not already defined */
+#define MAXINT              (~0UL)
+
+#undef NULL
+#include "../../h/const.h"
+
+/* Same sentinel as the kernel's, but pointer-sized */
+#undef NULL
+#define NULL                ((void *) 0xFFFFFFFFUL)
+
+/* -DQMDEBUG membership checks call the kernel's PANIC */
+#define PANIC()             abort()
+
+#endif /* HOSTCONST */
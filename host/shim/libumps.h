@@ -0,0 +1,21 @@
+#ifndef UMPS_LIBUMPS_H
+#define UMPS_LIBUMPS_H
+
+/************************* LIBUMPS.h *****************************
+ *
+ * Host (x86-64 Linux) stand-in for uMPS3's libumps.h, force-included by
+ * host/Makefile ahead of kernel sources that include the real one. It takes
+ * the real header's include guard, so the kernel's absolute include of it
+ * expands to nothing (and its PANIC declaration does not meet hostconst.h's
+ * macro); only the calls the host builds use are declared, and each harness
+ * defines them.
+ *
+ * Written by   : Uyen Nguyen
+ * Last update  : 2025/06/09
+ *
+ *****************************************************************/
+
+extern unsigned int SYSCALL(unsigned int number, unsigned int arg1, unsigned int arg2, unsigned int arg3);
+extern void LDST(void *statep);
+
+#endif /* UMPS_LIBUMPS_H */
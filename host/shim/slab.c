@@ -0,0 +1,41 @@
+/******************************* SLAB.c (host shim) ***************************
+ *
+ * Host stand-in for phase5/slab.c so the Phase 5 queue manager can be built
+ * and exercised natively. Caches are backed by malloc(); only sl_objSize and
+ * the in-use counters of slab_t are used, since sl_free is a 32-bit memaddr.
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/05/24
+ *
+ *****************************************************************************/
+
+#include <stdlib.h>
+
+#include "../../h/const.h"
+#include "../../h/types.h"
+#include "../../h/slab.h"
+
+void slabInit(slab_t *cache, int objSize, int align) {
+    cache->sl_free      = 0;
+    cache->sl_objSize   = (objSize + align - 1) & ~(align - 1);
+    cache->sl_slabPages = 0;
+    cache->sl_inUse     = 0;
+    cache->sl_total     = 0;
+}
+
+void *slabAlloc(slab_t *cache) {
+    void *obj;
+
+    obj = malloc(cache->sl_objSize);
+    if (obj == 0) {
+        return NULL;
+    }
+    cache->sl_inUse++;
+    cache->sl_total++;
+    return obj;
+}
+
+void slabFree(slab_t *cache, void *obj) {
+    cache->sl_inUse--;
+    free(obj);
+}
@@ -0,0 +1,188 @@
+/******************************* TRACEDUMP.c ***************************************
+ *
+ * Host decoder for the kernel trace ring (kernel built with -DKTRACE). It turns
+ * a memory dump into a timeline, one line per record, oldest first:
+ *
+ *        tod      delta asid event       details
+ *
+ * By default the input is a raw memory dump: the decoder scans it for the
+ * ring's TRACEMAGIC word (so a dump of all of RAM works as well as one of just
+ * traceRing), reads the record count that follows and unrolls the ring. With
+ * -r the input is instead a plain array of trace_t records in order, as SYS19
+ * copies them out. Both are little-endian, as uMPS3 is.
+ *
+ * Usage       : tracedump [-r] [-s timescale] dumpfile
+ *               -s  TOD ticks per microsecond: print times in microseconds
+ * Exit status : 0 on success, 1 if the file cannot be read or holds no ring
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/05/27
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../h/const.h"
+#include "../h/types.h"
+
+/******************************* CONSTANTS *****************************/
+
+#define CAUSEIPSHIFT        8                   /* Cause.IP: one pending bit per interrupt line */
+#define INTLINES            8
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+HIDDEN char *eventNames[] = {
+    "?", "EXCEPTION", "INTERRUPT", "DISPATCH", "IDLE", "SYSCALL", "SUPSYSCALL", "PAGEFAULT"
+};
+
+HIDDEN char *syscallNames[] = {
+    "?", "create", "terminate", "P", "V", "waitIO", "getCPUTime", "waitClock", "getSupport",
+    "terminateU", "getTOD", "printer", "termWrite", "termRead", "diskPut", "diskGet",
+    "flashPut", "flashGet", "delay", "dumpTrace"
+};
+
+HIDDEN char *exceptionNames[] = {
+    "Int", "Mod", "TLBL", "TLBS", "AdEL", "AdES", "IBE", "DBE", "Sys", "Bp", "RI", "CpU", "Ov"
+};
+
+HIDDEN unsigned int timescale;                  /* 0: print raw TOD ticks */
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+/* Print one record; prev is the previous record's TOD */
+HIDDEN void printRecord(trace_t *rec, unsigned int prev) {
+    unsigned int event = rec->tr_event >> TRACEEVENTSHIFT;
+    unsigned int asid = rec->tr_event & ((1 << TRACEEVENTSHIFT) - 1);
+    unsigned int delta = rec->tr_tod - prev;     /* wraps correctly with the 32-bit TOD */
+    char deltaText[16];
+    int line;
+
+    if (timescale != 0) {
+        sprintf(deltaText, "+%u", delta / timescale);
+        printf("%10u %10s %4u ", rec->tr_tod / timescale, deltaText, asid);
+    } else {
+        sprintf(deltaText, "+%u", delta);
+        printf("%10u %10s %4u ", rec->tr_tod, deltaText, asid);
+    }
+    printf("%-10s ", (event <= TRPAGEFAULT) ? eventNames[event] : eventNames[0]);
+
+    switch (event) {
+        case TREXCEPTION:
+            printf("%s epc=0x%08x\n",
+                   (rec->tr_arg0 < sizeof(exceptionNames) / sizeof(exceptionNames[0])) ? exceptionNames[rec->tr_arg0] : "?",
+                   rec->tr_arg1);
+            break;
+
+        case TRINTERRUPT:
+            printf("lines");
+            for (line = 0; line < INTLINES; line++) {
+                if ((rec->tr_arg0 >> (CAUSEIPSHIFT + line)) & 1) {
+                    printf(" %d", line);
+                }
+            }
+            printf(" epc=0x%08x\n", rec->tr_arg1);
+            break;
+
+        case TRDISPATCH:
+            printf("pc=0x%08x cpu=%u\n", rec->tr_arg0, rec->tr_arg1);
+            break;
+
+        case TRIDLE:
+            printf("softBlocked=%u processes=%u\n", rec->tr_arg0, rec->tr_arg1);
+            break;
+
+        case TRSYSCALL:
+        case TRSUPSYSCALL:
+            printf("SYS%u (%s) a1=0x%08x\n", rec->tr_arg0,
+                   (rec->tr_arg0 <= SYS19CALL) ? syscallNames[rec->tr_arg0] : "?", rec->tr_arg1);
+            break;
+
+        case TRPAGEFAULT:
+            printf("vpn=0x%05x frame=%u\n", rec->tr_arg0, rec->tr_arg1);
+            break;
+
+        default:
+            printf("0x%08x 0x%08x\n", rec->tr_arg0, rec->tr_arg1);
+    }
+}
+
+/******************************* MAIN *****************************/
+
+int main(int argc, char *argv[]) {
+    int recordsOnly = FALSE;
+    char *path = 0;
+    FILE *file;
+    unsigned char *dump;
+    long size, offset;
+    tracering_t *ring;
+    trace_t *records;
+    unsigned int count, first, i, prev;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (argv[arg][0] == '-' && argv[arg][1] == 'r') {
+            recordsOnly = TRUE;
+        } else if (argv[arg][0] == '-' && argv[arg][1] == 's' && arg + 1 < argc) {
+            timescale = (unsigned int) strtoul(argv[++arg], 0, 0);
+        } else {
+            path = argv[arg];
+        }
+    }
+    if (path == 0) {
+        fprintf(stderr, "usage: tracedump [-r] [-s timescale] dumpfile\n");
+        return 1;
+    }
+
+    /* Read the whole dump (NULL is the kernel's sentinel here, so test against 0) */
+    if ((file = fopen(path, "rb")) == 0) {
+        perror(path);
+        return 1;
+    }
+    fseek(file, 0, SEEK_END);
+    size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    dump = malloc(size + 1);
+    if (dump == 0 || fread(dump, 1, size, file) != (size_t) size) {
+        fprintf(stderr, "tracedump: cannot read %s\n", path);
+        return 1;
+    }
+    fclose(file);
+
+    if (recordsOnly) {
+        /* A SYS19 copy: the records, already oldest first */
+        records = (trace_t *) dump;
+        count = size / sizeof(trace_t);
+        first = 0;
+    } else {
+        /* A raw dump: find the ring by its magic word */
+        ring = 0;
+        for (offset = 0; offset + (long) sizeof(tracering_t) <= size; offset += WORDLEN) {
+            if (*((unsigned int *) (dump + offset)) == TRACEMAGIC) {
+                ring = (tracering_t *) (dump + offset);
+                break;
+            }
+        }
+        if (ring == 0) {
+            fprintf(stderr, "tracedump: no trace ring in %s\n", path);
+            return 1;
+        }
+        records = ring->tb_rec;
+        count = (ring->tb_head < TRACEENTRIES) ? ring->tb_head : TRACEENTRIES;
+        first = ring->tb_head - count;
+        printf("ring at offset 0x%lx: %u records written, last %u kept\n", offset, ring->tb_head, count);
+    }
+
+    printf("%10s %10s %4s %-10s %s\n", timescale ? "us" : "tod", "delta", "asid", "event", "details");
+    prev = 0;
+    for (i = 0; i < count; i++) {
+        /* A ring is unrolled from its oldest record; a SYS19 copy has first = 0 */
+        trace_t *rec = &records[recordsOnly ? i : ((first + i) & (TRACEENTRIES - 1))];
+        printRecord(rec, (i == 0) ? rec->tr_tod : prev);
+        prev = rec->tr_tod;
+    }
+    return 0;
+}
+
+/******************************* END OF TRACEDUMP.c *****************************/
@@ -0,0 +1,363 @@
+/******************************* ZSWAPFUZZ.c ***************************************
+ *
+ * Randomized round-trip fuzzer for the compressed swap tier (phase5/zswap.c),
+ * built natively by host/Makefile. The flash devices, the page allocator and the
+ * few nucleus calls the tier makes are stood in for here; the tier itself is the
+ * kernel's code, unchanged. A stream of random page-outs (zero-filled, sparse,
+ * run-heavy and random pages, so both stores and rejects happen), page-ins and
+ * purges is applied, with a small tier so that clustered write-backs are frequent.
+ * The model is the contents every backing block must read back as; every page-in
+ * is compared against it word for word, so a bad compression, chunk chain, hash
+ * lookup or write-back shows up as a mismatch. A page-in right after a stored
+ * page-out must hit, a page-in of a block whose device was purged must miss, and
+ * SYS28's counters (read through getSwapStats) must stay consistent throughout.
+ * Now and then a flash transfer fails, as a device error would. A write-back
+ * that fails sends the page being paged out straight to flash; a page-out that
+ * fails altogether leaves its block reading back as before, and nothing else
+ * changes.
+ *
+ * Usage       : zswapfuzz [steps] [seed]
+ * Exit status : 0 if every page read back as the model expected, 1 otherwise
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/06/09
+ *
+ *****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/deviceSupportDMA.h"
+#include "../h/slab.h"
+#include "../h/zswap.h"
+
+/******************************* CONSTANTS *****************************/
+
+#define FUZZFLASH           3                   /* flash devices in play */
+#define FUZZBLOCKS          64                  /* blocks in play per device */
+#define FUZZFRAMES          48                  /* free frames after the Swap Pool: the tier gets 1/ZSWAPSHARE */
+#define FUZZFAILRATE        512                 /* one flash transfer in FUZZFAILRATE fails */
+#define PAGEWORDS           (PAGESIZE / WORDLEN)
+
+#define ZEROPAGE            0                   /* page kinds */
+#define SPARSEPAGE          1
+#define RUNPAGE             2
+#define RANDOMPAGE          3
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+mutex_t swapPoolSemaphore;                      /* the tier's callers hold it; getSwapStats takes it */
+
+HIDDEN unsigned int flash[FUZZFLASH][FUZZBLOCKS][PAGEWORDS];   /* the devices' blocks */
+HIDDEN int flashHeld[FUZZFLASH];                /* flashLock holds */
+HIDDEN int poolHeld;                            /* SYS30 on swapPoolSemaphore */
+
+HIDDEN unsigned int model[FUZZFLASH][FUZZBLOCKS][PAGEWORDS];   /* what every block must read back as */
+HIDDEN int purged[FUZZFLASH][FUZZBLOCKS];       /* device purged since the block was last paged out */
+
+HIDDEN char arena[FUZZFRAMES * PAGESIZE] __attribute__((aligned(PAGESIZE)));  /* the free frames */
+HIDDEN int arenaUsed;                           /* frames handed out */
+
+HIDDEN unsigned int frame[PAGEWORDS] __attribute__((aligned(PAGESIZE)));      /* a Swap Pool frame */
+HIDDEN support_t support;                       /* the faulting U-Proc's */
+
+HIDDEN unsigned int rngState;                   /* xorshift32 state */
+HIDDEN long step;                               /* current step, for error reports */
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+HIDDEN unsigned int rng(void) {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+HIDDEN void fail(char *what) {
+    fprintf(stderr, "zswapfuzz: step %ld: %s\n", step, what);
+    exit(1);
+}
+
+/* Fill the frame with a random page of the given kind */
+HIDDEN void fillPage(int kind) {
+    int i, run, longest;
+    unsigned int value;
+
+    for (i = 0; i < PAGEWORDS; i++) {
+        frame[i] = 0;
+    }
+    switch (kind) {
+        case SPARSEPAGE:
+            for (run = 1 + (rng() % 16); run > 0; run--) {
+                frame[rng() % PAGEWORDS] = rng();
+            }
+            break;
+        case RUNPAGE:
+            /* Short runs make long chunk chains, or a page just too big to store */
+            longest = 2 + (rng() % 31);
+            for (i = 0; i < PAGEWORDS; ) {
+                value = (rng() % 4 == 0) ? 0 : rng();
+                for (run = 1 + (rng() % longest); (run > 0) && (i < PAGEWORDS); run--) {
+                    frame[i++] = value;
+                }
+            }
+            break;
+        case RANDOMPAGE:
+            for (i = 0; i < PAGEWORDS; i++) {
+                frame[i] = rng();
+            }
+            break;
+    }
+}
+
+HIDDEN void copyPage(unsigned int *to, unsigned int *from) {
+    int i;
+
+    for (i = 0; i < PAGEWORDS; i++) {
+        to[i] = from[i];
+    }
+}
+
+/* SYS28, into a static buffer: stack addresses do not fit a 32-bit register */
+HIDDEN void readStats(zswapstat_t *stats, int *hitRate) {
+    static zswapstat_t buffer;
+    state_t state;
+
+    state.s_a1 = (memaddr) (unsigned long) &buffer;
+    getSwapStats(&state, &support);
+    *stats   = buffer;
+    *hitRate = (int) state.s_v0;
+}
+
+/* SYS28's counters must agree with each other and with what the harness did */
+HIDDEN void checkStats(long pageIns) {
+    zswapstat_t stats;
+    int hitRate;
+
+    readStats(&stats, &hitRate);
+    if (stats.zs_chunks == 0) {
+        fail("the tier is off");
+    }
+    if (stats.zs_usedChunks > stats.zs_chunks) {
+        fail("more chunks used than the tier has");
+    }
+    if ((long) (stats.zs_hits + stats.zs_misses) != pageIns) {
+        fail("hits + misses is not the number of page-ins");
+    }
+    if (hitRate != ((pageIns > 0) ? (int) ((stats.zs_hits * 100) / pageIns) : -1)) {
+        fail("SYS28 returned the wrong hit rate");
+    }
+    if (stats.zs_inBytes != stats.zs_stores * PAGESIZE) {
+        fail("zs_inBytes is not a page per store");
+    }
+    if (stats.zs_outBytes > stats.zs_stores * ZMAXWORDS * WORDLEN) {
+        fail("a stored page is larger than ZMAXWORDS");
+    }
+    if ((stats.zs_writebacks > stats.zs_stores) || (stats.zs_writebacks > stats.zs_clusters * ZCLUSTER)) {
+        fail("more write-backs than stores, or clusters over ZCLUSTER");
+    }
+}
+
+/******************************* STAND-INS *****************************/
+
+/* Nucleus calls: getSwapStats's SYS30 / SYS31 on the Swap Pool semaphore */
+unsigned int SYSCALL(unsigned int number, unsigned int arg1, unsigned int arg2, unsigned int arg3) {
+    if (arg1 != (unsigned int) (unsigned long) &swapPoolSemaphore) {
+        fail("SYSCALL on something other than the Swap Pool semaphore");
+    }
+    if (number == SYS30CALL) {
+        poolHeld++;
+    } else if (number == SYS31CALL) {
+        poolHeld--;
+    } else {
+        fail("unexpected SYSCALL");
+    }
+    return 0;
+}
+
+void LDST(void *statep) {
+    if (poolHeld != 0) {
+        fail("getSwapStats returned holding the Swap Pool semaphore");
+    }
+}
+
+/* The harness's buffer is below KUSEG; the kernel would kill the U-Proc, the harness carries on */
+void VMprogramTrapExceptionHandler(support_t *currentSupportStruct) {
+}
+
+void flashLock(int flashNumber) {
+    if (flashHeld[flashNumber]++ != 0) {
+        fail("flash device locked twice");
+    }
+}
+
+void flashUnlock(int flashNumber) {
+    if (--flashHeld[flashNumber] != 0) {
+        fail("flash device unlocked but not held");
+    }
+}
+
+int flashTransfer(int logicalAddress, int flashNumber, int blockNumber, int operation) {
+    unsigned int *page = (unsigned int *) (unsigned long) (memaddr) logicalAddress;
+
+    if (flashHeld[flashNumber] != 1) {
+        fail("flash transfer without holding the device");
+    }
+    if ((flashNumber < 0) || (flashNumber >= FUZZFLASH) || (blockNumber < 0) || (blockNumber >= FUZZBLOCKS)) {
+        fail("flash transfer out of range");
+    }
+    if (rng() % FUZZFAILRATE == 0) {
+        return -5;
+    }
+    if (operation == FLASHWRITE) {
+        copyPage(flash[flashNumber][blockNumber], page);
+    } else {
+        copyPage(page, flash[flashNumber][blockNumber]);
+    }
+    return READY;
+}
+
+int flashOperation(support_t *currentSupportStruct, int logicalAddress, int flashNumber, int blockNumber, int operation) {
+    int status;
+
+    flashLock(flashNumber);
+    status = flashTransfer(logicalAddress, flashNumber, blockNumber, operation);
+    flashUnlock(flashNumber);
+    return status;
+}
+
+void *allocPages(int pageCount) {
+    void *pages;
+
+    if (arenaUsed + pageCount > FUZZFRAMES) {
+        return NULL;
+    }
+    pages = &arena[arenaUsed * PAGESIZE];
+    arenaUsed += pageCount;
+    return pages;
+}
+
+void *allocPage(void) {
+    return allocPages(1);
+}
+
+int freePageCount(void) {
+    return FUZZFRAMES - arenaUsed;
+}
+
+/******************************* OPERATIONS *****************************/
+
+HIDDEN void pageOut(int f, int b) {
+    zswapstat_t before, after;
+    int hitRate, status;
+
+    fillPage(rng() % 4);
+    readStats(&before, &hitRate);
+    status = zswapPageOut(&support, (memaddr) (unsigned long) frame, f, b);
+    readStats(&after, &hitRate);
+
+    /* A failed page-out leaves the page in its frame; the block still reads as before */
+    if (status == READY) {
+        copyPage(model[f][b], frame);
+        purged[f][b] = FALSE;
+    }
+    if ((status == READY) && (after.zs_stores == before.zs_stores) && (after.zs_rejects == before.zs_rejects)) {
+        fail("a page-out was neither stored nor rejected");
+    }
+}
+
+HIDDEN void pageIn(int f, int b, int mustHit) {
+    zswapstat_t before, after;
+    int hitRate, status, i;
+
+    for (i = 0; i < PAGEWORDS; i++) {
+        frame[i] = 0xDEADBEEF;
+    }
+    readStats(&before, &hitRate);
+    status = zswapPageIn(&support, (memaddr) (unsigned long) frame, f, b);
+    readStats(&after, &hitRate);
+
+    if (mustHit && (after.zs_hits == before.zs_hits)) {
+        fail("a just stored page missed");
+    }
+    if (purged[f][b] && (after.zs_hits != before.zs_hits)) {
+        fail("a page of a purged device hit");
+    }
+    if (status != READY) {
+        return;
+    }
+    for (i = 0; i < PAGEWORDS; i++) {
+        if (frame[i] != model[f][b][i]) {
+            fprintf(stderr, "zswapfuzz: step %ld: device %d block %d word %d: got %08x, expected %08x\n",
+                    step, f, b, i, frame[i], model[f][b][i]);
+            exit(1);
+        }
+    }
+}
+
+/* The device gets a new address space: its blocks read back as flash holds them */
+HIDDEN void purge(int f) {
+    int b;
+
+    zswapPurge(f);
+    for (b = 0; b < FUZZBLOCKS; b++) {
+        copyPage(model[f][b], flash[f][b]);
+        purged[f][b] = TRUE;
+    }
+}
+
+/******************************* MAIN *****************************/
+
+int main(int argc, char *argv[]) {
+    long steps = (argc > 1) ? atol(argv[1]) : 200000;
+    long pageIns = 0;
+    zswapstat_t stats;
+    unsigned int stored;
+    int op, f, b, hitRate;
+
+    rngState = (argc > 2) ? (unsigned int) atoi(argv[2]) : 0x2545F491;
+    if (rngState == 0) {
+        rngState = 1;
+    }
+
+    initZswap();
+    for (step = 0; step < steps; step++) {
+        op = rng() % 100;
+        f = rng() % FUZZFLASH;
+        b = rng() % FUZZBLOCKS;
+        if (op < 50) {
+            readStats(&stats, &hitRate);
+            stored = stats.zs_stores;
+            pageOut(f, b);
+            readStats(&stats, &hitRate);
+            if ((stats.zs_stores != stored) && (rng() % 4 == 0)) {
+                pageIn(f, b, TRUE);
+                pageIns++;
+            }
+        } else if (op < 99) {
+            pageIn(f, b, FALSE);
+            pageIns++;
+        } else {
+            purge(f);
+        }
+        checkStats(pageIns);
+    }
+
+    /* Every block must still read back as the model expects */
+    for (f = 0; f < FUZZFLASH; f++) {
+        for (b = 0; b < FUZZBLOCKS; b++) {
+            pageIn(f, b, FALSE);
+            pageIns++;
+        }
+    }
+    checkStats(pageIns);
+
+    readStats(&stats, &hitRate);
+    printf("zswapfuzz: %ld steps ok: %u stores, %u rejects, %u write-backs in %u clusters, "
+           "hit rate %d%%, ratio %u.%02u\n",
+           steps, stats.zs_stores, stats.zs_rejects, stats.zs_writebacks, stats.zs_clusters, hitRate,
+           stats.zs_inBytes / stats.zs_outBytes, ((stats.zs_inBytes % stats.zs_outBytes) * 100) / stats.zs_outBytes);
+    return 0;
+}
@@ -11,23 +11,36 @@
  * Invariant:
  * - The ASL maintains a sorted list of active semaphores, sorted in 
  *   ascending order of addresses, along with a dummy head and a dummy tail.
- * - Each semaphore descriptor maintains a pointer to the next semaphore descriptor
- *   and a pointer to the process queue associated with the semaphore.
- * - All unused semaphore descriptors are maintained in the semdFree list.
+ * - Each semaphore descriptor maintains pointers to the next and previous
+ *   semaphore descriptors and a pointer to the process queue associated with
+ *   the semaphore.
+ * - A blocked pcb's p_queue points at its descriptor's s_procQ, which is the
+ *   descriptor's first field; outBlocked therefore finds the descriptor, and
+ *   unlinks it from the ASL, without searching. Building with -DQMDEBUG also
+ *   searches the ASL to confirm the descriptor is active.
+ * - A pcb's p_semAdd is non-NULL exactly while it is blocked on the ASL.
+ * - Semaphore descriptors (including the dummies) come from a slab cache and
+ *   are returned to it as soon as their process queue empties.
  * 
  *****************************************************************************/
 
 #include "../h/pcb.h"
 #include "../h/const.h"
 #include "../h/asl.h"
+#include "../h/slab.h"
+#ifdef QMDEBUG
+#ifndef PANIC
+#include "/usr/include/umps3/umps/libumps.h"
+#endif
+#endif
 
 /******************************* GLOBAL VARIABLES *****************************/
 
 /* Head pointer for the active semaphore list */
 HIDDEN semd_t *semd_h;
 
-/* Head pointer for the free semaphore list */
-HIDDEN semd_t *semdFree_h;
+/* Slab cache the semaphore descriptors are allocated from */
+HIDDEN slab_t semdCache;
 
 /******************************* HELPER FUNCTIONS *****************************/
 
@@ -56,54 +69,89 @@ HIDDEN semd_PTR findSemaphore(int *semAdd) {
     return previous; /* Return a pointer to the semd that precedes current */
 }
 
+/*
+ * Function    : releaseSemaphore
+ * Purpose     : Unlink a descriptor whose process queue has emptied from the ASL
+ *               and return it to the semaphore cache.
+ * Parameters  : semd - pointer to the semaphore descriptor
+ */
+HIDDEN void releaseSemaphore(semd_PTR semd) {
+    semd->s_prev->s_next = semd->s_next;
+    semd->s_next->s_prev = semd->s_prev;
+    slabFree(&semdCache, semd);
+}
+
 /******************************* SEMAPHORE MANAGEMENT *****************************/
 
-/* 
- * Function     : insertBlocked
- * Purpose      : Insert the pcb pointed to by p at the tail of the process queue as-
- *                sociated with the semaphore whose physical address is semAdd and
- *                set the semaphore address of p to semAdd. If the semaphore is cur-
- *                rently not active, allocate a new descriptor from the semdFree list,
- *                insert it in the ASL, initialize all of the fields, and proceed as above.
- *                If a new semaphore descriptor needs to be allocated and the semdFree
- *                list is empty, return TRUE. In all other cases return FALSE.
+/*
+ * Function     : blockOn
+ * Purpose      : Common body of insertBlocked and insertBlockedPrio: find or allocate
+ *                semAdd's descriptor as described below, and add p to its process
+ *                queue with insert.
  * Parameters   : semAdd - pointer to the semaphore
  *                p      - pointer to the pcb to be inserted
+ *                insert - insertProcQ (FIFO) or insertPrioQ (priority order)
  */
-int insertBlocked(int *semAdd, pcb_PTR p) {
+HIDDEN int blockOn(int *semAdd, pcb_PTR p, void (*insert)(pcb_PTR *, pcb_PTR)) {
     semd_PTR prev = findSemaphore(semAdd);
     semd_PTR curr = prev->s_next;
     
     if (curr->s_semAdd != semAdd) {
         /* If the semaphore is not currently active */
-        semd_PTR newSemd = semdFree_h;
+        semd_PTR newSemd = slabAlloc(&semdCache);
 
         if (newSemd == NULL) 
-            return TRUE;  /* semdFree list is empty */
-
-        /* Remove newSemd from the free list */
-        semdFree_h = newSemd->s_next;  
+            return TRUE;  /* RAM for another descriptor is exhausted */
 
         /* Initialize new semaphore descriptor*/
         newSemd->s_semAdd = semAdd;
         newSemd->s_procQ = mkEmptyProcQ();
 
         /* Insert p into the process queue of newSemd */
-        insertProcQ(&(newSemd->s_procQ), p);
+        insert(&(newSemd->s_procQ), p);
         p->p_semAdd = semAdd;
 
         /* Insert newSemd into the ASL */
         newSemd->s_next = curr;
+        newSemd->s_prev = prev;
+        curr->s_prev = newSemd;
         prev->s_next = newSemd;
         return FALSE;
     } else {
         /* If the semaphore is already in ASL */
-        insertProcQ(&(curr->s_procQ), p);
+        insert(&(curr->s_procQ), p);
         p->p_semAdd = semAdd;
         return FALSE;
     }
 }
 
+/* 
+ * Function     : insertBlocked
+ * Purpose      : Insert the pcb pointed to by p at the tail of the process queue as-
+ *                sociated with the semaphore whose physical address is semAdd and
+ *                set the semaphore address of p to semAdd. If the semaphore is cur-
+ *                rently not active, allocate a new descriptor from the semaphore cache,
+ *                insert it in the ASL, initialize all of the fields, and proceed as above.
+ *                If a new semaphore descriptor needs to be allocated and RAM for it
+ *                is exhausted, return TRUE. In all other cases return FALSE.
+ * Parameters   : semAdd - pointer to the semaphore
+ *                p      - pointer to the pcb to be inserted
+ */
+int insertBlocked(int *semAdd, pcb_PTR p) {
+    return blockOn(semAdd, p, insertProcQ);
+}
+
+/* 
+ * Function     : insertBlockedPrio
+ * Purpose      : As insertBlocked, but p is queued behind every waiter of at least its
+ *                priority rather than at the tail (see insertPrioQ). Used for mutexes.
+ * Parameters   : semAdd - pointer to the semaphore
+ *                p      - pointer to the pcb to be inserted
+ */
+int insertBlockedPrio(int *semAdd, pcb_PTR p) {
+    return blockOn(semAdd, p, insertPrioQ);
+}
+
 /*
  * Function    : removeBlocked
  * Purpose     : Search the ASL for a descriptor of this semaphore. If none is found,
@@ -111,7 +159,7 @@ int insertBlocked(int *semAdd, pcb_PTR p) {
  *               cess queue of the found semaphore descriptor, set that pcb's address
  *               to NULL, and return a pointer to it. If the process queue for this
  *               semaphore becomes empty, remove the semaphore descriptor from the ASL
- *               and return it to the semdFree list.
+ *               and return it to the semaphore cache.
  * Parameters  : semAdd - pointer to the semaphore
  */
 pcb_PTR removeBlocked(int *semAdd) {
@@ -127,9 +175,7 @@ pcb_PTR removeBlocked(int *semAdd) {
 
     if (emptyProcQ(current->s_procQ)) {
         /* Remove the semaphore from ASL */ 
-        prev->s_next = current->s_next;
-        current->s_next = semdFree_h;
-        semdFree_h = current;
+        releaseSemaphore(current);
     }
 
     return removedPcb;
@@ -137,33 +183,36 @@ pcb_PTR removeBlocked(int *semAdd) {
 
 /* 
  * Function    : outBlocked
- * Purpose     : Search the ASL for a descriptor of this semaphore. If none is found,
- *               return NULL; otherwise, remove the first pcb from the process queue
- *               of the found semaphore descriptor, set that pcb's address to NULL, 
- *               and return a pointer to it. If the process queue for this semaphore
- *               becomes empty, remove the semaphore descriptor from the ASL and
- *               return it to the semdFree list.
+ * Purpose     : Remove the pcb pointed to by p from the process queue associated
+ *               with p's semaphore on the ASL, set that pcb's semaphore address to
+ *               NULL, and return p. If p is not blocked, return NULL. If the process
+ *               queue for this semaphore becomes empty, remove the semaphore
+ *               descriptor from the ASL and return it to the semaphore cache.
+ *               p_queue leads straight to the descriptor, so this is constant-time.
  * Parameters  : p - pointer to the pcb to be removed
  */
 pcb_PTR outBlocked(pcb_PTR p) {
-    if (p == NULL || p->p_semAdd == NULL) return NULL;  /* Invalid input */ 
+    semd_PTR current;
 
-    semd_PTR prev = findSemaphore(p->p_semAdd);
-    if (prev == NULL || prev->s_next == NULL || prev->s_next->s_semAdd != p->p_semAdd) 
-        return NULL;  /* Semaphore not found */ 
-    
-    semd_PTR current = prev->s_next;
-    pcb_PTR removedPcb = outProcQ(&current->s_procQ, p);
+    if (p == NULL || p->p_semAdd == NULL || p->p_queue == NULL) 
+        return NULL;    /* p is not blocked */ 
 
-    if (removedPcb == NULL) return NULL;  /* PCB not found in the queue */ 
+    /* s_procQ is the descriptor's first field, so p_queue addresses the descriptor */
+    current = (semd_PTR) p->p_queue;
+
+#ifdef QMDEBUG
+    if (current->s_semAdd != p->p_semAdd || findSemaphore(p->p_semAdd)->s_next != current)
+        PANIC();        /* p_queue and p_semAdd disagree with the ASL */
+#endif
+
+    outProcQ(&current->s_procQ, p);
+    p->p_semAdd = NULL;
 
     if (emptyProcQ(current->s_procQ)) {
         /* Remove semaphore if its queue is now empty */
-        prev->s_next = current->s_next;
-        current->s_next = semdFree_h;
-        semdFree_h = current;
+        releaseSemaphore(current);
     }
-    return removedPcb;
+    return p;
 }
 
 /* 
@@ -184,31 +233,25 @@ pcb_PTR headBlocked(int *semAdd) {
 
 /*
  * Function    : initASL
- * Purpose     : Initialize the semdFree list to contain all the elements of the array
- *               static semd_t semdTable[MAXPROC + 2]. This method will be called only
- *               once during data structure initialization.
+ * Purpose     : Initialize the (empty) semaphore cache and allocate the dummy head
+ *               and tail of the ASL from it. This method will be called only once
+ *               during data structure initialization, after initMemory().
  * Parameters  : None
  */
 void initASL() {
-    int i;
-    static semd_t semdTable[MAXPROC + 2];
-
-    semdFree_h = NULL;
-    for (i = 0; i < MAXPROC; i++) {
-        semdTable[i].s_next = semdFree_h;
-        semdTable[i].s_procQ = mkEmptyProcQ(); 
-        semdFree_h = &semdTable[i];
-    }
+    slabInit(&semdCache, sizeof(semd_t), WORDLEN);
 
     /* Initialize the dummy head and tail nodes */ 
-    semd_h = &semdTable[MAXPROC];               
+    semd_h = slabAlloc(&semdCache);               
     semd_h->s_semAdd = (int *)0;
     semd_h->s_procQ = NULL;
-    semd_h->s_next = &semdTable[MAXPROC + 1]; 
+    semd_h->s_prev = NULL;
+    semd_h->s_next = slabAlloc(&semdCache); 
 
     semd_h->s_next->s_semAdd = (int *)MAXINT;
     semd_h->s_next->s_procQ = NULL;
     semd_h->s_next->s_next = NULL;
+    semd_h->s_next->s_prev = semd_h;
 }
 
 /******************************* END OF ASL.c *****************************/
@@ -5,11 +5,12 @@
  * List (ADL) sorted by the wake up time and then blocked on its private semaphore. 
  * The Delay Daemon will periodically wake every 100 milliseconds to check the ADL, 
  * unblock any processes whose delay time has expired, and recylces their descriptors
- * back to the free list. The ADL is protected by a semaphore to ensure mutual exclusion
+ * back to their cache. The ADL is protected by a semaphore to ensure mutual exclusion
  * between the Delay Daemon and any user processes that may be modifying the list.
+ * On each wake-up the Delay Daemon also runs the Swap Pool's load controller.
  * 
  * Written by  : Uyen Nguyen
- * Last update : 2025/05/09
+ * Last update : 2025/06/08
  * 
  ***********************************************************************************/
 
@@ -17,45 +18,41 @@
 #include "../h/types.h"
 #include "../h/sysSupport.h"
 #include "../h/delayDaemon.h"
+#include "../h/slab.h"
+#include "../h/loadControl.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /******************************* GLOBAL VARIABLES *****************************/
 
-/* Semphore for mutual exclusion on the Active Delay List (ADL) */
-HIDDEN int ADLsemaphore = 1;                /* For mutual exclusion */                    
+/* Mutex for mutual exclusion on the Active Delay List (ADL) */
+HIDDEN mutex_t ADLsemaphore = {MUTEXFREE, NULL, NULL};     /* For mutual exclusion */                    
 
 /* Head pointer for the Active Delay List */
 HIDDEN delayd_t *delayd_h;
 
-/* Head pointer for the free list of delay descriptors */
-HIDDEN delayd_t *delaydFree_h;
-
-/* Static table of delay descriptors */
-HIDDEN delayd_t delayEvents[UPROCMAX + 2];  /* +2 for dummy head & tail */ 
+/* Slab cache the delay descriptors (and the ADL dummies) are allocated from */
+HIDDEN slab_t delaydCache;
 
 /******************************* ADL UTILITY FUNCTIONS *****************************/
 
 /*
  * Function     :   allocateDelayd
- * Purpose      :   Allocate a delay descriptor from the free list. It will pop the first
- *                  descriptor from the free list (delaydFree_h) and initialize it.
+ * Purpose      :   Allocate a delay descriptor from the delay descriptor cache and
+ *                  initialize it.
  *                  The new descriptor will be initialized with a wake time of 0 and
  *                  a support structure pointer of NULL.
  * Parameters   :   None
  * Returns      :   Pointer to the allocated delay descriptor, 
- *                  or NULL if no free descriptors are available.
+ *                  or NULL if RAM for another descriptor is exhausted.
  */
 HIDDEN delayd_t *allocateDelayd(void) {
-    /* Check if the free list is empty */
-    if (delaydFree_h == NULL) {
+    /* Take a descriptor from the cache */
+    delayd_t *newNode = slabAlloc(&delaydCache);
+    if (newNode == NULL) {
         /* If no delay descriptor available, return NULL */
         return NULL;  
     }
 
-    /* Else, pop the first descriptor from the free list */
-    delayd_t *newNode = delaydFree_h;
-    delaydFree_h = delaydFree_h->d_next;        /* Advance the free head */
-
     /* Initialize the new delay descriptor */
     newNode->d_next      = NULL;
     newNode->d_wakeTime  = 0;
@@ -67,14 +64,12 @@ HIDDEN delayd_t *allocateDelayd(void) {
 
 /*
  * Function     :   freeDelayd
- * Purpose      :   Free a delay descriptor by pushing it back onto the free list.
+ * Purpose      :   Free a delay descriptor by returning it to the delay descriptor cache.
  * Parameters   :   node - pointer to the delay descriptor to be freed
  * Returns      :   None
  */
 HIDDEN void freeDelayd(delayd_t *node) {
-    /* Push the node back onto the free list */
-    node->d_next = delaydFree_h;
-    delaydFree_h = node;                        /* Update the head accordingly */
+    slabFree(&delaydCache, node);
 }
 
 /*
@@ -105,7 +100,7 @@ HIDDEN void insertDelayd(delayd_t *newNode) {
 /*
  * Function     :   initADL
  * Purpose      :   Initialize the Active Delay List (ADL) and set up the Delay Daemon.
- *                  This function sets up the free list of delay descriptors, initializes
+ *                  This function sets up the delay descriptor cache, initializes
  *                  the dummy head and tail of the ADL, and creates the Delay Daemon process.
  * Parameters   :   None
  * Returns      :   None
@@ -114,26 +109,20 @@ void initADL(void) {
     /* Local variable declarations */
     state_t initialState;                       
 
-    /* Set up the ADL dummy head (node 0) */
-    delayd_h = &(delayEvents[0]);
+    /* Set up the delay descriptor cache */
+    slabInit(&delaydCache, sizeof(delayd_t), WORDLEN);
+
+    /* Set up the ADL dummy head */
+    delayd_h = slabAlloc(&delaydCache);
     delayd_h->d_wakeTime  = 0;
     delayd_h->d_supStruct = NULL;
-    delayd_h->d_next      = &(delayEvents[UPROCMAX + 1]);   /* Point to the dummy tail */
+    delayd_h->d_next      = slabAlloc(&delaydCache);        /* Point to the dummy tail */
 
-    /* Set up the ADL dummy tail (node UPROCMAX + 1) */
+    /* Set up the ADL dummy tail */
     delayd_h->d_next->d_wakeTime  = INFINITE;               /* This will never wake */
     delayd_h->d_next->d_supStruct = NULL;   
     delayd_h->d_next->d_next      = NULL;                   /* No next node */                  
 
-    /* Build the free list of delay descriptors */
-    delaydFree_h = &(delayEvents[1]);    /* The first node in the free list */
-
-    int i;
-    for (i = 1; i < UPROCMAX; i++) {
-        delayEvents[i].d_next = &(delayEvents[i + 1]);
-    }
-    delayEvents[UPROCMAX].d_next = NULL; /* Last node in the free list */
-
     /* Calculate ramtop to then get the penultimate frame for Delay Daemon's SP */
     devregarea_t *devRegArea = (devregarea_t *) RAMBASEADDR;
     memaddr ramTop = devRegArea->rambase + devRegArea->ramsize;
@@ -160,7 +149,7 @@ void initADL(void) {
  * Purpose      :   The Delay Daemon process. It periodically wakes up every 100 milliseconds
  *                  to check the Active Delay List (ADL) for any processes that need to be woken.
  *                  It will unblock those processes and recycle their delay descriptors back
- *                  to the free list.
+ *                  to their cache.
  * Parameters   :   None
  * Returns      :   None 
  */
@@ -173,7 +162,7 @@ void delayDaemon(void) {
         SYSCALL(SYS7CALL, 0, 0, 0); 
 
         /* Obtain mutual exclusion over the ADL */
-        SYSCALL(SYS3CALL, (unsigned int) &ADLsemaphore, 0, 0);
+        SYSCALL(SYS30CALL, (unsigned int) &ADLsemaphore, 0, 0);
 
         /* Get the current time */
         STCK(timeNow);
@@ -187,14 +176,17 @@ void delayDaemon(void) {
             /* Remove the descriptor from the ADL */
             delayd_h->d_next = curr->d_next; 
             
-            /* Recylce the descriptor back to the free pool */
+            /* Recylce the descriptor back to its cache */
             freeDelayd(curr);              
 
             /* Move to next descriptor to continue to check */
             curr = delayd_h->d_next;        
         }
         /* Release mutual exclusion over the ADL */
-        SYSCALL(SYS4CALL, (unsigned int) &ADLsemaphore, 0, 0);
+        SYSCALL(SYS31CALL, (unsigned int) &ADLsemaphore, 0, 0);
+
+        /* Let the load controller resume U-Procs even when no one is faulting */
+        loadTick();
     }
 }
 
@@ -222,15 +214,15 @@ void delay(support_t *currentSupportStruct) {
     }
 
     /* Obtain mutual exclusion over the ADL */
-    SYSCALL(SYS3CALL, (unsigned int) &ADLsemaphore, 0, 0);  
+    SYSCALL(SYS30CALL, (unsigned int) &ADLsemaphore, 0, 0);  
 
-    /* Allocate a delay descriptor from the free list */
+    /* Allocate a delay descriptor from its cache */
     delayd_t *delayd  = allocateDelayd();
 
     /* Check if the allocation was successful */
     if (delayd == NULL) { 
         /* If not, first release the lock on ADL semaphore */
-        SYSCALL(SYS4CALL, (unsigned int) &ADLsemaphore, 0, 0);
+        SYSCALL(SYS31CALL, (unsigned int) &ADLsemaphore, 0, 0);
 
         /* Then, call SYS9 to terminate the process */
         SYSCALL(SYS9CALL, 0, 0, 0);
@@ -248,7 +240,7 @@ void delay(support_t *currentSupportStruct) {
     setSTATUS(getSTATUS() & IECOFF);
 
     /* Release the ADL semaphore */
-    SYSCALL(SYS4CALL, (unsigned int) &ADLsemaphore, 0, 0);
+    SYSCALL(SYS31CALL, (unsigned int) &ADLsemaphore, 0, 0);
 
     /* Block process on its private semaphore until woken by daemon */
     SYSCALL(SYS3CALL, (unsigned int) &(currentSupportStruct->sup_privateSemaphore), 0, 0);
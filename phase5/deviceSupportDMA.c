@@ -3,10 +3,12 @@
  * This module implements disk and flash operation for U-procs using DMA support.
  * It provides routines to read and write sectors/blocks via device registers,
  * including copying data to/from the DMA buffer, CHS conversion, and automic
- * command execution with interrupts disabled.
+ * command execution with interrupts disabled. A flash device can also be held
+ * across several transfers (flashLock / flashTransfer / flashUnlock), which the
+ * compressed swap tier uses to write back a batch of pages.
  * 
  * Written by  : Uyen Nguyen
- * Last update : 2025/05/10
+ * Last update : 2025/06/09
  * 
  ***********************************************************************************/
 
@@ -17,6 +19,7 @@
 #include "../h/vmSupport.h"
 #include "../h/sysSupport.h"
 #include "../h/deviceSupportDMA.h"
+#include "../h/smp.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /******************************* DISK OPERATIONS *****************************/
@@ -60,7 +63,7 @@ void diskPut(support_t *currentSupportStruct) {
     }
 
     /* Gain mutual exclusion over the device's device register */
-    SYSCALL(SYS3CALL, (unsigned int) &devSemaphores[diskNumber], 0, 0);
+    SYSCALL(SYS30CALL, (unsigned int) &devSemaphores[diskNumber], 0, 0);
 
     /* Covert sector number to CHS */
     int cylinder = sectionNumber / (maxHead * maxSector);
@@ -68,8 +71,8 @@ void diskPut(support_t *currentSupportStruct) {
     int head     = temp / maxSector;
     int sector   = temp % maxSector;
 
-    /* Disable interrupts for atomic operations: COMMAND + SYS5 */
-    setSTATUS(getSTATUS() & IECOFF);
+    /* Disable interrupts (and hold the kernel lock) for atomic operations: COMMAND + SYS5 */
+    lockNucleus();
 
     /* Place the cylinder number and SEEK command in disk's COMMAND field */
     devRegArea->devreg[diskNumber].d_command = (cylinder << CYLNUMSHIFT) | SEEKCYL;
@@ -78,15 +81,15 @@ void diskPut(support_t *currentSupportStruct) {
     int status = SYSCALL(SYS5CALL, DISKINT, diskNumber, FALSE);
 
     /* Re-enable interrupts now that the atomic operation is complete */
-    setSTATUS(getSTATUS() | IECON);
+    unlockNucleus(IECON);
 
     /* If the seek device was successful, WRITEBLK with new DMA buffer address */
     if (status == SUCCESS) {
         /* Write the starting address of the DMA buffer in the device's DATA0 field */
         devRegArea->devreg[diskNumber].d_data0 = (unsigned int) dmaBufferAddress;
 
-        /* Disable interrupts for atomic operations: COMMAND + SYS5 */
-        setSTATUS(getSTATUS() & IECOFF);
+        /* Disable interrupts (and hold the kernel lock) for atomic operations: COMMAND + SYS5 */
+        lockNucleus();
 
         /* Place the head number, section number, and READBLK command in disk's COMMAND field */
         devRegArea->devreg[diskNumber].d_command = (head << HEADNUMSHIFT) | (sector << SECTORNUMSHIFT) | DISKWRITEBLK;
@@ -95,11 +98,11 @@ void diskPut(support_t *currentSupportStruct) {
         status = SYSCALL(SYS5CALL, DISKINT, diskNumber, FALSE);
     
         /* Re-enable interrupts now that the atomic operation is complete */
-        setSTATUS(getSTATUS() | IECON);
+        unlockNucleus(IECON);
     } 
 
     /* Release mutual exclusion over the device's device register */
-    SYSCALL(SYS4CALL, (unsigned int) &devSemaphores[diskNumber], 0, 0);
+    SYSCALL(SYS31CALL, (unsigned int) &devSemaphores[diskNumber], 0, 0);
 
     /* If any of the operation was unsuccessful */
     if (status != SUCCESS) {
@@ -147,7 +150,7 @@ void diskGet(support_t *currentSupportStruct) {
     memaddr *dmaBufferAddress = (memaddr *) (DISKSTART + (diskNumber * PAGESIZE));
 
     /* Gain mutual exclusion over the device's device register */
-    SYSCALL(SYS3CALL, (unsigned int) &devSemaphores[diskNumber], 0, 0);
+    SYSCALL(SYS30CALL, (unsigned int) &devSemaphores[diskNumber], 0, 0);
 
     /* Covert linear sector number to CHS components */
     int cylinder = sectionNumber / (maxHead * maxSector);
@@ -155,8 +158,8 @@ void diskGet(support_t *currentSupportStruct) {
     int head     = temp / maxSector;
     int sector   = temp % maxSector;
 
-    /* Disable interrupts for atomic operations: COMMAND + SYS5 */
-    setSTATUS(getSTATUS() & IECOFF);
+    /* Disable interrupts (and hold the kernel lock) for atomic operations: COMMAND + SYS5 */
+    lockNucleus();
 
     /* Place the cylinder number and SEEK command in disk's COMMAND field */
     devRegArea->devreg[diskNumber].d_command = (cylinder << CYLNUMSHIFT) | SEEKCYL;
@@ -165,15 +168,15 @@ void diskGet(support_t *currentSupportStruct) {
     int status = SYSCALL(SYS5CALL, DISKINT, diskNumber, FALSE);
 
     /* Re-enable interrupts now that the atomic operation is complete */
-    setSTATUS(getSTATUS() | IECON);
+    unlockNucleus(IECON);
 
     /* If the seek device was successful, continue with the read operation */
     if (status == SUCCESS) {
         /* Write the starting address of the DMA buffer in the device's DATA0 field */
         devRegArea->devreg[diskNumber].d_data0 = (unsigned int) dmaBufferAddress;
 
-        /* Disable interrupts for atomic operations: COMMAND + SYS5 */
-        setSTATUS(getSTATUS() & IECOFF);
+        /* Disable interrupts (and hold the kernel lock) for atomic operations: COMMAND + SYS5 */
+        lockNucleus();
 
         /* Place the head number, section number, and READBLK command in disk's COMMAND field */
         devRegArea->devreg[diskNumber].d_command = (head << HEADNUMSHIFT) | (sector << SECTORNUMSHIFT) | DISKREADBLK;
@@ -182,11 +185,11 @@ void diskGet(support_t *currentSupportStruct) {
         status = SYSCALL(SYS5CALL, DISKINT, diskNumber, FALSE);
     
         /* Re-enable interrupts now that the atomic operation is complete */
-        setSTATUS(getSTATUS() | IECON);
+        unlockNucleus(IECON);
     }
 
     /* Release mutual exclusion over the device's device register */
-    SYSCALL(SYS4CALL, (unsigned int) &devSemaphores[diskNumber], 0, 0);
+    SYSCALL(SYS31CALL, (unsigned int) &devSemaphores[diskNumber], 0, 0);
 
     /* If the disk read operation was successful */
     if (status == SUCCESS) {
@@ -209,42 +212,74 @@ void diskGet(support_t *currentSupportStruct) {
 /******************************* FLASH OPERATIONS *****************************/
 
 /*
- * Function     :   flashOperation
- * Purpose      :   Perform a flash operation (read or write) on the specified
- *                  flash device. This includes checking the validity of the parameters,
- *                  gaining mutual exclusion over the device's device register, executing
- *                  the command, and releasing the device semaphore.
- * Parameters   :   currentSupportStruct - pointer to the support structure
- *                  logicalAddress - address of the data to be read/written
+ * Function     :   flashBlockValid
+ * Purpose      :   Check a block number against a flash device's size
+ * Parameters   :   flashNumber - number of the flash device
+ *                  blockNumber - block number to read/write
+ * Returns      :   TRUE if the device has the block, FALSE otherwise
+ */
+int flashBlockValid(int flashNumber, int blockNumber) {
+    /* Pointer to the device register area */
+    devregarea_t *devRegArea = (devregarea_t *) RAMBASEADDR;
+
+    /* Retrieve the maximum number of blocks for the device */
+    int maxBlock = devRegArea->devreg[((FLASHINT - OFFSET) * DEVPERINT) + flashNumber].d_data1;
+
+    return (blockNumber >= 0) && (blockNumber < maxBlock);
+}
+
+/*
+ * Function     :   flashLock
+ * Purpose      :   Gain mutual exclusion over a flash device's device register, so that
+ *                  several flashTransfer calls can be issued back to back
+ * Parameters   :   flashNumber - number of the flash device
+ * Returns      :   None
+ */
+void flashLock(int flashNumber) {
+    SYSCALL(SYS30CALL, (unsigned int) &devSemaphores[((FLASHINT - OFFSET) * DEVPERINT) + flashNumber], 0, 0);
+}
+
+/*
+ * Function     :   flashUnlock
+ * Purpose      :   Release a flash device taken with flashLock
+ * Parameters   :   flashNumber - number of the flash device
+ * Returns      :   None
+ */
+void flashUnlock(int flashNumber) {
+    SYSCALL(SYS31CALL, (unsigned int) &devSemaphores[((FLASHINT - OFFSET) * DEVPERINT) + flashNumber], 0, 0);
+}
+
+/*
+ * Function     :   flashTransfer
+ * Purpose      :   Perform a flash operation (read or write) on a flash device whose
+ *                  device semaphore the caller holds. This includes checking the
+ *                  validity of the block number and executing the command.
+ * Parameters   :   logicalAddress - address of the data to be read/written
  *                  flashNumber - number of the flash device
  *                  blockNumber - block number to read/write
  *                  operation - operation to perform (read or write)
- * Returns      :   status - status code indicating success or failure
+ * Returns      :   status - status code indicating success or failure; BADBLOCKSTATUS
+ *                  for a block past the device's end. Terminating here would leave
+ *                  the device held, so callers terminate a U-Proc for a bad block
+ *                  before taking the device (flashBlockValid)
  */
-int flashOperation(support_t *currentSupportStruct, int logicalAddress, int flashNumber, int blockNumber, int operation) {
+int flashTransfer(int logicalAddress, int flashNumber, int blockNumber, int operation) {
     /* Pointer to the device register area */
     devregarea_t *devRegArea = (devregarea_t *) RAMBASEADDR;
 
     /* Compute the index into the device register array */
     int flashIndex = ((FLASHINT - OFFSET) * DEVPERINT) + flashNumber;
 
-    /* Retrieve the maximum number of blocks for the device */
-    int maxBlock = devRegArea->devreg[flashIndex].d_data1;
-
-    /* Defensive check: Check for blocknumber */
-    if ((blockNumber < 0) || (blockNumber >= maxBlock)) {
-        /* Terminate the U-proc on bad arguments */
-        SYSCALL(SYS9CALL, 0, 0, 0); 
+    /* Defensive check: the caller holds the device, so report a bad block rather than terminate */
+    if (!flashBlockValid(flashNumber, blockNumber)) {
+        return BADBLOCKSTATUS;
     }
 
-    /* Gain mutual exclusive over the device's device register */
-    SYSCALL(SYS3CALL, (unsigned int) &devSemaphores[flashIndex], 0, 0);
-
     /* Write the frame's starting address into device's DATA0 field */
     devRegArea->devreg[flashIndex].d_data0 = logicalAddress;
 
-    /* Disable interrupt so that COMMAND + SYS5 is atomic */
-    setSTATUS(getSTATUS() & IECOFF);
+    /* Disable interrupts (and hold the kernel lock) so that COMMAND + SYS5 is atomic */
+    lockNucleus();
 
     /* If the operation requested a READ operation */
     if (operation == FLASHREAD) {
@@ -259,10 +294,7 @@ int flashOperation(support_t *currentSupportStruct, int logicalAddress, int flas
     int status = SYSCALL(SYS5CALL, FLASHINT, flashNumber, operation);
 
     /* Re-enable interrupts now that the atomic operation is complete */
-    setSTATUS(getSTATUS() | IECON);
-
-    /* Release the device semaphore */
-    SYSCALL(SYS4CALL, (unsigned int) &devSemaphores[flashIndex], 0, 0);
+    unlockNucleus(IECON);
 
     /* Check the status code to see if an error occurred */
     if (status != READY) {
@@ -274,6 +306,41 @@ int flashOperation(support_t *currentSupportStruct, int logicalAddress, int flas
     return status;
 }
 
+/*
+ * Function     :   flashOperation
+ * Purpose      :   Perform a flash operation (read or write) on the specified
+ *                  flash device. This includes checking the validity of the block
+ *                  number, gaining mutual exclusion over the device's device
+ *                  register, executing the command (flashTransfer), and releasing
+ *                  the device semaphore.
+ * Parameters   :   currentSupportStruct - pointer to the support structure
+ *                  logicalAddress - address of the data to be read/written
+ *                  flashNumber - number of the flash device
+ *                  blockNumber - block number to read/write
+ *                  operation - operation to perform (read or write)
+ * Returns      :   status - status code indicating success or failure
+ */
+int flashOperation(support_t *currentSupportStruct, int logicalAddress, int flashNumber, int blockNumber, int operation) {
+    int status;
+
+    /* Defensive check: Check for blocknumber, before the device is held */
+    if (!flashBlockValid(flashNumber, blockNumber)) {
+        /* Terminate the U-proc on bad arguments */
+        SYSCALL(SYS9CALL, 0, 0, 0);
+    }
+
+    /* Gain mutual exclusive over the device's device register */
+    flashLock(flashNumber);
+
+    /* Execute the command */
+    status = flashTransfer(logicalAddress, flashNumber, blockNumber, operation);
+
+    /* Release the device semaphore */
+    flashUnlock(flashNumber);
+
+    return status;
+}
+
 /*
  * Function     :   flashPut
  * Purpose      :   Write a page from user memory into a flash block via DMA.
@@ -10,7 +10,9 @@
  * system calls (code 8) it calls syscallExceptionHandler; and for all other cases 
  * (program traps) it calls programTrapExceptionHandler. For system calls, the module 
  * further dispatches to routines such as createProcess, terminateProcess, passeren, 
- * verhogen, waitForIODevice, getCPUTime, waitForClock, and getSupportData. When a 
+ * verhogen, waitForIODevice, getCPUTime, waitForClock, getSupportData, the
+ * priority-inheritance mutex services lockMutex and unlockMutex, setTickets, and the
+ * real-time services setRealTime and getDeadlineMisses. When a 
  * process has installed a support structure, the “pass up or die” mechanism is used 
  * to either transfer control to a user-level exception handler or terminate the process 
  * if no handler is available. Additionally, CPU time is accounted for via external 
@@ -30,6 +32,11 @@
 #include "../h/exceptions.h"
 #include "../h/interrupts.h"
 #include "../h/initial.h"
+#include "../h/trace.h"
+#include "../h/utilization.h"
+#include "../h/fairShare.h"
+#include "../h/realTime.h"
+#include "../h/smp.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /******************************* FUNCTION DECLARATION *******************************/ 
@@ -39,9 +46,21 @@ HIDDEN void terminateProcess(pcb_PTR proc);
 HIDDEN void passeren(int *semAdd);
 HIDDEN void verhogen(int *semAdd);
 HIDDEN void waitForIODevice(int lineNum, int deviceNum, int readBoolean);
-HIDDEN void getCPUTime();
+HIDDEN void getCPUTime(state_PTR resumeState);
 HIDDEN void waitForClock();
-HIDDEN void getSupportData();
+HIDDEN void getSupportData(state_PTR resumeState);
+HIDDEN void lockMutex(mutex_t *mutex);
+HIDDEN void unlockMutex(mutex_t *mutex);
+HIDDEN pcb_PTR handOffMutex(mutex_t *mutex);
+HIDDEN void releaseInheritance(pcb_PTR owner);
+HIDDEN void setTickets(int tickets, int child);
+HIDDEN void setRealTime(cpu_t period, cpu_t budget);
+HIDDEN void getDeadlineMisses(int all);
+
+/******************************* GLOBAL VARIABLES *******************************/ 
+
+int   killCount;        /* Processes killed by the most recent SYS2 (or fatal exception) */
+cpu_t killTime;         /* TOD ticks that teardown took */
 
 /******************************* PHASE 3 UTLB REFILL HANDLER *******************************/ 
 
@@ -49,26 +68,53 @@ HIDDEN void getSupportData();
  * Function     :   uTLB_RefillHandler
  * Purpose      :   Handle a user-mode TLB refill exception by loading the missing page's entry
  *                  into the TLB and resuming execution. This handler first reads the saved exception
- *                  state from BIOSDATAPAGE, then extract the VPN from the EntryHi register. It maps
- *                  this VPN to an index in the current process's private Page Table. Next, it loads
- *                  the corresponding Page Table entry into a free TLB slot (TLBWR). Finally, it load
- *                  back to the saved and retry the faulting instruction
+ *                  state from BIOSDATAPAGE, then extract the VPN from the EntryHi register. The VPN
+ *                  selects a second-level table from the current process's page directory: the
+ *                  text/data region grows up from VPNSTART and the stack region grows down from
+ *                  STACKPAGEVPN. The entry is loaded into a free TLB slot (TLBWR). If the VPN lies
+ *                  outside both regions, or its table was never allocated, an invalid entry is
+ *                  written instead so the retried access raises a TLB-Invalid exception and the
+ *                  pager decides (page in, or report the bad address). Finally, it load back to
+ *                  the saved state and retry the faulting instruction.
+ *                  It runs without the kernel lock, while a pager on another processor may be
+ *                  changing the same tables; that is safe because the pager only makes single
+ *                  word stores the refill can see either side of: a table is filled in before
+ *                  its pointer is stored in the directory, and an entry's EntryHi never changes
+ *                  after that, so only EntryLO (one word) does. A refill that loads an EntryLO
+ *                  the pager is about to invalidate is covered by the pager's shootdownTLB,
+ *                  which waits for this processor's TLB to be cleared; one that loads the
+ *                  invalid word goes to the pager, which rechecks under the Swap Pool mutex.
+ *                  Tables are only freed by their own U-Proc as it terminates
  * Parameters   :   None
  * Returns      :   None
  */
 void uTLB_RefillHandler() {
     /* Retrieve the processor state at the time of exception */
     state_PTR savedExceptionState;
-    savedExceptionState = (state_PTR) BIOSDATAPAGE;
+    savedExceptionState = EXCSTATE;
 
     /* Determine the page number of the missing TLB entry */
-    int missingPageNo;
+    unsigned int missingPageNo;
     missingPageNo = ((savedExceptionState->s_entryHI) & VPNMASK) >> VPNSHIFT;
-    missingPageNo = missingPageNo % NUMPAGES;   /* Ensure the page number is within bounds */
 
-    /* Write the Page Table entry for such page number into the TLB */
-    setENTRYHI(currentProcess->p_supportStruct->sup_privatePgTbl[missingPageNo].pt_entryHI);
-    setENTRYLO(currentProcess->p_supportStruct->sup_privatePgTbl[missingPageNo].pt_entryLO);
+    /* Locate the second-level table covering the page (unsigned wrap rejects pages below each region) */
+    unsigned int offset;
+    pte_t *pageTable = NULL;
+    if ((offset = missingPageNo - VPNSTART) < MAXTEXTPAGES) {
+        pageTable = currentProcess->p_supportStruct->sup_textPgTbl[offset >> PTESHIFT];
+    } else if ((offset = STACKPAGEVPN - missingPageNo) < MAXSTACKPAGES) {
+        pageTable = currentProcess->p_supportStruct->sup_stackPgTbl[offset >> PTESHIFT];
+    }
+
+    if (pageTable != NULL) {
+        /* Write the Page Table entry for such page number into the TLB */
+        setENTRYHI(pageTable[offset & PTEMASK].pt_entryHI);
+        setENTRYLO(pageTable[offset & PTEMASK].pt_entryLO);
+    } else {
+        /* No mapping: install an invalid entry so the retry is passed up to the pager */
+        setENTRYHI(savedExceptionState->s_entryHI);
+        setENTRYLO(ALLOFF);
+    }
     TLBWR();
 
     /* Return control to the current process to retry instruction that caused the TLB-Refill event */
@@ -87,6 +133,11 @@ void uTLB_RefillHandler() {
  *                  Finally, load the processor state saved at the time the system call was executed
  * Parameters   :   initialState  - pointer to the processor state to copy for the new process
  *                  supportStruct - pointer to the support structure for handling exception (can be NULL)
+ *                  The caller's a3 (after those two, in a1 and a2) is the new process's base
+ *                  priority, from DEFAULTPRIORITY (0) to MAXPRIORITY; any other value gives
+ *                  DEFAULTPRIORITY, so a caller passing 0 gets the old behaviour. The process
+ *                  runs at its base priority except while a mutex it holds lends it a higher
+ *                  one (SYS30) or it has real-time budget left (SYS33)
  *  
  */
 void createProcess(state_PTR initialState, support_t *supportStruct)
@@ -103,11 +154,19 @@ void createProcess(state_PTR initialState, support_t *supportStruct)
         /* Set the support structure pointer (or NULL if not provided) */
         newPcb->p_supportStruct = supportStruct;
 
-        /* Link the new PCB as a child of the current process */
+        /* Set the priority from a3, clamped to [DEFAULTPRIORITY..MAXPRIORITY] */
+        newPcb->p_basePriority = currentProcess->p_s.s_a3;
+        if ((newPcb->p_basePriority < DEFAULTPRIORITY) || (newPcb->p_basePriority > MAXPRIORITY)) {
+            newPcb->p_basePriority = DEFAULTPRIORITY;
+        }
+        newPcb->p_priority = newPcb->p_basePriority;
+
+        /* Link the new PCB as a child of the current process, and put it in its fair-share group */
         insertChild(currentProcess, newPcb);
+        joinGroup(newPcb, currentProcess, supportStruct);
 
         /* Insert the new process into the ready queue */
-        insertProcQ(&readyQueue, newPcb);
+        makeReady(newPcb);
 
         /* Increment the process count */
         processCount++;
@@ -120,6 +179,9 @@ void createProcess(state_PTR initialState, support_t *supportStruct)
 
         /* Return success (0) to the calling process in its v0 register */
         currentProcess->p_s.s_v0 = 0;           
+
+        /* The child is ready: the caller no longer runs alone */
+        boundSlice();
     }
 
     /* In case there are no more free pcbs */
@@ -129,58 +191,112 @@ void createProcess(state_PTR initialState, support_t *supportStruct)
     }
 
     /* Load the saved processor state to resume execution */
-    LDST(&(currentProcess->p_s));
+    RESUME(&(currentProcess->p_s));
 }
 
 /*
  * Function     :   terminateProcess
  * Purpose      :   Implement the SYS2 system call to terminate a process and all of its progeny.
- *                  It head recursively terminates all children of the process. If the process is 
- *                  blocked, removes it from the ASL; otherwise, removes it from the ready queue.
- *                  Returns the PCB to the free list and decrements processCount.
+ *                  The subtree rooted at proc is torn down in post-order without recursion:
+ *                  descend through first children to a leaf, kill it (unlinking it from its
+ *                  parent), and continue from the parent, which may now be a leaf. The tree's
+ *                  own links are the only traversal state, so the nucleus stack use is constant
+ *                  however deep or wide the tree is. Each victim leaves the ASL or the ready
+ *                  queue in constant time (outBlocked / outProcQ), so the whole teardown is
+ *                  linear in the number of processes killed. processCount and softBlockCount
+ *                  are adjusted once, after the walk. The processes killed and the TOD ticks
+ *                  spent are left in killCount and killTime.
  * Parameters   :   proc - pointer to the PCB of the process to terminate.
  */
 void terminateProcess(pcb_PTR proc)
 {
-    /* Recursively terminate all progeny of proc */
-    while (!(emptyChild(proc))) {
-        /* While the process that will be terminated still has children */
-        terminateProcess(removeChild(proc));
-    }
-
-    /* If proc has a parent, unlink it from the parent's child list */
+    pcb_PTR victim;         /* process being killed */
+    pcb_PTR parent;         /* victim's parent, where the walk continues */
+    pcb_PTR owner;          /* owner of the mutex the victim waited on */
+    mutex_t *held;          /* mutex the victim holds */
+    int *semAdd;            /* semaphore the victim was blocked on */
+    int killed;             /* processes killed so far */
+    int deviceBlocked;      /* of which were blocked on a device semaphore */
+    cpu_t killStart;        /* TOD at the start of the teardown */
+
+    STCK(killStart);
+    killed = 0;
+    deviceBlocked = 0;
+
+    /* 1. Detach proc from its parent, so the walk stops at proc */
     if (proc->p_prnt != NULL) {
         outChild(proc);
     }
 
-    /* Determine if the proc is blocked on a semaphore or in the ready queue */
-    if (proc->p_semAdd != NULL) {
-        /* The proc is blocked on a semaphore */
-        outBlocked(proc);       /* Remove the process from the ASL */
-
-        /* Adjust semaphore or softBlockCount depending on semaphore type */
-        if (proc->p_semAdd >= &deviceSemaphores[0] &&
-            proc->p_semAdd <= &deviceSemaphores[MAXDEVICES - 1]) {
-            /* If the process is blocked on a device semaphore */
-            softBlockCount--;
-        } else {
-            /* If the process is blocked on a synchronization semaphore */
-            (*proc->p_semAdd)++;
+    /* 2. Post-order walk of proc's subtree */
+    victim = proc;
+    while (victim != NULL) {
+        /* Descend through first children to a leaf */
+        while (!(emptyChild(victim))) {
+            victim = victim->p_child;
         }
-    }
 
-    /* Else, proc is on the ready queue */ 
-    else {
-        /* Remove it from the ready queue */
-        outProcQ(&readyQueue, proc);
+        /* The leaf is its parent's first child, so unlink it with removeChild */
+        parent = victim->p_prnt;
+        if (parent != NULL) {
+            removeChild(parent);
+        }
+
+        /* Take the victim off the ASL or the ready queue */
+        if (victim->p_semAdd != NULL) {
+            /* The victim is blocked on a semaphore */
+            semAdd = victim->p_semAdd;
+            outBlocked(victim);     /* Remove the process from the ASL (clears p_semAdd) */
+
+            if (semAdd >= &deviceSemaphores[0] &&
+                semAdd <= &deviceSemaphores[MAXDEVICES - 1]) {
+                /* Blocked on a device semaphore: softBlockCount is adjusted after the walk */
+                deviceBlocked++;
+                accountBlocked(victim, blockClassOf(semAdd - deviceSemaphores), killStart);
+            } else {
+                /* Blocked on a synchronization semaphore */
+                (*semAdd)++;
+            }
+
+            /* A mutex waiter no longer lends its priority to the owner */
+            if (victim->p_mutexWait != NULL) {
+                owner = victim->p_mutexWait->mx_owner;
+                victim->p_mutexWait = NULL;
+                releaseInheritance(owner);
+            }
+        } else if (onReadyQueue(victim)) {
+            /* The victim is on a ready queue (this processor's, or another's) */
+            leaveReady(victim);
+        }
+
+        /* Pass the mutexes it holds to their most urgent waiters, as SYS31 would, so no
+           waiter is left blocked behind a dead owner */
+        while ((held = victim->p_mutexes) != NULL) {
+            victim->p_mutexes = held->mx_next;
+            handOffMutex(held);
+        }
+
+        /* Return the PCB to the free list, unless it is running on another processor,
+           which then frees it itself */
+        leaveRealTime(victim);
+        leaveGroup(victim);
+        if (!reapElsewhere(victim)) {
+            freePcb(victim);
+        }
+        killed++;
+
+        /* Continue from the parent; NULL once proc itself has been killed */
+        victim = parent;
     }
 
-    /* Return the PCB to the free list and update process count */
-    freePcb(proc);
-    processCount--;
+    /* 3. Batched bookkeeping */
+    processCount   -= killed;
+    softBlockCount -= deviceBlocked;
 
-    /* Setting the process pointer to NULL */
-    proc = NULL;
+    /* 4. Report the size and cost of the teardown */
+    STCK(currentTOD);
+    killCount = killed;
+    killTime  = currentTOD - killStart;
 }
 
 /*
@@ -215,7 +331,7 @@ void passeren(int *semAdd) {
     }
 
     /* Load the saved processor state to resume execution */
-    LDST(&(currentProcess->p_s));
+    RESUME(&(currentProcess->p_s));
 }   
 
 /*
@@ -238,11 +354,12 @@ void verhogen(int *semAdd) {
         unblockedProc = removeBlocked(semAdd);      
 
         /* Insert the unblocked process into the ready queue */
-        insertProcQ(&readyQueue, unblockedProc);
+        makeReady(unblockedProc);
+        boundSlice();
     }
 
     /* Load the saved processor state to resume execution */
-    LDST(&(currentProcess->p_s));
+    RESUME(&(currentProcess->p_s));
 }
 
 /*
@@ -275,6 +392,7 @@ void waitForIODevice(int lineNum, int deviceNum, int readBoolean) {
         /* Update the CPU usage time for the current process */
         STCK(currentTOD);
         currentProcess->p_time += (currentTOD - startTOD);
+        currentProcess->p_blockTOD = currentTOD;    /* Start of the wait, for blockedTime */
 
         /* Block the current process on the device semaphore's ASL */
         insertBlocked(&(deviceSemaphores[index]), currentProcess);
@@ -294,7 +412,7 @@ void waitForIODevice(int lineNum, int deviceNum, int readBoolean) {
 
     /* If the semaphore does not go negative (unlikely for synchronous IO), 
        load the saved processor state to resume execution */
-    LDST(&(currentProcess->p_s));
+    RESUME(&(currentProcess->p_s));
 }
 
 /*
@@ -303,10 +421,11 @@ void waitForIODevice(int lineNum, int deviceNum, int readBoolean) {
  *                  by the current process. Reads the current time-of-day and computes 
  *                  the difference from the last dispatch time. Adds this time difference 
  *                  to the process's accumulated CPU time. Returns the total CPU time via
- *                  register v0 and updates the process's PCB
- * Parameters   :   None
+ *                  register v0 of resumeState and resumes the process from it
+ * Parameters   :   resumeState - the state the process resumes from (the BIOS Data Page
+ *                                on the syscall fast path)
  */
-void getCPUTime() {
+void getCPUTime(state_PTR resumeState) {
     /* Read the current Time-Of-Day into currentTOD */
     STCK(currentTOD);
 
@@ -314,13 +433,13 @@ void getCPUTime() {
     currentProcess->p_time = currentProcess->p_time + (currentTOD - startTOD);
 
     /* Place that total CPU time into v0 of the saved exception state */
-    currentProcess->p_s.s_v0 = currentProcess->p_time + (currentTOD - startTOD);
+    resumeState->s_v0 = currentProcess->p_time;
 
     /* Restart the startTOD for the next time slice */
-    STCK(startTOD);
+    startTOD = currentTOD;
 
     /* Load the saved processor state to resume execution */
-    LDST(&(currentProcess->p_s));
+    RESUME(resumeState);
 }
 
 /*
@@ -342,6 +461,7 @@ void waitForClock() {
     /* Update the accumulated CPU usage time for the current process */
     STCK(currentTOD);
     currentProcess->p_time += (currentTOD - startTOD);
+    currentProcess->p_blockTOD = currentTOD;        /* Start of the wait, for blockedTime */
 
     /* Insert the current process into the blocked queue */
     insertBlocked(pclockSem, currentProcess);
@@ -364,15 +484,275 @@ void waitForClock() {
  * Function     :   getSupportData
  * Purpose      :   Implements the SYS8 system call to return the support structure pointer
  *                  for the current process. Loads the support structure pointer into 
- *                  register v0 and resumes the process
- * Parameters   :   None
+ *                  register v0 of resumeState and resumes the process from it
+ * Parameters   :   resumeState - the state the process resumes from (the BIOS Data Page
+ *                                on the syscall fast path)
  */
-void getSupportData() {
+void getSupportData(state_PTR resumeState) {
     /* Place the support structure pointer in v0 */
-    currentProcess->p_s.s_v0 = (int)(currentProcess->p_supportStruct);  /* Type cast to int to store in s_v0 */
+    resumeState->s_v0 = (int)(currentProcess->p_supportStruct);  /* Type cast to int to store in s_v0 */
+
+    /* Load the saved processor state to resume execution */
+    RESUME(resumeState);
+}
+
+/*
+ * Function     :   requeueByPriority
+ * Purpose      :   Move p to its new place after its priority changed, if it sits on a
+ *                  priority-ordered queue: a ready queue, or the waiters of a mutex.
+ *                  A process that is running, or blocked on an ordinary semaphore or a
+ *                  device, keeps its place.
+ * Parameters   :   p - the process whose p_priority changed
+ */
+void requeueByPriority(pcb_PTR p) {
+    pcb_PTR *queue = p->p_queue;
+
+    if ((p->p_mutexWait != NULL) || onReadyQueue(p)) {
+        outProcQ(queue, p);
+        insertPrioQ(queue, p);
+    }
+}
+
+/*
+ * Function     :   inheritPriority
+ * Purpose      :   Raise owner, and whoever owns the mutex owner waits on, and so on, to
+ *                  at least priority. The walk stops at the first process that is already
+ *                  that urgent, so it also ends on a cycle of waiting owners (a deadlock).
+ * Parameters   :   owner - holder of the mutex a process of this priority now waits on
+ *                  priority - the waiter's priority
+ */
+HIDDEN void inheritPriority(pcb_PTR owner, int priority) {
+    while ((owner != NULL) && (owner->p_priority < priority)) {
+        owner->p_priority = priority;
+        requeueByPriority(owner);
+        owner = (owner->p_mutexWait != NULL) ? owner->p_mutexWait->mx_owner : NULL;
+    }
+}
+
+/*
+ * Function     :   releaseInheritance
+ * Purpose      :   Settle owner after a waiter left one of its mutexes without taking
+ *                  it (the waiter was terminated), then whoever owns the mutex owner
+ *                  waits on, and so on, while the settled priority drops
+ * Parameters   :   owner - holder of the mutex the waiter left, or NULL
+ */
+HIDDEN void releaseInheritance(pcb_PTR owner) {
+    int previous;
+
+    while (owner != NULL) {
+        previous = owner->p_priority;
+        settlePriority(owner);
+        if (owner->p_priority == previous) {
+            return;
+        }
+        requeueByPriority(owner);
+        owner = (owner->p_mutexWait != NULL) ? owner->p_mutexWait->mx_owner : NULL;
+    }
+}
+
+/*
+ * Function     :   settlePriority
+ * Purpose      :   Recompute p's priority as the highest of its base priority (RTPRIORITY
+ *                  while it has real-time budget left) and the first (most urgent) waiter
+ *                  of each mutex it still holds
+ * Parameters   :   p - a process that has just released a mutex, or whose budget changed
+ */
+void settlePriority(pcb_PTR p) {
+    int priority = (p->p_rtLeft > 0) ? RTPRIORITY : p->p_basePriority;
+    mutex_t *held;
+    pcb_PTR waiter;
+
+    for (held = p->p_mutexes; held != NULL; held = held->mx_next) {
+        waiter = headBlocked(&(held->mx_value));
+        if ((waiter != NULL) && (waiter->p_priority > priority)) {
+            priority = waiter->p_priority;
+        }
+    }
+    p->p_priority = priority;
+}
+
+/*
+ * Function     :   lockMutex
+ * Purpose      :   Implement the SYS30 system call to lock a priority-inheritance mutex.
+ *                  A free mutex is taken at once and recorded as held by the caller.
+ *                  Otherwise the caller blocks behind every waiter of at least its
+ *                  priority, and lends its priority to the owner (and to the owners
+ *                  that one waits on), so a low-priority holder cannot be starved
+ *                  while an urgent process waits for it.
+ * Parameters   :   mutex - pointer to the mutex to be locked
+ */
+void lockMutex(mutex_t *mutex) {
+    /* Decrement the mutex's value, as for P */
+    (mutex->mx_value)--;
+
+    /* The mutex was free: the caller owns it now */
+    if (mutex->mx_value >= 0) {
+        mutex->mx_owner = currentProcess;
+        mutex->mx_next = currentProcess->p_mutexes;
+        currentProcess->p_mutexes = mutex;
+        RESUME(&(currentProcess->p_s));
+    }
+
+    /* Update the accumulated CPU time for currentProcess */
+    STCK(currentTOD);
+    currentProcess->p_time += (currentTOD - startTOD);
+
+    /* Block in priority order and boost the owner chain */
+    currentProcess->p_mutexWait = mutex;
+    insertBlockedPrio(&(mutex->mx_value), currentProcess);
+    inheritPriority(mutex->mx_owner, currentProcess->p_priority);
+
+    /* Clear currentProcess since it's blocked */
+    currentProcess = NULL;
+
+    /* Call the scheduler to dispatch another process */
+    scheduler();                    /* This should never return */
+
+    /* If the scheduler() returns, something went wrong, be PANIC */
+    PANIC();
+}
+
+/*
+ * Function     :   handOffMutex
+ * Purpose      :   Release a mutex its owner gives up (by SYS31, or by being terminated):
+ *                  increment its value, as for V, and make its first (most urgent) waiter,
+ *                  if any, the new owner and ready. That waiter was the most urgent, so
+ *                  it inherits nothing from the others still waiting
+ * Parameters   :   mutex - the mutex, already off its owner's held list
+ * Returns      :   The new owner, or NULL if the mutex is free now
+ */
+HIDDEN pcb_PTR handOffMutex(mutex_t *mutex) {
+    pcb_PTR waiter = NULL;
+
+    (mutex->mx_value)++;
+    mutex->mx_owner = NULL;
+    mutex->mx_next = NULL;
+    if (mutex->mx_value <= 0) {
+        waiter = removeBlocked(&(mutex->mx_value));
+        waiter->p_mutexWait = NULL;
+        mutex->mx_owner = waiter;
+        mutex->mx_next = waiter->p_mutexes;
+        waiter->p_mutexes = mutex;
+        makeReady(waiter);
+    }
+    return waiter;
+}
+
+/*
+ * Function     :   unlockMutex
+ * Purpose      :   Implement the SYS31 system call to unlock a priority-inheritance mutex.
+ *                  Only the owner may unlock; any other caller gets -1 in v0 and the
+ *                  mutex is untouched. Ownership passes straight to the most urgent
+ *                  waiter, if any (handOffMutex), and the caller
+ *                  drops back to the priority it still inherits from its other mutexes.
+ *                  If the new owner is now more urgent than the caller, the caller
+ *                  yields to it; otherwise it resumes with 0 in v0.
+ * Parameters   :   mutex - pointer to the mutex to be unlocked
+ */
+void unlockMutex(mutex_t *mutex) {
+    mutex_t **link;
+    pcb_PTR waiter = NULL;
+
+    /* Refuse a mutex held by another process, or a free one */
+    if (mutex->mx_owner != currentProcess) {
+        currentProcess->p_s.s_v0 = -1;
+        RESUME(&(currentProcess->p_s));
+    }
+
+    /* Drop the mutex from the caller's held list (usually its head) */
+    for (link = &(currentProcess->p_mutexes); *link != NULL; link = &((*link)->mx_next)) {
+        if (*link == mutex) {
+            *link = mutex->mx_next;
+            break;
+        }
+    }
+
+    /* Hand it to the first waiter */
+    if ((waiter = handOffMutex(mutex)) != NULL) {
+        boundSlice();
+    }
+
+    /* Give back any priority inherited through this mutex */
+    settlePriority(currentProcess);
+    currentProcess->p_s.s_v0 = 0;
+
+    /* Yield to a more urgent new owner */
+    if ((waiter != NULL) && (waiter->p_priority > currentProcess->p_priority)) {
+        STCK(currentTOD);
+        currentProcess->p_time += (currentTOD - startTOD);
+        preemptSlice(currentProcess);
+        makeReady(currentProcess);
+        currentProcess = NULL;
+        scheduler();                /* This should never return */
+        PANIC();
+    }
 
     /* Load the saved processor state to resume execution */
-    LDST(&(currentProcess->p_s));
+    RESUME(&(currentProcess->p_s));
+}
+
+/*
+ * Function     :   setTickets
+ * Purpose      :   Implement the SYS32 system call to set the stride tickets (see
+ *                  fairShare.c) of the caller, or of the child it created last, so a
+ *                  parent can fund a child right after SYS1. The count is clamped to
+ *                  [1..MAXTICKETS]. v0 gets the previous count, or -1 if a child was
+ *                  asked for and the caller has none.
+ * Parameters   :   tickets - the new number of tickets
+ *                  child - TRUE for the newest child, FALSE for the caller
+ */
+void setTickets(int tickets, int child) {
+    pcb_PTR target = currentProcess;
+
+    /* The newest child heads the caller's child list */
+    if (child) {
+        target = currentProcess->p_child;
+    }
+
+    if (target == NULL) {
+        currentProcess->p_s.s_v0 = -1;
+    } else {
+        if (tickets < 1) {
+            tickets = 1;
+        }
+        if (tickets > MAXTICKETS) {
+            tickets = MAXTICKETS;
+        }
+        currentProcess->p_s.s_v0 = assignTickets(target, tickets);
+    }
+
+    /* Load the saved processor state to resume execution */
+    RESUME(&(currentProcess->p_s));
+}
+
+/*
+ * Function     :   setRealTime
+ * Purpose      :   Implement the SYS33 system call to put the caller in the earliest-
+ *                  deadline-first real-time class (see realTime.c) with a period and a
+ *                  budget per period, both in microseconds, or to take it out (period 0).
+ *                  v0 gets 0, or -1 if admission control refused the reservation.
+ * Parameters   :   period - the period, or 0
+ *                  budget - the cpu time the caller may use per period
+ */
+void setRealTime(cpu_t period, cpu_t budget) {
+    currentProcess->p_s.s_v0 = admitRealTime(currentProcess, period, budget) ? 0 : -1;
+
+    /* Load the saved processor state to resume execution */
+    RESUME(&(currentProcess->p_s));
+}
+
+/*
+ * Function     :   getDeadlineMisses
+ * Purpose      :   Implement the SYS34 system call to return, in v0, the number of real-
+ *                  time periods that ended with the caller's job still runnable, or with
+ *                  all set, that number over every process since boot
+ * Parameters   :   all - TRUE for the system-wide count
+ */
+void getDeadlineMisses(int all) {
+    currentProcess->p_s.s_v0 = all ? rtMisses : currentProcess->p_misses;
+
+    /* Load the saved processor state to resume execution */
+    RESUME(&(currentProcess->p_s));
 }
 
 /*
@@ -380,9 +760,12 @@ void getSupportData() {
  * Purpose      :   Implements the "pass up or die" mechanism used by exception handlers.
  *                  If the current process has a support structure, the saved exception
  *                  state is copied into the appropriate field and then the exception is 
- *                  "passed up" via LDCXT to the user-level exception handler. If no 
- *                  support structure is present, the process is terminated (via SYS2), and 
- *                  the scheduler is called to dispatch another process
+ *                  "passed up" to the user-level exception handler. Instead of LDCXT, the
+ *                  handler's context is written over the BIOS Data Page copy and loaded
+ *                  with LDST, which also delivers the support structure pointer in a0 so
+ *                  the handler does not need a SYS8 to find it. If no support structure is
+ *                  present, the process is terminated (via SYS2), and the scheduler is
+ *                  called to dispatch another process
  * Parameters   :  exceptionCode - An index indicating which type of exception is being handled
  */
 void passUpOrDie(int exceptionCode) {
@@ -393,19 +776,24 @@ void passUpOrDie(int exceptionCode) {
         /* Copy the saved exception state (from the BIOS Data Page) into the appropriate 
          * sup_exceptState field of the current process's support structure */
         state_PTR savedExceptionState;
-        savedExceptionState = (state_PTR) BIOSDATAPAGE;
+        savedExceptionState = EXCSTATE;
         copyState(savedExceptionState, &(currentProcess->p_supportStruct->sup_exceptState[exceptionCode]));
             
         /* Update the accumulated CPU time for the current process */
         STCK(currentTOD);
         currentProcess->p_time += (currentTOD - startTOD);
 
-        /* Pass up the exception by performing a LDCXT using the context stored in 
-         * the corresponding sup_exceptContext field (which includes the stack pointer,
-         * status register, and program counter for the exception handler) */
-        LDCXT(currentProcess->p_supportStruct->sup_exceptContext[exceptionCode].c_stackPtr,
-            currentProcess->p_supportStruct->sup_exceptContext[exceptionCode].c_status,
-            currentProcess->p_supportStruct->sup_exceptContext[exceptionCode].c_pc);
+        /* Pass up the exception by loading the context stored in the corresponding
+         * sup_exceptContext field (stack pointer, status register and program counter
+         * for the exception handler) into the BIOS Data Page, which has just been saved,
+         * with the support structure pointer as the handler's argument in a0 */
+        context_t *handlerContext = &(currentProcess->p_supportStruct->sup_exceptContext[exceptionCode]);
+        savedExceptionState->s_pc     = handlerContext->c_pc;
+        savedExceptionState->s_t9     = handlerContext->c_pc;
+        savedExceptionState->s_sp     = handlerContext->c_stackPtr;
+        savedExceptionState->s_status = handlerContext->c_status;
+        savedExceptionState->s_a0     = (memaddr) currentProcess->p_supportStruct;
+        RESUME(savedExceptionState);
     }
 
     /*--------------------------------------------------------------*
@@ -427,19 +815,24 @@ void passUpOrDie(int exceptionCode) {
  *                  handler based on the value in register a0. Retrieves the system call number 
  *                  from the saved processor state. Increments the program counter by one word 
  *                  (4 bytes) to avoid looping. Checks if the system call was invoked from 
- *                  user mode; if so, treats it as a program trap. Uses a switch statement to
- *                  dispatch to the specific system call handler (SYS1–SYS8).
+ *                  user mode; if so, treats it as a program trap. Calls that can never block
+ *                  (SYS4 with no waiter, SYS6, SYS8) take a fast path: they edit v0 in the
+ *                  BIOS Data Page and resume from it, skipping the copy into the pcb. The
+ *                  other calls copy the state into the pcb and are dispatched with a switch
+ *                  statement to the specific system call handler (SYS1–SYS8).
  * Parameters   :   None
  */
 void syscallExceptionHandler() {
     /* Retrieve the processor state at the time of exception */
     state_PTR savedExceptionState;
-    savedExceptionState = (state_PTR) BIOSDATAPAGE;
+    savedExceptionState = EXCSTATE;
 
     /* Retrieve the system call number from the saved state */
     unsigned int sysNum;                    /* Ensure that the SYSCALL number is non-negative */
     sysNum = savedExceptionState->s_a0;
 
+    TRACE(TRSYSCALL, TRACEASID(savedExceptionState->s_entryHI), sysNum, savedExceptionState->s_a1);
+
     /* Increment the PC by WORDLEN (4) to avoid infinite SYSCALL loop */
     savedExceptionState->s_pc = savedExceptionState->s_pc + WORDLEN;
      
@@ -452,12 +845,32 @@ void syscallExceptionHandler() {
         programTrapExceptionHandler();
     }
 
-    /* Check for non-supported SYSCALL (numbered 9 and above) */
-    if ((sysNum > SYS8CALL)) {
+    /* Check for non-supported SYSCALL (numbered 9 and above, except SYS30 to SYS34) */
+    if ((sysNum > SYS8CALL) && ((sysNum < SYS30CALL) || (sysNum > SYS34CALL))) {
         /* Call Pass Up or Die with general exception handler */
         passUpOrDie(GENERALEXCEPT);
     }
 
+    /* Fast path: calls that cannot block or switch process resume straight from the
+     * BIOS Data Page; the pcb's copy is refreshed at the next exception that needs it */
+    switch (sysNum) {
+        /* SYS4 with nobody waiting: just bump the semaphore */
+        case SYS4CALL:
+            if (*((int *) savedExceptionState->s_a1) >= 0) {
+                (*((int *) savedExceptionState->s_a1))++;
+                RESUME(savedExceptionState);
+            }
+            break;
+
+        /* SYS6: Get CPU time */
+        case SYS6CALL:
+            getCPUTime(savedExceptionState);
+
+        /* SYS8: Get support data */
+        case SYS8CALL:
+            getSupportData(savedExceptionState);
+    }
+
     /* Update the currentProcess's pcb with the processor state at time SYSCALL was executed */
     copyState(savedExceptionState, &(currentProcess->p_s));
 
@@ -488,7 +901,7 @@ void syscallExceptionHandler() {
             /* a1: Address of the semaphore to be P'ed */
             passeren((int *) currentProcess->p_s.s_a1);
 
-        /* SYS4: V operator */    
+        /* SYS4: V operator (only reached when a process is waiting) */    
         case SYS4CALL:
             /* a1: Address of the semaphore to be V'ed */
             verhogen((int *) currentProcess->p_s.s_a1);
@@ -498,17 +911,34 @@ void syscallExceptionHandler() {
             /* a1: line number, a2: device number, a3: read/write indicator. */
             waitForIODevice(currentProcess->p_s.s_a1, currentProcess->p_s.s_a2, currentProcess->p_s.s_a3);
 
-        /* SYS6: Get CPU time*/
-        case SYS6CALL:
-            getCPUTime();
-
         /* SYS7: Wait for clock */
         case SYS7CALL:
             waitForClock();
 
-        /* SYS8: Get support data */
-        case SYS8CALL:
-            getSupportData();
+        /* SYS30: Lock a priority-inheritance mutex */
+        case SYS30CALL:
+            /* a1: Address of the mutex */
+            lockMutex((mutex_t *) currentProcess->p_s.s_a1);
+
+        /* SYS31: Unlock a priority-inheritance mutex */
+        case SYS31CALL:
+            /* a1: Address of the mutex */
+            unlockMutex((mutex_t *) currentProcess->p_s.s_a1);
+
+        /* SYS32: Set stride tickets */
+        case SYS32CALL:
+            /* a1: Number of tickets, a2: TRUE for the newest child */
+            setTickets(currentProcess->p_s.s_a1, currentProcess->p_s.s_a2);
+
+        /* SYS33: Enter or leave the real-time class */
+        case SYS33CALL:
+            /* a1: Period in microseconds (0 to leave), a2: Budget per period */
+            setRealTime(currentProcess->p_s.s_a1, currentProcess->p_s.s_a2);
+
+        /* SYS34: Get deadline misses */
+        case SYS34CALL:
+            /* a1: TRUE for the misses of every process since boot */
+            getDeadlineMisses(currentProcess->p_s.s_a1);
 
         default: 
             programTrapExceptionHandler();
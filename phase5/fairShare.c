@@ -0,0 +1,288 @@
+/******************************* FAIRSHARE.c ***************************************
+ *
+ * This module implements fair-share scheduling across process groups. A process
+ * created with a support structure (a U-Proc) starts the group of its ASID, with
+ * the share weight in its sup_share; any other process joins its parent's group,
+ * so a U-Proc that creates many nucleus-level children still gets one group's
+ * worth of cpu. The kernel's own processes form group 0.
+ *
+ * The scheduler charges the wall time from a dispatch to the next scheduler entry
+ * to the dispatched process's group, and removeFairShare picks, among the ready
+ * processes of the highest ready priority, the first one whose group has used the
+ * least cpu time per unit of share (g_time / g_share). Priorities therefore still
+ * come first (so priority inheritance keeps working), and with equal priorities
+ * the groups share the processor in proportion to their weights. The pick scans
+ * that leading run of the ready queue, which holds at most one entry per ready
+ * process.
+ *
+ * Within a group, processes are stride scheduled: each holds p_tickets (SYS32), and
+ * its pass advances by STRIDE1 / p_tickets per microsecond of p_time, so of two
+ * processes of the group the one with the least pass runs next and their cpu time
+ * follows their tickets. Passes are settled lazily from p_time when the scan meets
+ * a process, so no exit path has to charge them. Tickets are in the group's
+ * currency: a U-Proc's own tickets are its group's share, so SYS32 by (or for) a
+ * U-Proc moves cpu between groups, while its children's tickets split the group's
+ * time among themselves. A process that slept comes back at most STRIDELAG behind
+ * the group's pass, so it is not owed all the time it spent blocked.
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/06/09
+ *
+ ***********************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/pcb.h"
+#include "../h/fairShare.h"
+#include "../h/smp.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+group_t groups[MAXGROUPS];                      /* One group per ASID; group 0 is the kernel's */
+
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+/*
+ * Function     :   groupVtime
+ * Purpose      :   The group's cpu time per unit of share, which the scheduler equalizes
+ * Parameters   :   group - the group
+ * Returns      :   g_time / g_share
+ */
+HIDDEN cpu_t groupVtime(group_t *group) {
+    return group->g_time / group->g_share;
+}
+
+/*
+ * Function     :   passBefore
+ * Purpose      :   Compare two stride passes modulo 2^32, so that a pass that wrapped
+ *                  still orders after the ones it passed
+ * Parameters   :   a, b - the passes
+ * Returns      :   TRUE if a is behind b
+ */
+HIDDEN int passBefore(unsigned int a, unsigned int b) {
+    return ((int) (a - b)) < 0;
+}
+
+/*
+ * Function     :   leadsGroup
+ * Purpose      :   Tell whether p is its group's U-Proc, whose tickets fund the group
+ * Parameters   :   p - the process
+ * Returns      :   TRUE if p's support structure names p's group
+ */
+HIDDEN int leadsGroup(pcb_PTR p) {
+    return (p->p_supportStruct != NULL) && (p->p_supportStruct->sup_asid > KERNELGROUP) &&
+           (p->p_supportStruct->sup_asid < MAXGROUPS) &&
+           (p->p_group == &groups[p->p_supportStruct->sup_asid]);
+}
+
+/*
+ * Function     :   settlePass
+ * Purpose      :   Advance p's pass by the cpu time it used since it was last settled,
+ *                  at STRIDE1 / p_tickets per microsecond but at most STRIDEMAX, and pull
+ *                  a pass that fell more than STRIDELAG behind its group's back to that
+ *                  limit. The time is divided by p_tickets before it is multiplied, so
+ *                  a long run cannot wrap the product and leave the pass behind
+ * Parameters   :   p - a process that is not running
+ * Returns      :   None
+ */
+HIDDEN void settlePass(pcb_PTR p) {
+    unsigned int elapsed = (unsigned int) (p->p_time - p->p_passTime);
+    unsigned int advance, floor;
+
+    if ((elapsed / p->p_tickets) >= (STRIDEMAX / STRIDE1)) {
+        advance = STRIDEMAX;
+    } else {
+        advance = ((elapsed / p->p_tickets) * STRIDE1) + (((elapsed % p->p_tickets) * STRIDE1) / p->p_tickets);
+    }
+    p->p_pass += advance;
+    p->p_passTime = p->p_time;
+
+    floor = p->p_group->g_pass - STRIDELAG;
+    if (passBefore(p->p_pass, floor)) {
+        p->p_pass = floor;
+    }
+}
+
+/******************************* GROUP MEMBERSHIP *****************************/
+
+/*
+ * Function     :   initGroups
+ * Purpose      :   Empty every group. Called once by main, before the first process
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void initGroups(void) {
+    int i;
+
+    for (i = 0; i < MAXGROUPS; i++) {
+        groups[i].g_time    = 0;
+        groups[i].g_share   = DEFAULTSHARE;
+        groups[i].g_members = 0;
+        groups[i].g_pass    = 0;
+    }
+}
+
+/*
+ * Function     :   joinGroup
+ * Purpose      :   Place a newly created process in its group: the group of its
+ *                  support structure's ASID if it has one, else its parent's group
+ *                  (the kernel's group for the first process). A group that was
+ *                  empty restarts at the least vtime of the groups in use, so a
+ *                  newcomer is not owed all the cpu the others used before it.
+ *                  A U-Proc starts with its group's share as its tickets, any other
+ *                  process with its parent's; either starts at the group's pass.
+ * Parameters   :   p - the new process
+ *                  parent - its parent, or NULL
+ *                  supportStruct - its support structure, or NULL
+ * Returns      :   None
+ */
+void joinGroup(pcb_PTR p, pcb_PTR parent, support_t *supportStruct) {
+    group_t *group;
+    cpu_t least;
+    int i;
+
+    /* 1. Find the group */
+    if ((supportStruct != NULL) && (supportStruct->sup_asid > KERNELGROUP) &&
+        (supportStruct->sup_asid < MAXGROUPS)) {
+        group = &groups[supportStruct->sup_asid];
+    } else if (parent != NULL) {
+        group = parent->p_group;
+    } else {
+        group = &groups[KERNELGROUP];
+    }
+
+    /* 2. A group coming back into use takes its weight and catches up */
+    if (group->g_members == 0) {
+        group->g_share = DEFAULTSHARE;
+        if ((supportStruct != NULL) && (supportStruct->sup_share > 0)) {
+            group->g_share = supportStruct->sup_share;
+        }
+
+        least = INFINITE;
+        for (i = 0; i < MAXGROUPS; i++) {
+            if ((groups[i].g_members > 0) && (groupVtime(&groups[i]) < least)) {
+                least = groupVtime(&groups[i]);
+            }
+        }
+        group->g_time = (least == INFINITE) ? 0 : (least * group->g_share);
+    }
+
+    /* 3. Join, level with the group's stride pass */
+    group->g_members++;
+    p->p_group = group;
+    p->p_pass = group->g_pass;
+    p->p_passTime = 0;
+
+    /* 4. Take the group's share if p leads it, else the parent's tickets */
+    if (leadsGroup(p)) {
+        p->p_tickets = group->g_share;
+    } else if (parent != NULL) {
+        p->p_tickets = parent->p_tickets;
+    } else {
+        p->p_tickets = DEFAULTTICKETS;
+    }
+}
+
+/*
+ * Function     :   leaveGroup
+ * Purpose      :   Take a terminated process out of its group
+ * Parameters   :   p - the process being freed
+ * Returns      :   None
+ */
+void leaveGroup(pcb_PTR p) {
+    p->p_group->g_members--;
+}
+
+/*
+ * Function     :   assignTickets
+ * Purpose      :   Give p a new number of stride tickets. The time p used so far is
+ *                  settled at its old tickets first. If p leads its group, the group's
+ *                  share follows, with g_time rescaled so its vtime does not jump
+ * Parameters   :   p - the process
+ *                  tickets - its new tickets, in [1..MAXTICKETS]
+ * Returns      :   p's previous tickets
+ */
+int assignTickets(pcb_PTR p, int tickets) {
+    int previous = p->p_tickets;
+
+    settlePass(p);
+    p->p_tickets = tickets;
+
+    if (leadsGroup(p)) {
+        p->p_group->g_time  = groupVtime(p->p_group) * tickets;
+        p->p_group->g_share = tickets;
+    }
+    return previous;
+}
+
+/******************************* SCHEDULING *****************************/
+
+/*
+ * Function     :   chargeRunningGroup
+ * Purpose      :   Charge the time since the last dispatch to the dispatched process's
+ *                  group. Called at every scheduler entry, when that process has just
+ *                  blocked, yielded, been preempted or been terminated
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void chargeRunningGroup(void) {
+    cpu_t now;
+
+    if (thisCPU.pc_runningGroup != NULL) {
+        STCK(now);
+        thisCPU.pc_runningGroup->g_time += (now - thisCPU.pc_groupStart);
+        thisCPU.pc_runningGroup = NULL;
+    }
+}
+
+/*
+ * Function     :   removeFairShare
+ * Purpose      :   Remove and return the process to dispatch from the priority-ordered
+ *                  queue whose tail is pointed to by tp: among the leading processes of
+ *                  the head's priority, the one with the least pass in the group with
+ *                  the least vtime (the first one, on ties). Its group becomes the
+ *                  running group.
+ * Parameters   :   tp - pointer to the tail of the ready queue
+ * Returns      :   The process, or NULL if the queue is empty
+ */
+pcb_PTR removeFairShare(pcb_PTR *tp) {
+    pcb_PTR head, curr, best;
+    cpu_t vtime, bestVtime;
+
+    /* 1. Nothing ready */
+    head = headProcQ(*tp);
+    if (head == NULL) {
+        return NULL;
+    }
+
+    /* 2. Scan the head's priority run for the group furthest behind, and for
+     *    that group's process furthest behind */
+    best = head;
+    settlePass(head);
+    bestVtime = groupVtime(head->p_group);
+    for (curr = head->p_next; (curr != head) && (curr->p_priority == head->p_priority); curr = curr->p_next) {
+        settlePass(curr);
+        if (curr->p_group != best->p_group) {
+            vtime = groupVtime(curr->p_group);
+            if (vtime < bestVtime) {
+                best = curr;
+                bestVtime = vtime;
+            }
+        } else if (passBefore(curr->p_pass, best->p_pass)) {
+            best = curr;
+        }
+    }
+
+    /* 3. Take it off the queue, move its group's pass up to it, and start its group's clock */
+    outProcQ(tp, best);
+    if (passBefore(best->p_group->g_pass, best->p_pass)) {
+        best->p_group->g_pass = best->p_pass;
+    }
+    thisCPU.pc_runningGroup = best->p_group;
+    STCK(thisCPU.pc_groupStart);
+    return best;
+}
+
+/******************************* END OF FAIRSHARE.c *****************************/
@@ -0,0 +1,88 @@
+/******************************* FORK.c ***************************************
+ *
+ * This module implements SYS26, which duplicates the calling U-Proc. The child
+ * gets its own support structure and exception stacks, the parent's printer and
+ * terminal, the fair-share weight of the parent, and a copy-on-write duplicate
+ * of the parent's address space homed on the flash device named in a1 (which
+ * must be installed, unused and at least as large as the parent's). Pages
+ * neither side writes stay in the parent's blocks and frames; the first write
+ * to one gives the writer its own copy on its own device.
+ *
+ * The child resumes at the instruction after the SYSCALL with v0 = 0, while the
+ * parent gets the child's ASID. It is created by test() (launchUProc), not by the
+ * parent, so the parent's SYS2 does not take it along, and test() waits for it
+ * before halting.
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/06/04
+ *
+ ***********************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/scheduler.h"
+#include "../h/initProc.h"
+#include "../h/vmSupport.h"
+#include "../h/fork.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+/******************************* SYSCALL IMPLEMENTATION *******************************/
+
+/*
+ * Function     :   forkUserProcess
+ * Purpose      :   Implement SYS26 to duplicate the calling U-Proc. a1 holds the flash
+ *                  device that becomes the child's backing store. The child runs the
+ *                  parent's saved state (PC already past the SYSCALL) under its own
+ *                  ASID, with v0 = 0
+ * Parameters   :   savedState - pointer to the user's saved processor state
+ *                  currentSupportStruct - user's support struct
+ * Returns      :   None (v0 holds the child's ASID, or -1 if the device is not
+ *                  usable or RAM, ASIDs or processes ran out)
+ */
+void forkUserProcess(state_PTR savedState, support_t *currentSupportStruct) {
+    /* ------------------------------------------------------------ *
+     * 0. Initialize Local Variables
+     * ------------------------------------------------------------ */
+    int flashDev = savedState->s_a1;                        /* child's backing store */
+    support_t *child;                                       /* child's support structure */
+    state_t childState;                                     /* child's initial state */
+    int asid;                                               /* child's ASID */
+
+    /* ------------------------------------------------------------ *
+     * 1. Build the child's support structure
+     * ------------------------------------------------------------ */
+    child = newSupport(flashDev, currentSupportStruct->sup_printerDev, currentSupportStruct->sup_termDev);
+    if (child == NULL) {
+        savedState->s_v0 = -1;
+        LDST(savedState);
+    }
+    child->sup_share = currentSupportStruct->sup_share;
+
+    /* ------------------------------------------------------------ *
+     * 2. Duplicate the address space (this also checks the device)
+     * ------------------------------------------------------------ */
+    asid = duplicateAddressSpace(currentSupportStruct, child);
+    if (asid < 0) {
+        freeSupport(child);
+        savedState->s_v0 = -1;
+        LDST(savedState);
+    }
+
+    /* ------------------------------------------------------------ *
+     * 3. Have test() create the child from the parent's state
+     * ------------------------------------------------------------ */
+    copyState(savedState, &childState);
+    childState.s_v0 = 0;
+    childState.s_entryHI = ALLOFF | KUSEG | (asid << ASIDSHIFT);
+
+    if (launchUProc(&childState, child) != CREATESUCCESS) {
+        releaseAddressSpace(child);
+        freeSupport(child);
+        asid = -1;
+    }
+
+    savedState->s_v0 = asid;
+    LDST(savedState);
+}
+
+/******************************* END OF FORK.c *****************************/
@@ -3,13 +3,21 @@
  * This module implements the Phase 3 initialization process for the Pandos kernel.
  * It initializes the Swap Pool structures (table & semaphore), device semaphores,
  * and master semaphore. It constructs and configures the initial processor state 
- * and support structures (exception contexts and private page table) for up to 
- * UPROCMAX user processes, then invokes SYS1 to spawn each U-Proc. After creation,
- * it performs SYS3 (P) on the masterSemaphore UPROCMAX times to synchronize, and
- * finally issues SYS2 to terminate (halt) the system.
+ * and support structures (exception contexts, device bindings and page directory)
+ * for one user process per installed flash device, then invokes SYS1 to spawn each
+ * U-Proc. Support structures come from a cache-aligned slab cache and exception
+ * stacks from the stack pool, so the only limit on U-Procs is the 6-bit ASID
+ * (MAXASID) and the installed RAM. After creation, it performs SYS3 (P) on the
+ * masterSemaphore until every U-Proc has terminated, and finally issues SYS2
+ * to terminate (halt) the system.
+ *
+ * U-Procs created later (SYS26, SYS27) are launched by test() too, so that they are not
+ * the progeny of the U-Proc that asked for them and outlive it: launchUProc posts
+ * the request and V's the masterSemaphore, and test() tells a launch request from
+ * a termination by the pending request.
  * 
  * Written by  : Uyen Nguyen
- * Last update : 2025/04/17
+ * Last update : 2025/06/05
  * 
  ***********************************************************************************/
 
@@ -25,12 +33,171 @@
 #include "../h/vmSupport.h"
 #include "../h/sysSupport.h"
 #include "../h/delayDaemon.h"
+#include "../h/slab.h"
+#include "../h/sysBench.h"
+#include "../h/smp.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /**************************** SUPPORT LEVEL GLOBAL VARIABLES ****************************/ 
 
 int masterSemaphore;                    /* Master semaphore for synchronizing U-Procs */
-int devSemaphores[MAXIODEVICES];        /* Semaphore for mutual exclusion on each I/O device */
+mutex_t devSemaphores[MAXIODEVICES];    /* Mutex for mutual exclusion on each I/O device */
+slab_t supportCache;                    /* Slab cache the U-Procs' support structures come from */
+
+HIDDEN mutex_t launchMutex;             /* One launch request at a time */
+HIDDEN state_PTR launchState;           /* The pending request's initial state... */
+HIDDEN support_t *launchSupport;        /* ...and support structure, NULL if none is pending */
+HIDDEN int launchStatus;                /* SYS1's answer to the last request */
+HIDDEN int launchSemaphore;             /* The requester waits here for the answer */
+
+/******************************* U-PROC CREATION *******************************/
+
+/*
+ * Function     :   newSupport
+ * Purpose      :   Allocate and initialize a U-Proc's support structure: its devices,
+ *                  its exception stacks from the stack pool, the pager and general
+ *                  exception handler contexts, and an empty page directory. The ASID
+ *                  is left to the caller (registerAddressSpace or SYS26)
+ * Parameters   :   flashDev - flash device backing the address space
+ *                  printerDev - printer used by SYS11
+ *                  termDev - terminal used by SYS12/SYS13
+ * Returns      :   The support structure, or NULL if RAM ran out
+ */
+support_t *newSupport(int flashDev, int printerDev, int termDev) {
+    support_t *supportStruct;                               /* Support structure being built */
+    memaddr stackBlock;                                     /* Its exception stacks */
+    unsigned int status;                                    /* Status to restore */
+    int j;
+
+    /* Take a structure and a stack block, or neither */
+    status = lockNucleus();
+    supportStruct = slabAlloc(&supportCache);
+    stackBlock    = (memaddr) allocStacks();
+    if ((supportStruct == NULL) || (stackBlock == (memaddr) NULL)) {
+        if (supportStruct != NULL) {
+            slabFree(&supportCache, supportStruct);
+        }
+        if (stackBlock != (memaddr) NULL) {
+            freeStacks((void *) stackBlock);
+        }
+        unlockNucleus(status);
+        return NULL;
+    }
+    unlockNucleus(status);
+
+    /* Bind the devices */
+    supportStruct->sup_flashDev   = flashDev;
+    supportStruct->sup_blockBase  = 0;                      /* The image starts at block 0 */
+    supportStruct->sup_printerDev = printerDev;
+    supportStruct->sup_termDev    = termDev;
+    supportStruct->sup_privateSemaphore = 0;
+    supportStruct->sup_share = DEFAULTSHARE;                /* Equal fair-share weights */
+
+    /* Set the two PC fields: one to TLB handler, one to general exception handler */
+    supportStruct->sup_exceptContext[PGFAULTEXCEPT].c_pc = (memaddr) pager;
+    supportStruct->sup_exceptContext[GENERALEXCEPT].c_pc = (memaddr) VMgeneralExceptionHandler;
+
+    /* Set the two Status registers: kernel-mode with all interrupts and Processor Local Timer enabled */
+    supportStruct->sup_exceptContext[PGFAULTEXCEPT].c_status = ALLOFF | IEPON | PLTON | IMON;
+    supportStruct->sup_exceptContext[GENERALEXCEPT].c_status = ALLOFF | IEPON | PLTON | IMON;
+
+    /* Set the two SP fields: tops of the two stacks in the U-Proc's stack block */
+    supportStruct->sup_exceptContext[PGFAULTEXCEPT].c_stackPtr = stackBlock + EXCSTACKSIZE;
+    supportStruct->sup_exceptContext[GENERALEXCEPT].c_stackPtr = stackBlock + (2 * EXCSTACKSIZE);
+
+    /* Second-level tables are allocated by the pager on first touch */
+    for (j = 0; j < TEXTTABLES; j++) {
+        supportStruct->sup_textPgTbl[j] = NULL;
+    }
+    for (j = 0; j < STACKTABLES; j++) {
+        supportStruct->sup_stackPgTbl[j] = NULL;
+    }
+
+    /* Nothing has been touched yet in either region */
+    supportStruct->sup_textPages  = 0;
+    supportStruct->sup_stackPages = 0;
+    supportStruct->sup_imageText  = 0;                      /* Known once page 0 is read */
+
+    /* A one-page working set, not held back by the load controller */
+    supportStruct->sup_wsPages   = 1;
+    supportStruct->sup_lastFault = 0;
+    supportStruct->sup_suspended = FALSE;
+    supportStruct->sup_parked    = FALSE;
+    supportStruct->sup_loadSemaphore = 0;
+    supportStruct->sup_loadTOD   = 0;
+
+    return supportStruct;
+}
+
+/*
+ * Function     :   freeSupport
+ * Purpose      :   Return a support structure that never ran, and its stacks
+ * Parameters   :   supportStruct - the support structure
+ * Returns      :   None
+ */
+void freeSupport(support_t *supportStruct) {
+    unsigned int status = lockNucleus();
+
+    freeStacks((void *) (supportStruct->sup_exceptContext[PGFAULTEXCEPT].c_stackPtr - EXCSTACKSIZE));
+    slabFree(&supportCache, supportStruct);
+    unlockNucleus(status);
+}
+
+/*
+ * Function     :   initialUProcState
+ * Purpose      :   Build the state a U-Proc starts its load image in: user mode with
+ *                  all interrupts and the Processor Local Timer enabled, PC (and t9) at
+ *                  the start of .text and SP at the top of the user stack
+ * Parameters   :   initialState - the state to fill
+ *                  asid - the U-Proc's ASID, placed in EntryHi
+ * Returns      :   None
+ */
+void initialUProcState(state_PTR initialState, int asid) {
+    int i;
+
+    for (i = 0; i < STATEREGNUM; i++) {
+        initialState->s_reg[i] = 0;
+    }
+
+    /* Set PC and s_t9 to start of the .text section (0x8000.00B0) */
+    initialState->s_pc = initialState->s_t9 = (memaddr) UPROCTEXTSTART;
+
+    /* Set SP to start of the one-page user-mode stack (0xC000.0000) */
+    initialState->s_sp = (memaddr) USERSTACKTOP;
+
+    /* Set Status to user-mode with all interrupts and processor Local Timer Enable */
+    initialState->s_status = ALLOFF | USERPON | IEPON | PLTON | IMON;
+
+    /* Set EntryHi.ASID to the process's ASID */
+    initialState->s_entryHI = ALLOFF | KUSEG | (asid << ASIDSHIFT);
+}
+
+/*
+ * Function     :   launchUProc
+ * Purpose      :   Have test() create a U-Proc with SYS1, so that the new U-Proc is
+ *                  test()'s child rather than the caller's. Called by a U-Proc's
+ *                  support level; blocks until test() has answered
+ * Parameters   :   initialState - the U-Proc's initial state
+ *                  supportStruct - its support structure, ASID and address space set
+ * Returns      :   SYS1's result: CREATESUCCESS, or -1
+ */
+int launchUProc(state_PTR initialState, support_t *supportStruct) {
+    int status;
+
+    SYSCALL(SYS30CALL, (unsigned int) &launchMutex, 0, 0);
+
+    /* Post the request and wake test() */
+    launchState   = initialState;
+    launchSupport = supportStruct;
+    SYSCALL(SYS4CALL, (unsigned int) &masterSemaphore, 0, 0);
+
+    /* Wait for the answer */
+    SYSCALL(SYS3CALL, (unsigned int) &launchSemaphore, 0, 0);
+    status = launchStatus;
+
+    SYSCALL(SYS31CALL, (unsigned int) &launchMutex, 0, 0);
+    return status;
+}
 
 /******************************* EXTERNAL ELEMENTS *******************************/
 
@@ -46,10 +213,13 @@ void test() {
     /* --------------------------------------------------------------
      * 0. Initialize Local Variables 
      *--------------------------------------------------------------- */
-    int pid;                                                /* U-Proc identifier (1..UPROCMAX) */
+    int live;                                               /* U-Procs created and not yet terminated */
+    int asid;                                               /* ASID of the U-Proc being built */
+    int flashDev;                                           /* Flash device backing the next U-Proc */
     int status;                                             /* Return code from SYS1 */
     state_t initialState;                                   /* Initial state template for new U-Proc */    
-    static support_t supportStructArray[UPROCMAX + 1];      /* Support structure for each U-Proc */
+    support_t *supportStruct;                               /* Support structure of the U-Proc being built */
+    devregarea_t *devRegArea = (devregarea_t *) RAMBASEADDR;
 
     /* --------------------------------------------------------------
      * 1. Initialize Phase 3 + 5 Data Structure 
@@ -60,88 +230,92 @@ void test() {
     /* Initialize Active Delay List (ADL) */
     initADL();
 
+    /* Initialize the support structure cache */
+    slabInit(&supportCache, sizeof(support_t), CACHELINE);
+
     /* Initialize each (potentially) sharable peripheral I/O device semaphore */
     int i;
     for (i = 0; i < MAXIODEVICES; i++) {
-        devSemaphores[i] = 1;                               /* For mutual exclusion */
+        devSemaphores[i].mx_value = MUTEXFREE;              /* For mutual exclusion */
+        devSemaphores[i].mx_owner = NULL;
+        devSemaphores[i].mx_next  = NULL;
     }
 
-    /* Initialize the masterSemaphore */
+    /* Initialize the masterSemaphore, and the launch requests that share it */
     masterSemaphore = 0;                                    /* For synchronization */
+    launchMutex.mx_value = MUTEXFREE;
+    launchMutex.mx_owner = NULL;
+    launchMutex.mx_next  = NULL;
+    launchSupport   = NULL;
+    launchSemaphore = 0;
 
-    /* --------------------------------------------------------------
-     * 2. Setup the Initial Processor State Template for each U-Proc
-     * --------------------------------------------------------------- */
-    /* Set PC and s_t9 to start of the .text section (0x8000.00B0) */
-    initialState.s_pc = initialState.s_t9 = (memaddr) UPROCTEXTSTART;
-
-    /* Set SP to start of the one-page user-mode stack (0xC000.0000) */
-    initialState.s_sp = (memaddr) USERSTACKTOP;
-
-    /* Set Status to user-mode with all interrupts and processor Local Timer Enable */
-    initialState.s_status = ALLOFF | USERPON | IEPON | PLTON | IMON;
+#ifdef SYSBENCH
+    /* Measure the syscall path before any U-Proc competes for the processor */
+    launchSysBench();
+#endif
 
     /* --------------------------------------------------------------
-     * 3. Initialize and Launch (SYS1) between 1-8 U-Procs
+     * 2. Initialize and Launch (SYS1) one U-Proc per installed flash device
      * --------------------------------------------------------------- */
-    /* Loop for UPROCMAX U-Procs to set up the parameters for SYS1 and call SYS1 afterward */
-    for (pid = 1; pid <= UPROCMAX; pid++) {
-        /* ----------------------------------------------------------
-         * a. Set EntryHi.ASID to the process's unique ID
-         * ----------------------------------------------------------- */
-        initialState.s_entryHI = ALLOFF | KUSEG | (pid << ASIDSHIFT); 
+    /* Each U-Proc is bound to the devices sharing its flash device's number */
+    live = 0;
+    for (flashDev = 0; flashDev < DEVPERINT; flashDev++) {
+        /* Skip flash devices that are not installed */
+        if ((devRegArea->inst_dev[FLASHINT - OFFSET] & (1 << flashDev)) == 0) {
+            continue;
+        }
 
         /* ----------------------------------------------------------
-         * b. Set up the support structure for the U-Proc
+         * a. Set up the support structure for the U-Proc
          * ----------------------------------------------------------- */
-        /* Set sup_asid to the process's ASID */
-        supportStructArray[pid].sup_asid = pid;
-
-        /* Set the two PC fields: one to TLB handler, one to general exception handler */
-        supportStructArray[pid].sup_exceptContext[PGFAULTEXCEPT].c_pc = (memaddr) pager;
-        supportStructArray[pid].sup_exceptContext[GENERALEXCEPT].c_pc = (memaddr) VMgeneralExceptionHandler;
-
-        /* Set the two Status registers: kernel-mode with all interrupts and Processor Local Timer enabled */
-        supportStructArray[pid].sup_exceptContext[PGFAULTEXCEPT].c_status = ALLOFF | IEPON | PLTON | IMON;
-        supportStructArray[pid].sup_exceptContext[GENERALEXCEPT].c_status = ALLOFF | IEPON | PLTON | IMON;
-
-        /* Set the two SP fields: End of the two stack spaces allocated in Support Structure */
-        supportStructArray[pid].sup_exceptContext[PGFAULTEXCEPT].c_stackPtr = (memaddr) &(supportStructArray[pid].sup_stackTLB[STACKTOP]);
-        supportStructArray[pid].sup_exceptContext[GENERALEXCEPT].c_stackPtr = (memaddr) &(supportStructArray[pid].sup_stackGen[STACKTOP]);
+        supportStruct = newSupport(flashDev, flashDev, flashDev);
+        if (supportStruct == NULL) {
+            /* Out of RAM for support structures or stacks: run with the U-Procs created so far */
+            break;
+        }
 
         /* ----------------------------------------------------------
-         * c. Initialize the per-process Page Table
+         * b. Give it an ASID and build its initial state
          * ----------------------------------------------------------- */
-        int j;
-        for (j = 0; j < NUMPAGES; j++) {
-            /* Set the VPN and ASID in EntryHI */
-            supportStructArray[pid].sup_privatePgTbl[j].pt_entryHI = ALLOFF | (VPNSTART + j) << VPNSHIFT | (pid << ASIDSHIFT);
-
-            /* Set the Dirty Bit in EntryLO */
-            supportStructArray[pid].sup_privatePgTbl[j].pt_entryLO = ALLOFF | DIRTYON;
+        asid = registerAddressSpace(supportStruct);
+        if (asid < 0) {
+            freeSupport(supportStruct);
+            continue;
         }
-
-        /* (Re)Set the VPN for Stack Page (last entry) to 0xBFFFF */
-        supportStructArray[pid].sup_privatePgTbl[NUMPAGES - 1].pt_entryHI = ALLOFF | (STACKPAGEVPN << VPNSHIFT) | (pid << ASIDSHIFT);
+        initialUProcState(&initialState, asid);
 
         /* ----------------------------------------------------------
-         * d. Invoke SYS1 to create the U-Proc
+         * c. Invoke SYS1 to create the U-Proc
          * ----------------------------------------------------------- */
-        status = SYSCALL(SYS1CALL, (unsigned int) &initialState, (unsigned int) &(supportStructArray[pid]), 0); 
+        status = SYSCALL(SYS1CALL, (unsigned int) &initialState, (unsigned int) supportStruct, 0); 
 
         /* Check the status after creation */
         if (status != CREATESUCCESS) {
             /* If creation fails, terminate immediately (sorry) */
             SYSCALL(SYS2CALL, 0, 0, 0);
         }
+        live++;
     }
+
     /* --------------------------------------------------------------
-     * 4. Synchronize with U-Procs via masterSemaphore (SYS3)
+     * 3. Synchronize with U-Procs via masterSemaphore (SYS3), serving
+     *    their launch requests (SYS26, SYS27) on the way
      * --------------------------------------------------------------- */
-    int k;
-    for (k = 0; k < UPROCMAX; k++) {
-        /* Repeated issue SYS3 on masterSemaphore for UPROCMAX times */
+    while (live > 0) {
         SYSCALL(SYS3CALL, (unsigned int) &masterSemaphore, 0, 0); 
+
+        if (launchSupport != NULL) {
+            /* A U-Proc asked for a new U-Proc: create it as test()'s child */
+            launchStatus = SYSCALL(SYS1CALL, (unsigned int) launchState, (unsigned int) launchSupport, 0);
+            if (launchStatus == CREATESUCCESS) {
+                live++;
+            }
+            launchSupport = NULL;
+            SYSCALL(SYS4CALL, (unsigned int) &launchSemaphore, 0, 0);
+        } else {
+            /* A U-Proc terminated */
+            live--;
+        }
     }
 
     /* --------------------------------------------------------------
@@ -20,14 +20,18 @@
 #include "../h/scheduler.h"
 #include "../h/exceptions.h"
 #include "../h/interrupts.h"
+#include "../h/slab.h"
+#include "../h/trace.h"
+#include "../h/utilization.h"
+#include "../h/fairShare.h"
+#include "../h/realTime.h"
+#include "../h/smp.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /************************* NUCLEUS GLOBAL VARIABLES ************************/
 
 int processCount;                       /* Number of started, but not yet terminated processes */
 int softBlockCount;                     /* Number of started, but not yet terminated blocked processes */
-pcb_PTR readyQueue;                     /* Tail pointer for the ready queue */
-pcb_PTR currentProcess;                 /* Pointer to the running process */
 int deviceSemaphores[MAXDEVICES];       /* Semaphores for external devices & pseudo-clock */
 
 /******************************* EXTERNAL ELEMENTS *******************************/
@@ -45,12 +49,20 @@ extern void test();                     /* Given in the test file */
  *                  - For TLB exceptions (exception code 1-3), it calls TLBExceptionHandler()
  *                  - For system calls (exception code 8), it calls syscallExceptionHandler()
  *                  - For all other exceptions, it calls programTrapExceptionHandler()
+ *                  TLB exceptions and program traps are traced here; interrupts and
+ *                  SYSCALLs are traced by their own handlers, which know more about them.
+ *                  On a multiprocessor it first takes the kernel lock, and frees the
+ *                  running process if another processor terminated it (see smp.c)
  * Parameters   :   None
  */
 void generalExceptionHandler() {
-    /* Retrieve the saved state from the BIOS Data Page */
+    /* One processor in the nucleus at a time */
+    enterNucleus();
+    reapTerminated();
+
+    /* Retrieve this processor's saved state from the BIOS Data Page */
     state_PTR savedExceptionState;
-    savedExceptionState = (state_PTR) BIOSDATAPAGE;        
+    savedExceptionState = EXCSTATE;        
 
     /* Extract the exception code from cause register */
     int exceptionCode;
@@ -62,12 +74,14 @@ void generalExceptionHandler() {
         interruptHandler();
     } else if (exceptionCode >= TLBMIN && exceptionCode <= TLBMAX) {
         /* Code 1-3: TLB exceptions -> pass to TLB exception handler */
+        TRACE(TREXCEPTION, TRACEASID(savedExceptionState->s_entryHI), exceptionCode, savedExceptionState->s_pc);
         TLBExceptionHandler();
     } else if (exceptionCode == SYSCALLCONST) {
         /* Code 8: SYSCALL -> pass to SYSCALL exception handler */
         syscallExceptionHandler();
     } else {
         /* Code 4-7, 9-12: Program Traps -> Pass to Program Trap Handler */
+        TRACE(TREXCEPTION, TRACEASID(savedExceptionState->s_entryHI), exceptionCode, savedExceptionState->s_pc);
         programTrapExceptionHandler();
     }
 }
@@ -78,14 +92,17 @@ void generalExceptionHandler() {
  *                  1. Populate the Processor 0 Pass Up Vector with the address of the 
  *                     TLB-refill handler and the general exception handler, and their
  *                     corresponding stack pointers (set to NUCLEUSSTACKTOP)
- *                  2. Initialize Phase 1 data structures: the free list of PCBs and the ASL
+ *                  2. Hand the free RAM to the kernel memory allocator, then initialize
+ *                     Phase 1 data structures: the PCB cache and the ASL
  *                  3. Initialize nucleus global variables: processCount (0), softBlockCount (0),
- *                     readyQueue (NULL), currentProcess (NULL), and deviceSemaphores
+ *                     every processor's readyQueue (NULL) and currentProcess (NULL), and
+ *                     deviceSemaphores
  *                  4. Load the system-wide interval timer with a 100-milisecond interval
  *                  5. Create the initial process, set up its processor state (stack pointer, PC, status),
  *                     and insert it into the ready queue
  *                  6. Increment the processCount to reflect the new process
- *                  7. Call the scheduler to dispatch processes
+ *                  7. Start the other processors, if any, and call the scheduler to
+ *                     dispatch processes
  *                  8. If the scheduler return (which should not), PANIC is called
  * Parameters   :   None
  * Return       :   Never returns normally
@@ -111,10 +128,22 @@ int main()
     pv->exception_stackPtr  = NUCLEUSSTACKTOP;                      /* Set its stack pointer to the top of the nucleus stack */
 
 
+    /*--------------------------------------------------------------*
+     * Hand the Free RAM to the Kernel Memory Allocator
+     *--------------------------------------------------------------*/
+    /* Calculate the ramtop */
+    devRegArea = (devregarea_t *) RAMBASEADDR; 
+
+    /* The top of RAM is calculated by adding the base address of RAM to its size */
+    ramtop = devRegArea->rambase + devRegArea->ramsize;
+
+    initMemory(ramtop);     /* Everything between the DMA buffers and the boot stacks */
+
+
     /*--------------------------------------------------------------*
      * Initialize Phase 1 Data Structures (pcb and ASL)
      *--------------------------------------------------------------*/
-    initPcbs();             /* Initialize the free list of PCBs */
+    initPcbs();             /* Initialize the PCB cache */
     initASL();              /* Initialize the Active Semaphore List and its dummy node */
 
 
@@ -123,8 +152,7 @@ int main()
      *--------------------------------------------------------------*/
     processCount   = 0;                     /* Set the process count to zero */
     softBlockCount = 0;                     /* Set the count of blocked processes to zero */
-    readyQueue     = mkEmptyProcQ();        /* Initialize the ready queue as empty */
-    currentProcess = NULL;                  /* No process is currently running */
+    initCPUs();                             /* Empty ready queues, no process running */
 
     /* Initialize the device semaphores to 0. These semaphores are used for 
        synchronization with external devices and the pseudo-clock */
@@ -139,22 +167,19 @@ int main()
     /* Load the interval timer with INITIALINTTIMER (100,000 microseconds = 100ms) */
     LDIT(INITIALINTTIMER);           
 
+    /* The first utilization tick starts with the pseudo-clock */
+    initUtilization();
+
 
     /*--------------------------------------------------------------*
      * Instantiate the Initial Process and Place it in the Ready Queue
      *--------------------------------------------------------------*/
     pcb_PTR initialProc;
-    initialProc = allocPcb();           /* Allocate a new PCB from the free list */
+    initialProc = allocPcb();           /* Allocate a new PCB from the PCB cache */
     if (initialProc == NULL) {
         PANIC();                        /* Be *PANIC* if it can't even create one process */
     }
 
-    /* Calculate the ramtop */
-    devRegArea = (devregarea_t *) RAMBASEADDR; 
-
-    /* The top of RAM is calculated by adding the base address of RAM to its size */
-    ramtop = devRegArea->rambase + devRegArea->ramsize;
-
     /* Set up the initial processor state */
     initialProc->p_s.s_sp = ramtop;                                 /* Set the stack pointer to the top of RAM */
     initialProc->p_s.s_pc = (memaddr) test;                         /* Start execution at test */
@@ -176,15 +201,25 @@ int main()
     /* Set the Support Structure pointer to NULL */
     initialProc->p_supportStruct = NULL;
 
+    /* The initial process starts the kernel's fair-share group */
+    initGroups();
+    joinGroup(initialProc, NULL, NULL);
+
+    /* No process is real-time yet */
+    initRealTime();
+
     /* Insert the initial process into the ready queue and increment the process count */
-    insertProcQ(&readyQueue, initialProc);          
+    makeReady(initialProc);          
     processCount++;                                 
 
 
     /*--------------------------------------------------------------*
      * Call the Scheduler
      *--------------------------------------------------------------*/
-    /* Send control over to scheduler to dispatch the next process */
+    /* Hold the kernel lock while the other processors start, then send control over
+       to scheduler to dispatch the next process */
+    enterNucleus();
+    startCPUs();
     scheduler();            
 
 
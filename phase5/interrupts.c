@@ -1,12 +1,12 @@
 /******************************* INTERRUPTS.c ***************************************
  *
- * This module implements the kernel’s interrupt handling mechanism for a uniprocessor system 
+ * This module implements the kernel’s interrupt handling mechanism for one or more processors 
  * based on the UMPS/MIPS architecture. Its primary responsibilities include managing interrupts 
  * from peripheral devices, processor local timer (PLT), and interval timer (pseudo-clock). 
- * For peripheral devices (interrupt lines 3–7), the module decodes the interrupt by reading 
- * the interrupt bitmap from the device register area, determines the specific device that triggered 
- * the interrupt, and then acknowledges the event by writing an ACK command to the corresponding 
- * device register. Once acknowledged, it unblocks any process waiting on the associated semaphore, 
+ * For peripheral devices (interrupt lines 3–7), the module reads the interrupt bitmap of each
+ * line from the device register area and services every device with an interrupt pending, so a
+ * burst of completions costs one entry: each is acknowledged by writing an ACK command to the
+ * corresponding device register. Once acknowledged, it unblocks any process waiting on the associated semaphore, 
  * updates that process’s return status with the device’s status code, and enqueues the process 
  * back onto the ready queue.
  * 
@@ -38,11 +38,37 @@
 #include "../h/scheduler.h"
 #include "../h/exceptions.h"
 #include "../h/interrupts.h"
+#include "../h/trace.h"
+#include "../h/profile.h"
+#include "../h/utilization.h"
+#include "../h/smp.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /****************************** GLOBAL VARIABLES ******************************/
 
-cpu_t remainingTime;        /* Remaining time left on current process's quantum*/
+intstat_t deviceIntStats;   /* Peripheral interrupt entries and the device interrupts they serviced */
+
+/* lowestBit[b] is the index of the lowest set bit of the byte b (NOBIT for 0). It decodes
+   both the pending lines of the Cause register, whose priority order is lowest line first,
+   and a line's device bitmap, where the lowest device number is serviced first */
+HIDDEN const unsigned char lowestBit[256] = {
+    8, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0x00 - 0x0F */
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0x10 - 0x1F */
+    5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0x20 - 0x2F */
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0x30 - 0x3F */
+    6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0x40 - 0x4F */
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0x50 - 0x5F */
+    5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0x60 - 0x6F */
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0x70 - 0x7F */
+    7, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0x80 - 0x8F */
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0x90 - 0x9F */
+    5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0xA0 - 0xAF */
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0xB0 - 0xBF */
+    6, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0xC0 - 0xCF */
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0xD0 - 0xDF */
+    5, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0,  /* 0xE0 - 0xEF */
+    4, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0   /* 0xF0 - 0xFF */
+};
 
 /****************************  HELPER FUNCTION  *******************************/
 
@@ -51,97 +77,51 @@ cpu_t remainingTime;        /* Remaining time left on current process's quantum*
  * Purpose      :   Determine which specifc device triggered an interrupt on a given line.
  *                  The system's device register area maintains a bit map for each interrupt line.
  *                  This function extracts the bitmap corresponding to the provided interrupt line
- *                  (adjust for the predefined OFFSET (3)), then checks each bit to identify which
- *                  device (from DEV0 to DEV7) triggered the interrupt 
+ *                  (adjust for the predefined OFFSET (3)) and looks up its lowest set bit, which
+ *                  identifies the device (from DEV0 to DEV7) with the highest priority
  * Parameters   :   lineNumber - The interrupt line number, within range [3..7]
- * Returns      :   The device number (0-7) that caused the interrupt  
+ * Returns      :   The device number (0-7) that caused the interrupt, or NOBIT if none did
  */
 int findDeviceNumber(int lineNumber) {
     /* Map the base RAM address to the device register area structure */
     devregarea_t *devRegArea;
     devRegArea = (devregarea_t *) RAMBASEADDR;
 
-    /* Obtain the interrupt bitmap for the specific line (adjusted by OFFSET)*/
-    unsigned int bitMap;
-    bitMap = devRegArea->interrupt_dev[lineNumber - OFFSET];
-
-    /* Check each device bit in order: if a bit is set, return that device number */
-    if ((bitMap & DEV0INT) != ALLOFF) {
-        /* Device 0 triggered the interrupt */
-        return DEV0;
-    } else if ((bitMap & DEV1INT) != ALLOFF) {
-        /* Device 1 triggered the interrupt */
-        return DEV1;
-    } else if ((bitMap & DEV2INT) != ALLOFF) {
-        /* Device 2 triggered the interrupt */
-        return DEV2;
-    } else if ((bitMap & DEV3INT) != ALLOFF) {
-        /* Device 3 triggered the interrupt */
-        return DEV3;
-    } else if ((bitMap & DEV4INT) != ALLOFF) {
-        /* Device 4 triggered the interrupt */
-        return DEV4;
-    } else if ((bitMap & DEV5INT) != ALLOFF) {
-        /* Device 5 triggered the interrupt */
-        return DEV5;
-    } else if ((bitMap & DEV6INT) != ALLOFF) {
-        /* Device 6 triggered the interrupt */
-        return DEV6;
-    } else {
-        /* Device 7 triggered the interrupt */
-        return DEV7;
-    }
+    /* Look up the lowest set bit of the line's bitmap (adjusted by OFFSET) */
+    return lowestBit[devRegArea->interrupt_dev[lineNumber - OFFSET] & BYTEMASK];
 }
 
 /*******************************  FUNCTION IMPLEMENTATION  *******************************/ 
 
 /*
- * Function     :   nonTimerInterrupt
- * Purpose      :   This function handles interrupts from peripheral devices (interrupt line 3-7).
- *                  It retrieves the saved exception state, determines which interrupt line is active, 
- *                  identifies the specific device causing the interrupt, and then acknowledges the 
- *                  interrupt by sending an ACK command to the device. It also unblocks a process waiting
- *                  on the corresponding device semaphore, updates its status, and places it on the ready queue.
- *                  Finally, it returns control to the interrupted process (by loading its saved state) or 
- *                  calls the scheduler if no process is currently active.
- * Parameters   :   None
+ * Function     :   serviceDevice
+ * Purpose      :   Handle one pending interrupt of one peripheral device: acknowledge it
+ *                  by sending an ACK command to the device, unblock a process waiting on
+ *                  the corresponding device semaphore, update its status, and place it on
+ *                  the ready queue. A terminal with both sub-devices pending is serviced
+ *                  one sub-device per call (transmitter first), so its bit stays set in
+ *                  the line's bitmap until the second call.
+ * Parameters   :   lineNumber - The interrupt line number, within range [3..7]
+ *                  deviceNumber - The device number on that line, within range [0..7]
  */
-void nonTimerInterrupt() {
+HIDDEN void serviceDevice(int lineNumber, int deviceNumber) {
     /* Local variables declaration */
-    int lineNumber, deviceNumber, deviceIndex, statusCode;
+    int deviceIndex, statusCode;
     pcb_PTR unblockedProc;      
 
-    /* Retrieve the saved processor state at the time of exception */
-    state_PTR savedExceptionState;
-    savedExceptionState = (state_PTR) BIOSDATAPAGE;
-
     /* Obtain the base address for device registers */
     devregarea_t *devRegArea;
     devRegArea = (devregarea_t *) RAMBASEADDR;
 
-    /* Determine which peripheral interrupt line is active (priority order: line 3 to 7) */
-    if (((savedExceptionState->s_cause) & LINE3INT) != ALLOFF) {
-        lineNumber = DISKINT;           /* Interrupt from disk device (line 3) */
-    } else if (((savedExceptionState->s_cause) & LINE4INT) != ALLOFF) {
-        lineNumber = FLASHINT;          /* Interrupt from flash device (line 4) */
-    } else if (((savedExceptionState->s_cause) & LINE5INT) != ALLOFF) {
-        lineNumber = NETWINT;           /* Interrupt from network device (line 5)*/
-    } else if (((savedExceptionState->s_cause) & LINE6INT) != ALLOFF) {
-        lineNumber = PRNTINT;           /* Interrupt from printer (line 6) */
-    } else {
-        lineNumber = TERMINT;           /* Otherwise, interrupt from terminal (line 7) */
-    }
-
-    /* Identify the specific device within the interrupt line that caused the interrupt */
-    deviceNumber = findDeviceNumber(lineNumber);
-
     /* Calculate the index into the deviceSemaphores array and the device register area */
     deviceIndex = ((lineNumber - OFFSET) * DEVPERINT) + deviceNumber;
 
     /* Special handling for terminal interrupts (line 7) */
     if (lineNumber == LINE7) {
-        /* For terminal devices, check if the interrupt is due to transmissing (write) or receiving (read) */
-        if ((devRegArea->devreg[deviceIndex].t_transm_status & STATUSON) != READY) {
+        /* For terminal devices, check if the interrupt is due to transmissing (write) or receiving (read);
+           a transmitter still busy with a character has nothing to acknowledge yet */
+        if (((devRegArea->devreg[deviceIndex].t_transm_status & STATUSON) != READY) &&
+            ((devRegArea->devreg[deviceIndex].t_transm_status & STATUSON) != BUSY)) {
             /* It's a write interrupt */
             statusCode = devRegArea->devreg[deviceIndex].t_transm_status;  /* Save the transmission code */
             
@@ -184,26 +164,75 @@ void nonTimerInterrupt() {
         /* Increment the device semaphore count associated with the device by 1 */
         deviceSemaphores[deviceIndex]++;
     }
+    deviceIntStats.is_services++;
 
     /* If a process was unblocked */
     if (unblockedProc != NULL) {
         /* Stored the saved status code in the process's return register */
         unblockedProc->p_s.s_v0 = statusCode;
+
+        /* Charge the wait to the device's class */
+        accountBlocked(unblockedProc, lineNumber - DISKINT, currentTOD);
         
         /* Insert the process into the ready queue */
-        insertProcQ(&readyQueue, unblockedProc);
+        makeReady(unblockedProc);
 
         /* Decrement the count of processes that are blocked */
         softBlockCount--;
     }
+}
+
+/*
+ * Function     :   nonTimerInterrupt
+ * Purpose      :   This function handles interrupts from peripheral devices (interrupt line 3-7).
+ *                  Rather than one device per entry, it services every device with an interrupt
+ *                  pending: for each line pending in the saved Cause register, in priority order
+ *                  from 3 to 7 (picked by lowestBit, one lookup per line), it reads the line's
+ *                  interrupt bitmap from the device register area and services its devices
+ *                  (see serviceDevice) until the bitmap is clear. With many devices completing
+ *                  together, this replaces one exception (and one LDST) per device with one
+ *                  per burst. Finally, it returns control to the interrupted process (by loading
+ *                  its saved state) or calls the scheduler if no process is currently active.
+ * Parameters   :   None
+ */
+void nonTimerInterrupt() {
+    /* Local variables declaration */
+    int lineNumber;
+    unsigned int pendingLines;
+
+    /* Retrieve the saved processor state at the time of exception */
+    state_PTR savedExceptionState;
+    savedExceptionState = EXCSTATE;
+
+    /* Obtain the base address for device registers */
+    devregarea_t *devRegArea;
+    devRegArea = (devregarea_t *) RAMBASEADDR;
+
+    deviceIntStats.is_entries++;
+
+    /* Service every pending device, line by line (priority order: line 3 to 7) */
+    pendingLines = ((savedExceptionState->s_cause) >> IPSHIFT) & DEVLINEBITS;
+    while (pendingLines != ALLOFF) {
+        lineNumber = lowestBit[pendingLines];
+
+        /* The bitmap is re-read after each device, since acknowledging clears its bit */
+        while (devRegArea->interrupt_dev[lineNumber - OFFSET] != ALLOFF) {
+            serviceDevice(lineNumber, findDeviceNumber(lineNumber));
+        }
+
+        /* Clear the line's bit: the lowest set bit */
+        pendingLines &= (pendingLines - 1);
+    }
 
     /* If there is a currently running process */
     if (currentProcess != NULL) {
-        /* Restore the remaining quantum time for the process */
+        /* Restore the remaining quantum time for the process, cut short if it ran alone
+           and a device just readied another */
         setTIMER(remainingTime);
+        boundSlice();
 
         /* Load the saved state to resume execution */
-        LDST(savedExceptionState);
+        RESUME(savedExceptionState);
     }
 
     /* If there is no current process, call the scheduler */
@@ -221,24 +250,29 @@ void nonTimerInterrupt() {
  *                  very large value, saves the current process state, updates the process's 
  *                  accumulated CPU time, requeues the current process, and clears the 
  *                  current process pointer. It then calls the scheduler to dispatch the next process. 
- *                  If no process is running when the PLT interrupt occurs, the function calls PANIC
+ *                  If no process is running, the PLT was an idle processor's reminder to look
+ *                  for work to steal (see scheduler), and the scheduler is called at once
  * Parameters   :   None
  */
 void pltInterrupt() {
+    /* Count the interrupted (ASID, PC) when profiling */
+    PROFSAMPLE(EXCSTATE);
+
     /* Check if there is a running process at time of interrupt */
     if (currentProcess != NULL) {
         /* Set the timer to a very large value (INFINITE) to disable further PLT interrupts */
         setTIMER(INFINITE);
 
         /* Save the current processor state from BIOSDATAPAGE into currentProcess's pcb */
-        copyState((state_PTR) BIOSDATAPAGE, &(currentProcess->p_s));
+        copyState(EXCSTATE, &(currentProcess->p_s));
 
         /* Update the current process's CPU time */
         STCK(currentTOD);             
         currentProcess->p_time += (currentTOD - startTOD);
 
         /* Place the current process onto the ready queue for later scheduling */
-        insertProcQ(&readyQueue, currentProcess);
+        preemptSlice(currentProcess);
+        makeReady(currentProcess);
 
         /* Clear the pointer since no process is currently running */
         currentProcess = NULL;
@@ -249,7 +283,8 @@ void pltInterrupt() {
         /* If scheduler returns, something went wrong, be PANIC */
         PANIC();
     }
-    /* If there is no current process, this is an error, be PANIC */
+    /* If there is no current process, an idle processor looks for work again */
+    scheduler();                    /* This should never return */
     PANIC();
 }
 
@@ -271,14 +306,18 @@ void intervalTimerInterrupt() {
     /* Acknowledge the interrupt by reloading the Interval Timer with 100 milliseconds */
     LDIT(INITIALINTTIMER);
 
+    /* Count the interrupted (ASID, PC) when profiling */
+    PROFSAMPLE(EXCSTATE);
+
     /* Unblock all processes waiting on the pseudo-clock semaphore:
        Remove each process from the ASL for the pseudo-clock semaphore and insert it into the Ready Queue. */
     while (headBlocked(&deviceSemaphores[PCLOCKIDX]) != NULL) {
         /* Unlock the first pcb from the pseudo-clock semaphore's process*/
         unblockedProc = removeBlocked(&deviceSemaphores[PCLOCKIDX]);
+        accountBlocked(unblockedProc, CLOCKCLASS, currentTOD);
 
         /* Place the unblockedProc onto the ready queue */
-        insertProcQ(&readyQueue, unblockedProc);
+        makeReady(unblockedProc);
 
         /* Decrement the soft block counter for each process unblocked */
         softBlockCount--;
@@ -287,9 +326,14 @@ void intervalTimerInterrupt() {
     /* Reset the pseudo-clock to zero to block SYS7 and ensure the pseudo-clock semaphore does not grow positive */
     deviceSemaphores[PCLOCKIDX] = 0;
 
-    /* Return control to the current process (when there is actually a current process) */
+    /* Close this tick's utilization sample */
+    utilTick(currentTOD);
+
+    /* Return control to the current process (when there is actually a current process),
+       with its slice bounded if it ran alone and a sleeper just woke */
     if (currentProcess != NULL) {
-        LDST((state_PTR) BIOSDATAPAGE);         /* This should never return */
+        boundSlice();
+        RESUME(EXCSTATE);         /* This should never return */
     }
     
     /* If there is no current process to resume, call scheduler */
@@ -306,12 +350,14 @@ void intervalTimerInterrupt() {
  *                  This is the main entry point for all interrupts. When an interrupt occurs:
  *                  - The current Time-Of-Day is recorded for CPU time accounting
  *                  - The remaining time on the current process's quantum is saved
- *                  - The saved processor state is retrieved from BIOSDATAPAGE
- *                  - The handler examines the cause register to determine which type of interrupt occurred 
+ *                  - The saved processor state is retrieved from this processor's BIOSDATAPAGE slot
+ *                  - The handler looks up the lowest pending line of the cause register (lowestBit) to determine
+ *                    which type of interrupt occurred, highest priority first
  *                      * If the PLT interrupt (line 1) is detected, pltInterrupt() is called
  *                      * If the interval timer interrupt (line 2) is detected, intervalTimerInterrupt() is called
  *                      * Otherwise, a peripheral device interrupt (lines 3-7) is assumed and nonTimerInterrupt() is called
- *                  In this uniprocessor system, the inter-processor interrupts (line 0) are ignored
+ *                      * On a multiprocessor, an inter-processor interrupt (line 0) asks for a TLB
+ *                        flush, and ipiInterrupt() (smp.c) is called
  */
 void interruptHandler() {
     /* Save the Time-Of-Day when an interrupt occurs for CPU time accounting */
@@ -320,24 +366,36 @@ void interruptHandler() {
     /* Store the remaining time left on current process's quantum */
     remainingTime = getTIMER();
 
+    /* If the scheduler was waiting, the idle interval ends here */
+    if (currentProcess == NULL) {
+        endIdle(currentTOD);
+    }
+
     /* Retrieve the processor state at the time of exception */
     state_PTR savedExceptionState;
-    savedExceptionState = (state_PTR) BIOSDATAPAGE;
+    savedExceptionState = EXCSTATE;
 
+    TRACE(TRINTERRUPT, TRACEASID(savedExceptionState->s_entryHI), savedExceptionState->s_cause, savedExceptionState->s_pc);
 
-    /* Check if the interrupt is from the PLT (interrupt line 1) */
-    if (((savedExceptionState->s_cause) & LINE1INT) != ALLOFF) {
-        pltInterrupt();             /* Call PLT interrupt handler */
-    }
+    /* The highest-priority pending line is the lowest set bit of Cause.IP */
+    switch (lowestBit[((savedExceptionState->s_cause) >> IPSHIFT) & INTLINEBITS]) {
+#if NCPUS > 1
+        /* The interrupt is a TLB shootdown from another processor (interrupt line 0) */
+        case LINE0:
+            ipiInterrupt();             /* Call the IPI handler */
+#endif
 
-    /* Check if the interrupt is from the Interval Timer (interrupt line 2) */
-    else if (((savedExceptionState->s_cause) & LINE2INT) != ALLOFF) {
-        intervalTimerInterrupt();   /* Call Interval Timer handler */
-    }
+        /* The interrupt is from the PLT (interrupt line 1) */
+        case LINE1:
+            pltInterrupt();             /* Call PLT interrupt handler */
+
+        /* The interrupt is from the Interval Timer (interrupt line 2) */
+        case LINE2:
+            intervalTimerInterrupt();   /* Call Interval Timer handler */
 
-    /* Otherwise, interrupts are from peripheral devices (interrupt line 3-7) */
-    else {
-        nonTimerInterrupt();        /* Call non-timer interrupt handler */
+        /* Otherwise, interrupts are from peripheral devices (interrupt line 3-7) */
+        default:
+            nonTimerInterrupt();        /* Call non-timer interrupt handler */
     }
 }
 
@@ -0,0 +1,228 @@
+/******************************* LOADCONTROL.c ***************************************
+ *
+ * This module implements load control for the Swap Pool. When the U-Procs that
+ * run need more frames than the pool holds, every one of them keeps faulting out
+ * the pages of the others (thrashing) and the flash devices, not the processor,
+ * set the pace. The load controller prevents that by holding some U-Procs back
+ * until the others' working sets fit.
+ *
+ * Working sets are estimated from the intervals between page faults, measured in
+ * the U-Proc's own cpu time (page fault frequency): a fault that comes within
+ * LOADFAULTGAP of the previous one means the U-Proc needs one more frame than it
+ * has, while a longer interval shrinks the estimate by one frame per LOADFAULTGAP
+ * elapsed, since the pages it faulted on long ago have left its working set.
+ *
+ * On every fault, and when a U-Proc terminates or the Delay Daemon ticks, the
+ * controller adds up the estimates of the U-Procs not suspended. If they exceed
+ * the Swap Pool, it suspends one: the lowest fair-share weight first, and among
+ * equals the one that has run longest since it was last resumed. It resumes the
+ * U-Proc that has waited longest (highest weight first) once the working sets,
+ * its own included, fit in LOADRESUME / LOADRESUMESCALE of the pool, or once it
+ * has waited LOADMAXSUSPEND, so that overloaded U-Procs take turns. A suspended
+ * U-Proc stops (parks) at its next page fault, before touching a frame; one that
+ * does not fault is not thrashing and may run on. Until it parks it still holds
+ * its frames and runs, so it still counts as running: no other U-Proc is
+ * suspended meanwhile, and if the working sets fit again first, its suspension is
+ * simply cancelled. The last U-Proc running is never suspended. SYS29 turns the
+ * controller off (resuming every suspended U-Proc) or back on, so that a workload
+ * can be timed both ways.
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/06/09
+ *
+ ***********************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/vmSupport.h"
+#include "../h/loadControl.h"
+#include "../h/trace.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+HIDDEN int loadEnabled = TRUE;                  /* SYS29: FALSE lets every U-Proc run */
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+/*
+ * Function     :   suspend
+ * Purpose      :   Hold a U-Proc back: it stops at its next page fault
+ * Parameters   :   victim - the U-Proc's support structure
+ *                  demand - working set frames of the U-Procs running
+ *                  now - current TOD
+ * Returns      :   None
+ */
+HIDDEN void suspend(support_t *victim, int demand, cpu_t now) {
+    victim->sup_suspended = TRUE;
+    victim->sup_loadTOD   = now;
+    SUPTRACE(TRSUSPEND, victim->sup_asid, demand, swapPoolSize);
+}
+
+/*
+ * Function     :   resume
+ * Purpose      :   Let a suspended U-Proc run again, waking it if it is already waiting
+ * Parameters   :   waiter - the U-Proc's support structure
+ *                  demand - working set frames of the U-Procs running, waiter's excluded
+ *                  now - current TOD
+ * Returns      :   None
+ */
+HIDDEN void resume(support_t *waiter, int demand, cpu_t now) {
+    waiter->sup_suspended = FALSE;
+    waiter->sup_loadTOD   = now;
+    if (waiter->sup_parked == TRUE) {
+        waiter->sup_parked = FALSE;
+        SYSCALL(SYS4CALL, (unsigned int) &(waiter->sup_loadSemaphore), 0, 0);
+    }
+    SUPTRACE(TRRESUME, waiter->sup_asid, demand + waiter->sup_wsPages, swapPoolSize);
+}
+
+/******************************* WORKING SETS *****************************/
+
+/*
+ * Function     :   noteFault
+ * Purpose      :   Update the faulting U-Proc's working set estimate from the cpu time
+ *                  since its last fault. Must be called while holding the Swap Pool
+ *                  semaphore, by the faulting U-Proc itself
+ * Parameters   :   currentSupportStruct - support structure of the faulting U-Proc
+ * Returns      :   None
+ */
+void noteFault(support_t *currentSupportStruct) {
+    cpu_t now = SYSCALL(SYS6CALL, 0, 0, 0);                /* this U-Proc's cpu time */
+    cpu_t interval = now - currentSupportStruct->sup_lastFault;
+    int pages = currentSupportStruct->sup_wsPages;
+
+    /* One frame more for this page, less one per LOADFAULTGAP it went without faulting */
+    pages = pages + 1 - (int) (interval / LOADFAULTGAP);
+    if (pages > swapPoolSize) {
+        pages = swapPoolSize;
+    }
+    currentSupportStruct->sup_wsPages   = MAX(1, pages);
+    currentSupportStruct->sup_lastFault = now;
+}
+
+/******************************* LOAD CONTROL *****************************/
+
+/*
+ * Function     :   loadControl
+ * Purpose      :   Suspend one U-Proc if the working sets of those running overflow the
+ *                  Swap Pool, else resume one that fits again or has waited too long.
+ *                  With the controller off, resume every suspended U-Proc. Must be
+ *                  called while holding the Swap Pool semaphore
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void loadControl(void) {
+    support_t *space, *victim = NULL, *waiter = NULL, *pending = NULL;
+    int demand = 0, running = 0;
+    cpu_t now;
+    int i;
+
+    STCK(now);
+
+    /* 1. Sum the running working sets, and pick who would go and who would come back */
+    for (i = 1; i <= MAXASID; i++) {
+        if ((space = addressSpaces[i]) == NULL) {
+            continue;
+        }
+        if ((space->sup_suspended == TRUE) && (loadEnabled == FALSE)) {
+            resume(space, demand, now);
+        }
+        if ((space->sup_suspended == TRUE) && (space->sup_parked == TRUE)) {
+            if ((waiter == NULL) || (space->sup_share > waiter->sup_share) ||
+                ((space->sup_share == waiter->sup_share) && (space->sup_loadTOD < waiter->sup_loadTOD))) {
+                waiter = space;
+            }
+        } else {
+            /* Running, or suspended but not stopped yet: its frames are still in use */
+            demand += space->sup_wsPages;
+            running++;
+            if (space->sup_suspended == TRUE) {
+                pending = space;
+            } else if ((victim == NULL) || (space->sup_share < victim->sup_share) ||
+                       ((space->sup_share == victim->sup_share) && (space->sup_loadTOD < victim->sup_loadTOD))) {
+                victim = space;
+            }
+        }
+    }
+    if (loadEnabled == FALSE) {
+        return;
+    }
+
+    /* 2. Overloaded: hold one back, but keep at least one running, and wait for the
+          last one held back to stop before deciding that another one must go */
+    if ((demand > swapPoolSize) && (running > 1)) {
+        if (pending == NULL) {
+            suspend(victim, demand, now);
+        }
+        return;
+    }
+
+    /* 3. Room again before the one held back stopped: it may run on */
+    if ((pending != NULL) && ((demand * LOADRESUMESCALE) <= (swapPoolSize * LOADRESUME))) {
+        resume(pending, demand - pending->sup_wsPages, now);
+        return;
+    }
+
+    /* 4. Room again (or nobody left running, or a long wait): let one come back */
+    if ((waiter != NULL) &&
+        ((running == 0) || (((demand + waiter->sup_wsPages) * LOADRESUMESCALE) <= (swapPoolSize * LOADRESUME)) ||
+         ((now - waiter->sup_loadTOD) > LOADMAXSUSPEND))) {
+        resume(waiter, demand, now);
+    }
+}
+
+/*
+ * Function     :   loadCheckpoint
+ * Purpose      :   Stop a suspended U-Proc: release the Swap Pool semaphore, wait until
+ *                  the controller resumes it, and take the semaphore again. Called by
+ *                  the pager, holding the semaphore
+ * Parameters   :   currentSupportStruct - support structure of the faulting U-Proc
+ * Returns      :   None
+ */
+void loadCheckpoint(support_t *currentSupportStruct) {
+    while (currentSupportStruct->sup_suspended == TRUE) {
+        currentSupportStruct->sup_parked = TRUE;
+        mutex(&swapPoolSemaphore, FALSE);
+        SYSCALL(SYS3CALL, (unsigned int) &(currentSupportStruct->sup_loadSemaphore), 0, 0);
+        mutex(&swapPoolSemaphore, TRUE);
+    }
+}
+
+/*
+ * Function     :   loadTick
+ * Purpose      :   Run the controller without a fault, so that suspended U-Procs come
+ *                  back when pressure drops even if no one is faulting. Called by the
+ *                  Delay Daemon every 100ms
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void loadTick(void) {
+    mutex(&swapPoolSemaphore, TRUE);
+    loadControl();
+    mutex(&swapPoolSemaphore, FALSE);
+}
+
+/******************************* SYSCALL IMPLEMENTATION *******************************/
+
+/*
+ * Function     :   setLoadControl
+ * Purpose      :   Implement SYS29 to turn the load controller off (a1 = FALSE), which
+ *                  resumes every suspended U-Proc, or back on (a1 = TRUE)
+ * Parameters   :   savedState - pointer to the user's saved processor state
+ * Returns      :   None (v0 holds the previous setting)
+ */
+void setLoadControl(state_PTR savedState) {
+    int previous;
+
+    mutex(&swapPoolSemaphore, TRUE);
+    previous    = loadEnabled;
+    loadEnabled = (savedState->s_a1 != FALSE) ? TRUE : FALSE;
+    loadControl();
+    mutex(&swapPoolSemaphore, FALSE);
+
+    savedState->s_v0 = previous;
+    LDST(savedState);
+}
+
+/******************************* END OF LOADCONTROL.c *****************************/
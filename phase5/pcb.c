@@ -9,37 +9,46 @@
  * and hierarchical relationships among processes.
  *
  * Invariant:
- * - The PCB free list maintains available PCB structures for reuse.
+ * - PCBs come from a slab cache, so the number of processes is bounded
+ *   only by the RAM left to the page allocator; freed PCBs are reused.
  * - Process queues follow a circular doubly linked list structure.
+ * - Every pcb records the tail pointer of the queue it is on (p_queue), so
+ *   outProcQ rejects non-members and unlinks members in constant time.
+ *   Building with -DQMDEBUG also walks the queue to confirm membership.
  * - The process tree maintains parent-child relationships.
  *
  *****************************************************************************/
 
 #include "../h/pcb.h"
 #include "../h/const.h"
+#include "../h/slab.h"
+#ifdef QMDEBUG
+#ifndef PANIC
+#include "/usr/include/umps3/umps/libumps.h"
+#endif
+#endif
 
 /******************************* GLOBAL VARIABLES *****************************/
 
-/* Head pointer for the PCB free list */
-HIDDEN pcb_PTR pcbFree_h;
+/* Slab cache the PCBs are allocated from */
+HIDDEN slab_t pcbCache;
 
 /****** ************************* PCB ALLOCATION *****************************/
 
 /*
  * Function  :  freePcb
- * Purpose   :  Insert the element pointed to by p onto the pcbFree list.
+ * Purpose   :  Return the element pointed to by p to the PCB cache.
  * Parameters:  p - pointer to the pcb to be freed
  */
 void freePcb(pcb_PTR p) 
 {
-    p->p_next = pcbFree_h;
-    pcbFree_h = p;
+    slabFree(&pcbCache, p);
 }
 
 /*
  * Function :  allocPcb
- * Purpose  :  Return NULL if the pcbFree list is empty. Otherwise, remove
- *             an element from the pcbFree list, provide initial values for ALL 
+ * Purpose  :  Return NULL if RAM for another pcb is exhausted. Otherwise, take
+ *             an element from the PCB cache, provide initial values for ALL 
  *             of the pcbs fields (i.e. NULL and/or 0) and then return a pointer
  *             to the removed element. pcbs get reused, so it is important that
  *             no previous value persists in a pcb when it is reallocated.
@@ -47,11 +56,9 @@ void freePcb(pcb_PTR p)
  */
 pcb_PTR allocPcb() 
 {
-    if (pcbFree_h == NULL)
+    pcb_PTR temp = slabAlloc(&pcbCache);
+    if (temp == NULL)
         return NULL;
-
-    pcb_PTR temp = pcbFree_h;
-    pcbFree_h = pcbFree_h->p_next;
     
     /* Set queue values to NULL */
     temp->p_next = NULL;
@@ -63,11 +70,27 @@ pcb_PTR allocPcb()
     temp->p_sibNext = NULL;
     temp->p_sibPrev = NULL;
 
+    /* Not on any queue yet */
+    temp->p_queue = NULL;
+
     /* Set semaphore value to NULL */ 
     temp->p_semAdd = NULL;
 
     /* Set process status information values to 0 */ 
     temp->p_time = 0;
+    temp->p_blockTOD = 0;
+    temp->p_slice = 0;
+
+    /* Set priority values to the default */
+    temp->p_priority     = DEFAULTPRIORITY;
+    temp->p_basePriority = DEFAULTPRIORITY;
+    temp->p_mutexes      = NULL;
+    temp->p_mutexWait    = NULL;
+
+    /* Not in the real-time class */
+    temp->p_period = 0;
+    temp->p_rtLeft = 0;
+    temp->p_misses = 0;
     
     /* Set support layer values to NULL */ 
     temp->p_supportStruct = NULL;
@@ -77,21 +100,14 @@ pcb_PTR allocPcb()
 
 /*
  * Function  : initPcbs
- * Purpose   : Initialize the pcbFree list to contain all the elements of the
- *             static array of MAXPROC pcbs. This method will be called only
- *             once during data structure initialization.
+ * Purpose   : Initialize the (empty) PCB cache; it grows a slab at a time as
+ *             pcbs are allocated. This method will be called only once during
+ *             data structure initialization, after initMemory().
  * Parameters: None
  */
 void initPcbs() 
 {
-    int i;
-    static pcb_t pcbTable[MAXPROC];
-
-    pcbFree_h = NULL;
-    for (i = 0; i < MAXPROC; i++) {
-        pcbTable[i].p_next = pcbFree_h;
-        pcbFree_h = &pcbTable[i];
-    }
+    slabInit(&pcbCache, sizeof(pcb_t), WORDLEN);
 }
 
 /******************************* PROCESS QUEUE MANAGEMENT *****************************/
@@ -139,8 +155,44 @@ void insertProcQ(pcb_PTR *tp, pcb_PTR p)
         (*tp)->p_next = p;              /* Update old tail's next pointer */
         p->p_prev = *tp;                /* New pcb points to tail */
     }
-    /* Update tail pointer to the new node */
+    /* Update tail pointer to the new node and record which queue p is on */
     *tp = p;                            
+    p->p_queue = tp;
+}
+
+/*
+ * Function  : insertPrioQ
+ * Purpose   : Insert the pcb pointed to by p into the process queue whose tail-
+ *             pointer is pointed to by tp, keeping the queue ordered by p_priority,
+ *             highest first, and FIFO among equal priorities: p goes after the last
+ *             pcb whose priority is at least its own. The walk starts at the tail,
+ *             so when every priority is equal this costs the same as insertProcQ.
+ * Parameters: tp - pointer to the tail of the process queue
+ *             p  - pointer to the pcb to be inserted
+ */
+void insertPrioQ(pcb_PTR *tp, pcb_PTR p) 
+{
+    pcb_PTR after;
+
+    /* Empty queue, or nothing of lower priority: append at the tail */
+    if ((*tp == NULL) || ((*tp)->p_priority >= p->p_priority)) {
+        insertProcQ(tp, p);
+        return;
+    }
+
+    /* Walk back from the tail to the last pcb of at least p's priority; if there is
+       none, the walk stops at the tail and p becomes the new head */
+    after = (*tp)->p_prev;
+    while ((after != *tp) && (after->p_priority < p->p_priority)) {
+        after = after->p_prev;
+    }
+
+    /* Link p between after and its successor; the tail does not change */
+    p->p_next = after->p_next;
+    p->p_prev = after;
+    after->p_next->p_prev = p;
+    after->p_next = p;
+    p->p_queue = tp;
 }
 
 /*
@@ -170,6 +222,7 @@ pcb_PTR removeProcQ(pcb_PTR *tp)
     /* Clear links in the removed pcb */
     head->p_prev = NULL;
     head->p_next = NULL;
+    head->p_queue = NULL;
 
     return head;
 }
@@ -180,27 +233,26 @@ pcb_PTR removeProcQ(pcb_PTR *tp)
  *             pointer is pointed to by tp. Update the process queue's tail pointer if
  *             necessary. If the desired entry is not in the indicated queue (an error 
  *             condition), return NULL; otherwise, return p. Note that p can point
- *             to any element in the process queue
+ *             to any element in the process queue. Membership is decided by p's
+ *             p_queue, so no traversal is needed.
  * Parameters: tp - pointer to the tail of the process queue
  *             p  - pointer to the pcb to be removed
  */
 pcb_PTR outProcQ(pcb_PTR *tp, pcb_PTR p) 
 {
-    /* Check for NULL pointers */
-    if (*tp == NULL || p == NULL) return NULL;               
-
-    /* Start at the head of the circular queue */
-    pcb_PTR head = (*tp)->p_next;
-    pcb_PTR curr = head;
-
-    /* Traverse the entire queue */
-    do {
-        if (curr == p) 
-            break;
-        curr = curr->p_next;
-    } while (curr != head);
-
-    if (curr != p) return NULL;  /* p was not found in the queue */
+    /* Check for NULL pointers and for p being on some other queue (or none) */
+    if (*tp == NULL || p == NULL || p->p_queue != tp) return NULL;
+
+#ifdef QMDEBUG
+    {
+        /* p_queue claims p is on this queue: confirm it by walking the queue */
+        pcb_PTR curr = (*tp)->p_next;
+        while (curr != p && curr != *tp) {
+            curr = curr->p_next;
+        }
+        if (curr != p) PANIC();
+    }
+#endif
 
     if (p->p_next == p) {
         /* Only one element in queue */
@@ -218,6 +270,7 @@ pcb_PTR outProcQ(pcb_PTR *tp, pcb_PTR p)
     /* Clear links in the removed pcb */
     p->p_next = NULL;
     p->p_prev = NULL;
+    p->p_queue = NULL;
 
     return p;
 }
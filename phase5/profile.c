@@ -0,0 +1,147 @@
+/******************************* PROFILE.c ***************************************
+ * 
+ * This module implements the PC sampling profiler and SYS20, which exports it.
+ * Each PLT and Interval Timer interrupt calls profileSample (through the
+ * PROFSAMPLE macro of profile.h) with the state saved in the BIOS Data Page,
+ * and the interrupted (ASID, PC) pair is counted in profileTable: an open-
+ * addressed hash table of PROFSLOTS profile_t slots, probed linearly for up to
+ * PROFPROBES slots. A sample that finds neither its pair nor an empty slot is
+ * dropped and counted as such; one taken while the processor waits idle is
+ * counted apart. Like the trace ring, the table leads with a magic word so a
+ * raw memory dump can be decoded.
+ *
+ * Without -DKPROFILE the table does not exist and SYS20 returns 0 entries.
+ * 
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/05/28
+ * 
+ ***********************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/initial.h"
+#include "../h/trace.h"
+#include "../h/profile.h"
+#include "../h/smp.h"
+#include "../h/sysSupport.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+#ifdef KPROFILE
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+profiletable_t profileTable = {PROFMAGIC, 0, 0, 0};    /* The (ASID, PC) histogram */
+
+/******************************* SAMPLING *****************************/
+
+/*
+ * Function     :   profileSample
+ * Purpose      :   Count one timer-interrupt sample. Runs in the nucleus, with
+ *                  interrupts disabled and the kernel lock held, so the table needs no
+ *                  further protection
+ * Parameters   :   interrupted - the state saved in the BIOS Data Page
+ * Returns      :   None
+ */
+void profileSample(state_PTR interrupted) {
+    unsigned int asid, pc, hash, probe;
+    profile_t *slot;
+
+    /* 1. The processor was in the scheduler's WAIT: nothing to attribute */
+    if (currentProcess == NULL) {
+        profileTable.pt_idle++;
+        return;
+    }
+
+    /* 2. Hash the (ASID, PC) pair: PCs are word aligned, so their low two bits are
+     *    dropped, and the six ASID bits are folded into the top of the key */
+    asid = TRACEASID(interrupted->s_entryHI);
+    pc   = interrupted->s_pc;
+    hash = (((pc >> 2) ^ (asid << 26)) * PROFHASH) >> PROFHASHSHIFT;
+
+    /* 3. Find the pair's slot, or claim an empty one */
+    for (probe = 0; probe < PROFPROBES; probe++) {
+        slot = &profileTable.pt_slot[(hash + probe) & (PROFSLOTS - 1)];
+        if (slot->pf_count == 0) {
+            slot->pf_asid  = asid;
+            slot->pf_pc    = pc;
+            slot->pf_count = 1;
+            profileTable.pt_samples++;
+            return;
+        }
+        if (slot->pf_pc == pc && slot->pf_asid == asid) {
+            slot->pf_count++;
+            profileTable.pt_samples++;
+            return;
+        }
+    }
+
+    /* 4. The probe sequence is full */
+    profileTable.pt_dropped++;
+}
+
+#endif /* KPROFILE */
+
+/******************************* SYSCALL IMPLEMENTATION *******************************/
+
+/*
+ * Function     :   exportProfile
+ * Purpose      :   Implement SYS20 to copy the profile's non-empty slots into a user
+ *                  buffer. a1 holds the buffer's virtual address, a2 the number of
+ *                  profile_t entries it can hold, and a3 an ASID to restrict the copy
+ *                  to (a negative a3 copies every ASID). Each slot is read with
+ *                  the nucleus locked and stored into the buffer after unlocking it,
+ *                  since the store may page fault.
+ * Parameters   :   savedState - pointer to the user's saved processor state
+ *                  currentSupportStruct - user's support struct
+ * Returns      :   None (v0 holds the number of entries copied)
+ */
+void exportProfile(state_PTR savedState, support_t *currentSupportStruct) {
+    /* ------------------------------------------------------------ *
+     * 0. Initialize Local Variables 
+     * ------------------------------------------------------------ */
+    profile_t *buffer = (profile_t *) savedState->s_a1;     /* user buffer */
+    int maxEntries = savedState->s_a2;                      /* its capacity in entries */
+    int copied = 0;                                         /* entries copied so far */
+#ifdef KPROFILE
+    int onlyAsid = savedState->s_a3;                        /* ASID filter, or negative */
+    unsigned int status;                                    /* status to restore after each read */
+    unsigned int asid, pc, count;                           /* slot fields, read under lockNucleus */
+    int i;
+#endif
+
+    /* ------------------------------------------------------------ *
+     * 1. Check if the parameters are valid
+     * ------------------------------------------------------------ */
+    /* The buffer must lie in the user segment: be brutal otherwise */
+    if (((int) buffer < KUSEG) || (maxEntries < 0)) {
+        VMprogramTrapExceptionHandler(currentSupportStruct);
+    }
+
+#ifdef KPROFILE
+    /* ------------------------------------------------------------ *
+     * 2. Copy the non-empty slots that pass the filter
+     * ------------------------------------------------------------ */
+    for (i = 0; (i < PROFSLOTS) && (copied < maxEntries); i++) {
+        status = lockNucleus();
+        asid  = profileTable.pt_slot[i].pf_asid;
+        pc    = profileTable.pt_slot[i].pf_pc;
+        count = profileTable.pt_slot[i].pf_count;
+        unlockNucleus(status);
+
+        if ((count != 0) && ((onlyAsid < 0) || (asid == (unsigned int) onlyAsid))) {
+            buffer[copied].pf_asid  = asid;
+            buffer[copied].pf_pc    = pc;
+            buffer[copied].pf_count = count;
+            copied++;
+        }
+    }
+#endif
+
+    /* ------------------------------------------------------------ *
+     * 3. Return the number of entries copied
+     * ------------------------------------------------------------ */
+    savedState->s_v0 = copied;
+    LDST(savedState);
+}
+
+/******************************* END OF PROFILE.c *****************************/
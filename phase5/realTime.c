@@ -0,0 +1,320 @@
+/******************************* REALTIME.c ***************************************
+ *
+ * This module implements the earliest-deadline-first (EDF) real-time class. A
+ * process asks for a period and a budget (SYS33, both in microseconds); it is
+ * admitted only if the budgets of all admitted processes still fit, that is if
+ * the sum of budget / period stays within RTMAXLOAD thousandths per processor.
+ * An admitted process's first period starts at once.
+ *
+ * While it has budget left in its period, a real-time process has priority
+ * RTPRIORITY, above every SYS1 priority, so it sits at the front of the ready
+ * queue; among those front processes the scheduler dispatches the one whose
+ * period ends first, and sets the PLT to the smaller of the budget left and the
+ * time slice. The scheduler charges the budget at its next entry. A process that
+ * used up its budget drops to its own priority (it still runs, as batch work,
+ * when nothing more urgent is ready) until its next period starts.
+ *
+ * Every scheduler entry starts the periods that have ended: the budget is
+ * refilled and the deadline moves on. A period whose job was not done, meaning
+ * the process had not blocked since the period started and is still runnable,
+ * counts as a deadline miss (SYS34, and a TRDEADLINE trace record). A released
+ * process waits at most one time slice for the scheduler to run; a process alone
+ * on its processor, whose slice would otherwise be unbounded, has it end when the
+ * next period does (nextRelease).
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/06/09
+ *
+ ***********************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/pcb.h"
+#include "../h/exceptions.h"
+#include "../h/trace.h"
+#include "../h/realTime.h"
+#include "../h/smp.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+int rtLoad;                                     /* Admitted budget / period, in thousandths */
+int rtMisses;                                   /* Deadline misses since boot */
+
+
+HIDDEN pcb_PTR rtTable[MAXRTPROCS];             /* The admitted processes; NULL slots are free */
+HIDDEN int rtCount;                             /* Admitted processes */
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+/*
+ * Function     :   loadOf
+ * Purpose      :   The share of a processor a reservation takes, rounded up
+ * Parameters   :   period, budget - the reservation, with budget <= period <= RTMAXPERIOD
+ * Returns      :   budget / period, in thousandths
+ */
+HIDDEN int loadOf(cpu_t period, cpu_t budget) {
+    return (((unsigned int) budget * RTLOADSCALE) + period - 1) / period;
+}
+
+/*
+ * Function     :   deadlineBefore
+ * Purpose      :   Tell whether a is more urgent than b. Both are at RTPRIORITY; one that
+ *                  is not real-time got there by inheriting from a real-time waiter, and
+ *                  runs first so that it releases the mutex quickly
+ * Parameters   :   a, b - two processes at RTPRIORITY
+ * Returns      :   TRUE if a should run before b
+ */
+HIDDEN int deadlineBefore(pcb_PTR a, pcb_PTR b) {
+    if (b->p_period == 0) {
+        return FALSE;
+    }
+    if (a->p_period == 0) {
+        return TRUE;
+    }
+    return ((int) (a->p_deadline - b->p_deadline)) < 0;
+}
+
+/*
+ * Function     :   changeBudget
+ * Purpose      :   Give p a new budget left and move it to the priority that goes with it
+ * Parameters   :   p - a real-time process
+ *                  left - its budget left, or 0 once it is used up
+ * Returns      :   None
+ */
+HIDDEN void changeBudget(pcb_PTR p, cpu_t left) {
+    p->p_rtLeft = left;
+    settlePriority(p);
+    requeueByPriority(p);
+}
+
+/******************************* ADMISSION *****************************/
+
+/*
+ * Function     :   initRealTime
+ * Purpose      :   Admit nobody. Called once by main, before the first process
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void initRealTime(void) {
+    int i;
+
+    for (i = 0; i < MAXRTPROCS; i++) {
+        rtTable[i] = NULL;
+    }
+    rtCount  = 0;
+    rtLoad   = 0;
+    rtMisses = 0;
+}
+
+/*
+ * Function     :   admitRealTime
+ * Purpose      :   Put p in the real-time class with a new reservation, or take it out
+ *                  if period is 0. The reservation must satisfy RTMINPERIOD <= period <=
+ *                  RTMAXPERIOD and 1 <= budget <= period, and the load of every admitted
+ *                  reservation, with p's old one replaced, must stay within RTMAXLOAD
+ *                  per processor. A new first period starts at once
+ * Parameters   :   p - the running process
+ *                  period - its period in microseconds, or 0
+ *                  budget - the cpu time it may use per period
+ * Returns      :   TRUE if p was admitted (or left the class), FALSE if it was refused,
+ *                  in which case its old reservation, if any, stands
+ */
+int admitRealTime(pcb_PTR p, cpu_t period, cpu_t budget) {
+    int load, old, slot;
+    cpu_t now;
+
+    /* 1. Leaving the class always succeeds */
+    if (period == 0) {
+        leaveRealTime(p);
+        settlePriority(p);
+        return TRUE;
+    }
+
+    /* 2. Refuse a malformed reservation, or one that does not fit */
+    if ((period < RTMINPERIOD) || (period > RTMAXPERIOD) || (budget < 1) || (budget > period)) {
+        return FALSE;
+    }
+    load = loadOf(period, budget);
+    old = (p->p_period > 0) ? loadOf(p->p_period, p->p_budget) : 0;
+    if ((rtLoad - old + load) > (RTMAXLOAD * NCPUS)) {
+        return FALSE;
+    }
+
+    /* 3. A newcomer takes a slot in the table */
+    if (p->p_period == 0) {
+        for (slot = 0; (slot < MAXRTPROCS) && (rtTable[slot] != NULL); slot++);
+        if (slot == MAXRTPROCS) {
+            return FALSE;
+        }
+        rtTable[slot] = p;
+        rtCount++;
+    }
+    rtLoad += load - old;
+
+    /* 4. Start the first period, with the budget charged from now */
+    STCK(now);
+    p->p_period   = period;
+    p->p_budget   = budget;
+    p->p_deadline = now + period;
+    p->p_rtDone   = FALSE;
+    changeBudget(p, budget);
+
+    thisCPU.pc_rtProc  = p;
+    thisCPU.pc_rtStart = now;
+    if (getTIMER() > (unsigned int) budget) {
+        setTIMER(budget);
+    }
+    return TRUE;
+}
+
+/*
+ * Function     :   leaveRealTime
+ * Purpose      :   Take p out of the real-time class and release its load. Called for
+ *                  every terminated process; a process that is not real-time is ignored
+ * Parameters   :   p - the process
+ * Returns      :   None
+ */
+void leaveRealTime(pcb_PTR p) {
+    int i;
+
+    if (p->p_period == 0) {
+        return;
+    }
+
+    for (i = 0; i < MAXRTPROCS; i++) {
+        if (rtTable[i] == p) {
+            rtTable[i] = NULL;
+        }
+    }
+    for (i = 0; i < NCPUS; i++) {
+        if (cpus[i].pc_rtProc == p) {
+            cpus[i].pc_rtProc = NULL;
+        }
+    }
+    rtCount--;
+    rtLoad -= loadOf(p->p_period, p->p_budget);
+    p->p_period = 0;
+    p->p_rtLeft = 0;
+}
+
+/******************************* SCHEDULING *****************************/
+
+/*
+ * Function     :   settleRealTime
+ * Purpose      :   Charge the budget of the real-time process this processor dispatched
+ *                  last, then start the periods that have ended, counting the misses.
+ *                  Called at every scheduler entry
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void settleRealTime(void) {
+    pcb_PTR p = thisCPU.pc_rtProc;
+    cpu_t now, late;
+    int i;
+
+    STCK(now);
+
+    /* 1. Charge the process dispatched on its budget; if it blocked, its job is done */
+    if (p != NULL) {
+        thisCPU.pc_rtProc = NULL;
+        p->p_rtLeft -= (now - thisCPU.pc_rtStart);
+        if (p->p_semAdd != NULL) {
+            p->p_rtDone = TRUE;
+        }
+        if (p->p_rtLeft <= 0) {
+            changeBudget(p, 0);
+        }
+    }
+
+    /* 2. Start the periods that have ended */
+    for (i = 0; (i < MAXRTPROCS) && (rtCount > 0); i++) {
+        p = rtTable[i];
+        if ((p == NULL) || (((int) (now - p->p_deadline)) < 0)) {
+            continue;
+        }
+
+        if ((!p->p_rtDone) && (p->p_semAdd == NULL)) {
+            p->p_misses++;
+            rtMisses++;
+            TRACE(TRDEADLINE, TRACEASID(p->p_s.s_entryHI), p->p_deadline, p->p_misses);
+        }
+
+        late = now - p->p_deadline;
+        p->p_deadline += ((late / p->p_period) + 1) * p->p_period;
+        p->p_rtDone = FALSE;
+        changeBudget(p, p->p_budget);
+    }
+}
+
+/*
+ * Function     :   nextRelease
+ * Purpose      :   Time until the first of the admitted processes' periods ends, when a
+ *                  scheduler entry must release its next one
+ * Parameters   :   None
+ * Returns      :   Microseconds, at least MINGRANULARITY, or INFINITE if no process
+ *                  is admitted
+ */
+cpu_t nextRelease(void) {
+    cpu_t now, left, soonest = INFINITE;
+    int i;
+
+    if (rtCount == 0) {
+        return INFINITE;
+    }
+
+    STCK(now);
+    for (i = 0; i < MAXRTPROCS; i++) {
+        if ((rtTable[i] != NULL) && ((left = rtTable[i]->p_deadline - now) < soonest)) {
+            soonest = left;
+        }
+    }
+    return (soonest < MINGRANULARITY) ? MINGRANULARITY : soonest;
+}
+
+/*
+ * Function     :   removeEarliestDeadline
+ * Purpose      :   Remove and return the process to dispatch if the priority-ordered
+ *                  queue whose tail is pointed to by tp starts with RTPRIORITY processes:
+ *                  the one among them whose deadline comes first
+ * Parameters   :   tp - pointer to the tail of the ready queue
+ * Returns      :   The process, or NULL if no process at RTPRIORITY is ready
+ */
+pcb_PTR removeEarliestDeadline(pcb_PTR *tp) {
+    pcb_PTR head, curr, best;
+
+    head = headProcQ(*tp);
+    if ((head == NULL) || (head->p_priority != RTPRIORITY)) {
+        return NULL;
+    }
+
+    best = head;
+    for (curr = head->p_next; (curr != head) && (curr->p_priority == RTPRIORITY); curr = curr->p_next) {
+        if (deadlineBefore(curr, best)) {
+            best = curr;
+        }
+    }
+
+    outProcQ(tp, best);
+    return best;
+}
+
+/*
+ * Function     :   startBudget
+ * Purpose      :   Start charging p's budget, if it is dispatched on it, and shorten its
+ *                  time slice so the PLT fires when the budget runs out
+ * Parameters   :   p - the process being dispatched
+ *                  slice - the time slice the scheduler gave it
+ * Returns      :   The time slice to load into the PLT
+ */
+cpu_t startBudget(pcb_PTR p, cpu_t slice) {
+    if (p->p_rtLeft <= 0) {
+        return slice;
+    }
+
+    thisCPU.pc_rtProc = p;
+    STCK(thisCPU.pc_rtStart);
+    return (p->p_rtLeft < slice) ? p->p_rtLeft : slice;
+}
+
+/******************************* END OF REALTIME.c *****************************/
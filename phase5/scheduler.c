@@ -1,18 +1,32 @@
 /******************************* SCHEDULER.c ***************************************
  *
- * This module implements a preemptive round-robin scheduler with a 5ms time slice.
+ * This module implements a preemptive round-robin scheduler with an adaptive time slice.
  * Its primary responsibilities are:
  *  - Dispatch processes from the ready queue so that each ready process gets a chance
- *    to execute
- *  - Track CPU time for processes using the global variables startTOD and currentTOD
+ *    to execute; among the most urgent ready processes, the one whose fair-share group
+ *    is furthest behind its share of the CPU goes first (see fairShare.c), after any
+ *    real-time process with budget left, earliest deadline first (see realTime.c)
+ *  - Size each time slice so every ready process runs within TARGETLATENCY: the
+ *    slice is TARGETLATENCY divided among the processes ready on this processor
+ *    (pc_readyCount, counted by makeReady, leaveReady and the dispatch), but at
+ *    least MINGRANULARITY, and unbounded when the process is alone (on a
+ *    multiprocessor, TARGETLATENCY, so a SYS2 from another processor is never
+ *    kept waiting longer than that; and never past the start of the next
+ *    real-time period). A process that blocked before its slice ended gets the unused part added to its next slice
+ *    (up to TARGETLATENCY), so I/O-bound processes keep their turn; one that was
+ *    preempted or yielded does not. When a process becomes ready while an
+ *    unbounded slice runs, boundSlice ends it
+ *  - Track CPU time for processes using the per-processor startTOD and currentTOD
+ *  - On a multiprocessor, each processor schedules from its own ready queue and
+ *    steals a process from another processor's when its own is empty (see smp.c)
  *  - Handle idle conditions:
  *      a) If no processes remain (processCount == 0), the system halts
- *      b) If processes exist but all are blocked (softBlockedCount > 0), the scheduler
- *         waits for an external interrupt
+ *      b) If processes exist but all are blocked (softBlockedCount > 0), or run on
+ *         other processors, the scheduler waits for an external interrupt
  *      c) If processes exist but none are ready (deadlock), the system panic
  * 
  * Written by  : Uyen Nguyen
- * Last update : 2025/02/28 
+ * Last update : 2025/06/09 
  *  
  ***********************************************************************************/
 
@@ -23,14 +37,13 @@
 #include "../h/initial.h"
 #include "../h/scheduler.h"
 #include "../h/interrupts.h"
+#include "../h/trace.h"
+#include "../h/utilization.h"
+#include "../h/fairShare.h"
+#include "../h/realTime.h"
+#include "../h/smp.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
-/*******************************  GLOBAL VARIABLES  *******************************/
-
-/* Global variables used for CPU time tracking */
-cpu_t startTOD;         /* Time when the current process was dispatched */
-cpu_t currentTOD;       /* Temporary variable  to store the current TOD for CPU time accounting */
-
 /*******************************  HELPER FUNCTION  *******************************/
 
 /*
@@ -52,24 +65,157 @@ void copyState(state_PTR source, state_PTR dest) {
     }
 }
 
+/*
+ * Function      :   fairSlice
+ * Purpose       :   The share of TARGETLATENCY of one of count runnable processes
+ * Parameters    :   count - the runnable processes, at least 2
+ * Returns       :   TARGETLATENCY / count, but at least MINGRANULARITY
+ */
+HIDDEN cpu_t fairSlice(int count) {
+    cpu_t slice = TARGETLATENCY / count;
+
+    return (slice < MINGRANULARITY) ? MINGRANULARITY : slice;
+}
+
+/*
+ * Function      :   timeSlice
+ * Purpose       :   Size the time slice of p, which is being dispatched: LONESLICE (or
+ *                   less, up to the next real-time period) if no other process is
+ *                   ready here, else its fair share of the target
+ *                   latency plus what it left of its last slice by blocking early (a
+ *                   process preempted or yielding gave its slice up: see preemptSlice).
+ *                   The slice and p_time are noted in p, for its next dispatch
+ * Parameters    :   p - the process, already off the ready queue
+ * Returns       :   The time slice to load into the PLT
+ */
+HIDDEN cpu_t timeSlice(pcb_PTR p) {
+    int count = thisCPU.pc_readyCount + 1;
+    cpu_t slice, used;
+
+    /* 1. Alone: run until it blocks or another process becomes ready (on a
+          multiprocessor, at most LONESLICE), or until the next real-time period
+          starts, which only a scheduler entry releases */
+    if (count == 1) {
+        p->p_slice = 0;
+        slice = nextRelease();
+        return (slice < LONESLICE) ? slice : LONESLICE;
+    }
+
+    /* 2. Its share, plus the remainder of a slice it gave up by blocking */
+    slice = fairSlice(count);
+    if (p->p_slice > 0) {
+        used = p->p_time - p->p_sliceStart;
+        if (used < p->p_slice) {
+            slice += p->p_slice - used;
+        }
+    }
+    if (slice > TARGETLATENCY) {
+        slice = TARGETLATENCY;
+    }
+
+    p->p_slice = slice;
+    p->p_sliceStart = p->p_time;
+    return slice;
+}
+
+/*
+ * Function      :   boundSlice
+ * Purpose       :   Called when the nucleus has made a process ready and is about to
+ *                   resume the current one. If that one runs an unbounded slice, give
+ *                   it a fair slice from now on, so the newcomer is not kept waiting.
+ *                   The PLT is only ever shortened (a real-time budget may be shorter)
+ * Parameters    :   None
+ */
+void boundSlice(void) {
+    cpu_t slice, now;
+
+    if ((currentProcess != NULL) && (currentProcess->p_slice == 0) && !emptyProcQ(readyQueue)) {
+        slice = fairSlice(thisCPU.pc_readyCount + 1);
+        if (getTIMER() > (unsigned int) slice) {
+            setTIMER(slice);
+        }
+
+        STCK(now);
+        currentProcess->p_slice = (now - startTOD) + slice;
+        currentProcess->p_sliceStart = currentProcess->p_time;
+    }
+}
+
+/*
+ * Function      :   preemptSlice
+ * Purpose       :   Called when the running process goes back on the ready queue without
+ *                   blocking (its PLT fired, or it yields to a more urgent process): what
+ *                   it left of its slice is not credited to its next one
+ * Parameters    :   p - the process, about to be requeued
+ */
+void preemptSlice(pcb_PTR p) {
+    p->p_slice = 0;
+}
+
+/*
+ * Function      :   makeReady
+ * Purpose       :   Put p on this processor's ready queue, in priority order, and count
+ *                   it in pc_readyCount, which time slices are sized from. Every process
+ *                   that becomes ready goes through here, so the queue manager does not
+ *                   need to know which queues are ready queues
+ * Parameters    :   p - a process on no queue
+ */
+void makeReady(pcb_PTR p) {
+    insertPrioQ(&readyQueue, p);
+    thisCPU.pc_readyCount++;
+}
+
+/*
+ * Function      :   leaveReady
+ * Purpose       :   Take p off the ready queue it is on (on a multiprocessor, possibly
+ *                   another processor's) and uncount it there
+ * Parameters    :   p - a process on a ready queue (see onReadyQueue)
+ */
+void leaveReady(pcb_PTR p) {
+    int i;
+
+    for (i = 0; i < NCPUS; i++) {
+        if (p->p_queue == &(cpus[i].pc_readyQueue)) {
+            outProcQ(p->p_queue, p);
+            cpus[i].pc_readyCount--;
+            return;
+        }
+    }
+}
+
 /******************************* SCHEDULING IMPLEMENTATION *******************************/
 
 /*
  * Function      :   scheduler
- * Purpose       :   Implements a round-robin scheduler with a 5ms time slice.
+ * Purpose       :   Implements a round-robin scheduler with an adaptive time slice.
  *                   - If the ready queue is not empty, it dispatches the next process in round-robin fashion
- *                   - If the ready queue is empty:
+ *                   - If the ready queue is empty, it first steals a process from another
+ *                     processor's ready queue; if there is none:
  *                      a) If no processes remain (processCount = 0), it halts the system
- *                      b) If processes exists but are all blocked (softBlockCount > 0), it disable the 
- *                         local timer by loading a very large value and enable interrupts to wait 
- *                         for an external interruption to unblock a process
+ *                      b) If processes exists but are all blocked (softBlockCount > 0), or run
+ *                         on other processors, it disable the local timer by loading a very
+ *                         large value (a time slice on a multiprocessor, to look for work to
+ *                         steal again). If a device or Interval Timer interrupt is already
+ *                         pending it is handled at once; otherwise the idle interval is
+ *                         recorded, the kernel lock released and interrupts are enabled to
+ *                         wait for an external interruption to unblock a process
  *                      c) If processes exist but none are ready (indicating deadlock), it panics
  * Parameters    :   None
 */
 void scheduler() {
     /* Pointer to hold the next process to be dispatched dispatch */
     pcb_PTR nextProcess;  
+
+    /* The process dispatched last has left the processor: charge its group and its
+       real-time budget, and start the real-time periods that have ended */
+    chargeRunningGroup();
+    settleRealTime();
     
+    /* An empty ready queue takes work from another processor's, if any has some */
+    if (emptyProcQ(readyQueue)) {
+        stealWork();
+    }
+
     /* Check if the ready queue is empty */
     if (emptyProcQ(readyQueue)) {
         if (processCount == 0) {
@@ -77,11 +223,27 @@ void scheduler() {
             HALT();  
         } 
         
-         /* Processes exist but are all blocked */
-        else if (softBlockCount > 0) {
-            /* Disable the local timer, enable interrupts, and wait for an external interrupt to unblock a process */
-            setSTATUS(ALLOFF | IMON | IECON);                   /* Enable interrupts */
-            setTIMER(INFINITE);                                 /* Prevent PLT from firing */
+         /* Processes exist but are all blocked, or running elsewhere */
+        else if ((softBlockCount > 0) || othersRunning()) {
+            /* Disable the local timer first, so a stale PLT interrupt is not mistaken for a wake-up */
+            setTIMER(IDLETIMER);                                /* Prevent PLT from firing */
+
+            /* A device or the Interval Timer may already be waiting: handle it directly, without
+               enabling interrupts or entering WAIT. Each such call nests on the nucleus stack, so
+               after IDLENESTMAX of them in a row take the ordinary path, which starts afresh */
+            if (((getCAUSE() & IDLEWAKELINES) != ALLOFF) && (thisCPU.pc_idleNesting < IDLENESTMAX)) {
+                thisCPU.pc_idleNesting++;
+                EXCSTATE->s_cause = getCAUSE() & IDLEWAKELINES;
+                interruptHandler();                             /* This should never return */
+                PANIC();
+            }
+
+            /* Otherwise enable interrupts and wait for an external interrupt to unblock a process */
+            thisCPU.pc_idleNesting = 0;
+            TRACE(TRIDLE, 0, softBlockCount, processCount);
+            startIdle();                                        /* Idle time runs until the interrupt */
+            leaveNucleus();                                     /* Other processors may enter now */
+            setSTATUS(ALLOFF | IMON | IECON | IDLEPLT);         /* Enable interrupts */
             WAIT();                                             /* Wait for an external interrupt */
         } 
         
@@ -92,18 +254,29 @@ void scheduler() {
         }
     }
 
-    /* Ready queue is not empty: remove the next process for execution */
-    nextProcess = removeProcQ(&readyQueue);
+    /* Ready queue is not empty: remove the next process for execution, the real-time
+       process with the earliest deadline if one has budget left, else one from the
+       group that is furthest behind its fair share */
+    nextProcess = removeEarliestDeadline(&readyQueue);
+    if (nextProcess == NULL) {
+        nextProcess = removeFairShare(&readyQueue);
+    }
+    thisCPU.pc_readyCount--;
     currentProcess = nextProcess;
+    thisCPU.pc_idleNesting = 0;
+    noteDispatch(currentProcess);                   /* Clear the TLB if a page moved since */
 
     /* Record the dispatch time for CPU time accounting */
     STCK(startTOD);
 
-    /* Set the processor local timer to initial time slice (5ms) */
-    setTIMER(INITIALPLT);
+    /* Set the processor local timer to the process's time slice, or to its real-time
+       budget left if that is shorter */
+    setTIMER(startBudget(currentProcess, timeSlice(currentProcess)));
+
+    TRACE(TRDISPATCH, TRACEASID(currentProcess->p_s.s_entryHI), currentProcess->p_s.s_pc, currentProcess->p_time);
 
     /* Load the state of the next process, transferring control to it */
-    LDST(&(currentProcess->p_s));           /* This should never return */
+    RESUME(&(currentProcess->p_s));         /* This should never return */
 
     /* If control reaches here, something went wrong */
     PANIC();
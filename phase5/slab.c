@@ -0,0 +1,322 @@
+/******************************* SLAB.c ***************************************
+ *
+ * This module implements the kernel memory allocator. At boot, every frame
+ * between the DMA buffers and the stacks reserved at the top of RAM is handed
+ * to a page allocator: a bump pointer for contiguous boot-time carve-outs (the
+ * Swap Pool) plus a free list of single frames returned later. On top of it,
+ * slab caches serve the kernel's fixed-size objects (PCBs, semaphore and delay
+ * descriptors, support structures, page tables). A cache starts empty and grows
+ * one slab (a few frames cut into equal objects) whenever its free list runs dry,
+ * so the number of processes is bounded by RAM rather than by static tables.
+ * A separate pool hands out the U-Procs' exception stacks in whole frames and
+ * arms a canary band at the bottom of each stack to detect overflow.
+ *
+ * Both the nucleus (interrupts already off) and the Support Level (interrupts on)
+ * allocate, so every operation runs with interrupts disabled.
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/05/20
+ *
+ *****************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/slab.h"
+#include "../h/smp.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+HIDDEN memaddr pageBump;                /* Next never-used frame */
+HIDDEN memaddr pageLimit;               /* First frame past the managed region */
+HIDDEN memaddr pageFree_h;              /* Returned frames, linked through their first word */
+HIDDEN int pagesFree;                   /* Frames on the free list */
+HIDDEN memaddr stackFree_h;             /* Returned stack blocks, linked through their first word */
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+/*
+ * Function     :   enterAllocator
+ * Purpose      :   Disable interrupts (and take the kernel lock, on a multiprocessor)
+ *                  and return the previous status so that leaveAllocator() can restore
+ *                  the caller's interrupt state
+ * Parameters   :   None
+ * Returns      :   The Status register before interrupts were disabled
+ */
+HIDDEN unsigned int enterAllocator(void) {
+    return lockNucleus();
+}
+
+/*
+ * Function     :   leaveAllocator
+ * Purpose      :   Release the kernel lock if enterAllocator() took it, and re-enable
+ *                  interrupts if (and only if) they were enabled on entry
+ * Parameters   :   status - value returned by enterAllocator()
+ * Returns      :   None
+ */
+HIDDEN void leaveAllocator(unsigned int status) {
+    unlockNucleus(status);
+}
+
+/******************************* PAGE ALLOCATOR *****************************/
+
+/*
+ * Function     :   initMemory
+ * Purpose      :   Hand every frame from PAGEPOOLSTART up to the frames reserved
+ *                  for boot stacks at the top of RAM to the page allocator
+ * Parameters   :   ramTop - first address past the end of RAM
+ * Returns      :   None
+ */
+void initMemory(memaddr ramTop) {
+    pageBump   = PAGEPOOLSTART;
+    pageLimit  = ramTop - (RESERVEDSTACKS * PAGESIZE);
+    pageFree_h = (memaddr) NULL;
+    pagesFree  = 0;
+    stackFree_h = (memaddr) NULL;
+}
+
+/*
+ * Function     :   allocPages
+ * Purpose      :   Carve pageCount contiguous frames off the never-used region.
+ *                  Meant for boot-time structures that are never freed
+ * Parameters   :   pageCount - number of contiguous frames
+ * Returns      :   Address of the first frame, or NULL if RAM is exhausted
+ */
+void *allocPages(int pageCount) {
+    unsigned int status = enterAllocator();
+    void *pages = NULL;
+
+    if ((pageCount > 0) && (pageBump + (pageCount * PAGESIZE) <= pageLimit)) {
+        pages = (void *) pageBump;
+        pageBump += pageCount * PAGESIZE;
+    }
+
+    leaveAllocator(status);
+    return pages;
+}
+
+/*
+ * Function     :   allocPage
+ * Purpose      :   Take one frame, preferring previously freed frames
+ * Parameters   :   None
+ * Returns      :   Address of the frame, or NULL if RAM is exhausted
+ */
+void *allocPage(void) {
+    unsigned int status = enterAllocator();
+    void *page = NULL;
+
+    if (pageFree_h != (memaddr) NULL) {
+        page = (void *) pageFree_h;
+        pageFree_h = *((memaddr *) pageFree_h);
+        pagesFree--;
+    } else if (pageBump + PAGESIZE <= pageLimit) {
+        page = (void *) pageBump;
+        pageBump += PAGESIZE;
+    }
+
+    leaveAllocator(status);
+    return page;
+}
+
+/*
+ * Function     :   freePage
+ * Purpose      :   Return one frame to the page allocator
+ * Parameters   :   page - address of the frame
+ * Returns      :   None
+ */
+void freePage(void *page) {
+    unsigned int status = enterAllocator();
+
+    *((memaddr *) page) = pageFree_h;
+    pageFree_h = (memaddr) page;
+    pagesFree++;
+
+    leaveAllocator(status);
+}
+
+/*
+ * Function     :   freePageCount
+ * Purpose      :   Report how many frames the page allocator can still hand out
+ * Parameters   :   None
+ * Returns      :   Number of free frames
+ */
+int freePageCount(void) {
+    return pagesFree + ((pageLimit - pageBump) / PAGESIZE);
+}
+
+/******************************* SLAB CACHES *****************************/
+
+/*
+ * Function     :   slabInit
+ * Purpose      :   Set up an empty cache for objects of objSize bytes. The object
+ *                  size is rounded up to a multiple of align; since slabs start on a
+ *                  frame boundary, every object is then align-aligned. A slab spans
+ *                  the fewest frames (up to SLABMAXPAGES) that waste less than 1/8 of it
+ * Parameters   :   cache - the cache descriptor
+ *                  objSize - size of one object in bytes
+ *                  align - object alignment in bytes (a power of two, at least WORDLEN)
+ * Returns      :   None
+ */
+void slabInit(slab_t *cache, int objSize, int align) {
+    cache->sl_free    = (memaddr) NULL;
+    cache->sl_objSize = (objSize + align - 1) & ~(align - 1);
+    cache->sl_inUse   = 0;
+    cache->sl_total   = 0;
+
+    /* Grow the slab until the tail left after the last object is small enough */
+    cache->sl_slabPages = 1;
+    while ((cache->sl_slabPages < SLABMAXPAGES) &&
+           (((cache->sl_slabPages * PAGESIZE) < cache->sl_objSize) ||
+            (((cache->sl_slabPages * PAGESIZE) % cache->sl_objSize) > ((cache->sl_slabPages * PAGESIZE) / 8)))) {
+        cache->sl_slabPages++;
+    }
+}
+
+/*
+ * Function     :   slabGrow
+ * Purpose      :   Take one slab from the page allocator and push all of its
+ *                  objects onto the cache's free list
+ * Parameters   :   cache - the cache descriptor
+ * Returns      :   TRUE if the cache grew, FALSE if RAM is exhausted
+ */
+HIDDEN int slabGrow(slab_t *cache) {
+    memaddr slab;
+    memaddr obj;
+
+    if (cache->sl_slabPages == 1) {
+        slab = (memaddr) allocPage();
+    } else {
+        slab = (memaddr) allocPages(cache->sl_slabPages);
+    }
+    if (slab == (memaddr) NULL) {
+        return FALSE;
+    }
+
+    for (obj = slab; obj + cache->sl_objSize <= slab + (cache->sl_slabPages * PAGESIZE); obj += cache->sl_objSize) {
+        *((memaddr *) obj) = cache->sl_free;
+        cache->sl_free = obj;
+        cache->sl_total++;
+    }
+    return TRUE;
+}
+
+/*
+ * Function     :   slabAlloc
+ * Purpose      :   Take an object from the cache, growing it by one slab if the
+ *                  free list is empty. The object's contents are undefined
+ * Parameters   :   cache - the cache descriptor
+ * Returns      :   Pointer to the object, or NULL if RAM is exhausted
+ */
+void *slabAlloc(slab_t *cache) {
+    unsigned int status = enterAllocator();
+    void *obj = NULL;
+
+    if ((cache->sl_free != (memaddr) NULL) || (slabGrow(cache) == TRUE)) {
+        obj = (void *) cache->sl_free;
+        cache->sl_free = *((memaddr *) cache->sl_free);
+        cache->sl_inUse++;
+    }
+
+    leaveAllocator(status);
+    return obj;
+}
+
+/*
+ * Function     :   slabFree
+ * Purpose      :   Return an object to its cache
+ * Parameters   :   cache - the cache descriptor
+ *                  obj - the object being freed
+ * Returns      :   None
+ */
+void slabFree(slab_t *cache, void *obj) {
+    unsigned int status = enterAllocator();
+
+    *((memaddr *) obj) = cache->sl_free;
+    cache->sl_free = (memaddr) obj;
+    cache->sl_inUse--;
+
+    leaveAllocator(status);
+}
+
+/******************************* EXCEPTION STACK POOL *****************************/
+
+/*
+ * Function     :   armGuard
+ * Purpose      :   Fill the guard band at the bottom of a stack with the canary
+ * Parameters   :   stackTop - first address past the stack
+ * Returns      :   None
+ */
+HIDDEN void armGuard(memaddr stackTop) {
+    unsigned int *guard = (unsigned int *) (stackTop - EXCSTACKSIZE);
+    int i;
+
+    for (i = 0; i < STACKGUARDSIZE / WORDLEN; i++) {
+        guard[i] = STACKCANARY;
+    }
+}
+
+/*
+ * Function     :   allocStacks
+ * Purpose      :   Take a U-Proc's stack block (EXCSTACKPAGES frames) from the pool and
+ *                  arm the guard bands of both stacks in it. The TLB stack's top is
+ *                  block + EXCSTACKSIZE, the general stack's top is block + 2*EXCSTACKSIZE
+ * Parameters   :   None
+ * Returns      :   Address of the block, or NULL if RAM is exhausted
+ */
+void *allocStacks(void) {
+    unsigned int status = enterAllocator();
+    memaddr block;
+
+    if (stackFree_h != (memaddr) NULL) {
+        block = stackFree_h;
+        stackFree_h = *((memaddr *) stackFree_h);
+    } else if (pageBump + (EXCSTACKPAGES * PAGESIZE) <= pageLimit) {
+        block = pageBump;
+        pageBump += EXCSTACKPAGES * PAGESIZE;
+    } else {
+        leaveAllocator(status);
+        return NULL;
+    }
+
+    leaveAllocator(status);
+
+    armGuard(block + EXCSTACKSIZE);
+    armGuard(block + (2 * EXCSTACKSIZE));
+    return (void *) block;
+}
+
+/*
+ * Function     :   freeStacks
+ * Purpose      :   Return a stack block to the pool. The link is stored in the TLB
+ *                  stack's guard band, which allocStacks() re-arms anyway
+ * Parameters   :   stackBlock - address returned by allocStacks()
+ * Returns      :   None
+ */
+void freeStacks(void *stackBlock) {
+    unsigned int status = enterAllocator();
+
+    *((memaddr *) stackBlock) = stackFree_h;
+    stackFree_h = (memaddr) stackBlock;
+
+    leaveAllocator(status);
+}
+
+/*
+ * Function     :   stackIntact
+ * Purpose      :   Check that a stack has not overflowed into its guard band
+ * Parameters   :   stackTop - first address past the stack
+ * Returns      :   TRUE if every canary word is intact, FALSE otherwise
+ */
+int stackIntact(memaddr stackTop) {
+    unsigned int *guard = (unsigned int *) (stackTop - EXCSTACKSIZE);
+    int i;
+
+    for (i = 0; i < STACKGUARDSIZE / WORDLEN; i++) {
+        if (guard[i] != STACKCANARY) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/******************************* END OF SLAB.c *****************************/
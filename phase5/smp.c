@@ -0,0 +1,402 @@
+/******************************* SMP.c ***************************************
+ *
+ * This module lets the nucleus run on NCPUS uMPS3 processors (build with -DNCPUS=n;
+ * the default of 1 compiles everything below down to the uniprocessor nucleus).
+ *  - Per-processor state: the running process, the ready queue, the dispatch TOD
+ *    and the other single-processor globals live in cpus[], indexed by PRID (see
+ *    smp.h), so each processor runs its own scheduler on its own ready queue.
+ *  - One big kernel lock: a processor takes it on every nucleus entry and releases
+ *    it on the way out (RESUME, or just before WAIT), so the handlers, the ASL, the
+ *    PCB tree and the slab allocator see one processor at a time, as before. Support
+ *    level code that used to disable interrupts for an atomic step takes it with
+ *    lockNucleus; a SYSCALL made while holding it hands it over to the nucleus, so
+ *    COMMAND + SYS5 stays atomic even when the device interrupts another processor.
+ *    The swap pool and the device registers keep their SYS30/SYS31 mutexes.
+ *  - Work stealing: a processor whose ready queue is empty takes the most urgent
+ *    process of the next processor with work. One with nothing to steal WAITs with
+ *    its PLT set to a time slice (IDLETIMER), and looks again when it fires.
+ *  - Termination: a process running on another processor cannot be freed under it,
+ *    so SYS2 only flags it; that processor frees it at its next nucleus entry, at
+ *    most TARGETLATENCY later: every slice is bounded here, even that of a process
+ *    alone on its processor (LONESLICE).
+ *  - TLB consistency: the TLBs are per processor. The pager bumps tlbEpoch after
+ *    invalidating a page, sends an inter-processor interrupt to every other processor
+ *    that both runs that ASID and still has an older TLB, and waits until each has
+ *    cleared it; every dispatch also clears the TLB if the epoch moved.
+ *  - Device interrupts and the Interval Timer are routed to the least busy
+ *    processor; every processor has its own nucleus stack and Pass Up Vector.
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/06/09
+ *
+ ***********************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/pcb.h"
+#include "../h/slab.h"
+#include "../h/initial.h"
+#include "../h/scheduler.h"
+#include "../h/exceptions.h"
+#include "../h/smp.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+percpu_t cpus[NCPUS];                           /* One entry per processor */
+unsigned int tlbEpoch;                          /* Bumped when a mapping may be stale in some TLB */
+
+#if NCPUS > 1
+HIDDEN volatile unsigned int kernelLock;        /* LOCKHELD while a processor is in the nucleus */
+HIDDEN state_t startStates[NCPUS];              /* Where INITCPU starts each processor */
+
+/******************************* EXTERNAL ELEMENTS *******************************/
+
+extern void generalExceptionHandler();          /* Given in initial.c */
+
+/******************************* FUNCTION DECLARATION *******************************/
+
+HIDDEN void cpuStart(void);
+#endif
+
+/******************************* INITIALIZATION *****************************/
+
+/*
+ * Function     :   initCPUs
+ * Purpose      :   Give every processor an empty ready queue and no running process.
+ *                  Called once by main, before the first process is created
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void initCPUs(void) {
+    int i;
+
+    for (i = 0; i < NCPUS; i++) {
+        cpus[i].pc_current      = NULL;
+        cpus[i].pc_readyQueue   = mkEmptyProcQ();
+        cpus[i].pc_readyCount   = 0;
+        cpus[i].pc_idleNesting  = 0;
+        cpus[i].pc_idling       = FALSE;
+        cpus[i].pc_runningGroup = NULL;
+        cpus[i].pc_rtProc       = NULL;
+        cpus[i].pc_lockDepth    = 0;
+        cpus[i].pc_reap         = FALSE;
+        cpus[i].pc_tlbEpoch     = 0;
+    }
+    tlbEpoch = 0;
+}
+
+/******************************* SUPPORT LEVEL LOCKING *****************************/
+
+/*
+ * Function     :   lockNucleus
+ * Purpose      :   Disable interrupts and, on a multiprocessor, take the kernel lock,
+ *                  for support level code that reads nucleus data or must not be
+ *                  interleaved with an interrupt (COMMAND + SYS5). Nests; a SYSCALL
+ *                  made with the lock held passes it to the nucleus, which releases it
+ * Parameters   :   None
+ * Returns      :   The Status register before interrupts were disabled
+ */
+unsigned int lockNucleus(void) {
+    unsigned int status = getSTATUS();
+
+    setSTATUS(status & IECOFF);
+#if NCPUS > 1
+    if (thisCPU.pc_lockDepth++ == 0) {
+        while (CAS((unsigned int *) &kernelLock, LOCKFREE, LOCKHELD) == FALSE) {
+            while (kernelLock != LOCKFREE) {
+                ;
+            }
+        }
+    }
+#endif
+    return status;
+}
+
+/*
+ * Function     :   unlockNucleus
+ * Purpose      :   Release what lockNucleus took, unless a SYSCALL in between already
+ *                  did, and re-enable interrupts if (and only if) status had them on
+ * Parameters   :   status - value returned by lockNucleus(), or IECON to re-enable
+ *                  interrupts unconditionally
+ * Returns      :   None
+ */
+void unlockNucleus(unsigned int status) {
+#if NCPUS > 1
+    if ((thisCPU.pc_lockDepth > 0) && (--thisCPU.pc_lockDepth == 0)) {
+        kernelLock = LOCKFREE;
+    }
+#endif
+    setSTATUS(getSTATUS() | (status & IECON));
+}
+
+#if NCPUS > 1
+
+/******************************* NUCLEUS LOCKING *****************************/
+
+/*
+ * Function     :   enterNucleus
+ * Purpose      :   Take the kernel lock on entry to the nucleus, unless this processor
+ *                  already holds it (a SYSCALL made inside lockNucleus)
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void enterNucleus(void) {
+    if (thisCPU.pc_lockDepth == 0) {
+        while (CAS((unsigned int *) &kernelLock, LOCKFREE, LOCKHELD) == FALSE) {
+            while (kernelLock != LOCKFREE) {
+                ;
+            }
+        }
+    }
+    thisCPU.pc_lockDepth = 1;
+}
+
+/*
+ * Function     :   leaveNucleus
+ * Purpose      :   Release the kernel lock before loading a process state or WAITing
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void leaveNucleus(void) {
+    thisCPU.pc_lockDepth = 0;
+    kernelLock = LOCKFREE;
+}
+
+/*
+ * Function     :   startCPUs
+ * Purpose      :   Route the Interval Timer and every device to the least busy processor,
+ *                  then give each other processor a nucleus stack (one frame) and a Pass
+ *                  Up Vector, and start it in cpuStart. Called by main with the kernel
+ *                  lock held, so they wait for it until the first dispatch
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void startCPUs(void) {
+    passupvector_t *pv;
+    memaddr stackTop;
+    int i;
+
+    /* 1. Dynamic interrupt routing over every processor in use */
+    for (i = 0; i < IRTENTRIES; i++) {
+        *((memaddr *) (IRTBASE + (i * WORDLEN))) = IRTDYNAMIC | ((1 << NCPUS) - 1);
+    }
+
+    /* 2. Start the other processors */
+    for (i = 1; i < NCPUS; i++) {
+        stackTop = ((memaddr) allocPage()) + PAGESIZE;
+
+        pv = (passupvector_t *) (PASSUPVECTOR + (i * PASSUPSTRIDE));
+        pv->tlb_refill_handler  = (memaddr) uTLB_RefillHandler;
+        pv->tlb_refill_stackPtr = stackTop;
+        pv->exception_handler   = (memaddr) generalExceptionHandler;
+        pv->exception_stackPtr  = stackTop;
+
+        startStates[i].s_status = ALLOFF;           /* kernel mode, interrupts disabled */
+        startStates[i].s_pc     = (memaddr) cpuStart;
+        startStates[i].s_t9     = (memaddr) cpuStart;
+        startStates[i].s_sp     = stackTop;
+        INITCPU(i, &startStates[i]);
+    }
+}
+
+/*
+ * Function     :   cpuStart
+ * Purpose      :   First code a secondary processor runs: enter the nucleus and schedule
+ * Parameters   :   None
+ * Returns      :   Never returns
+ */
+HIDDEN void cpuStart(void) {
+    enterNucleus();
+    scheduler();                /* This should never return */
+    PANIC();
+}
+
+/******************************* PROCESSES ON OTHER PROCESSORS *****************************/
+
+/*
+ * Function     :   reapTerminated
+ * Purpose      :   Called on every nucleus entry: if another processor terminated the
+ *                  process running here (see reapElsewhere), free it and schedule. An
+ *                  interrupt that brought us here stays pending and is taken later
+ * Parameters   :   None
+ * Returns      :   None (does not return if the process was freed)
+ */
+void reapTerminated(void) {
+    if (thisCPU.pc_reap) {
+        thisCPU.pc_reap = FALSE;
+        freePcb(currentProcess);
+        currentProcess = NULL;
+        scheduler();            /* This should never return */
+        PANIC();
+    }
+}
+
+/*
+ * Function     :   reapElsewhere
+ * Purpose      :   Called by SYS2 for each victim: if p is running on another processor,
+ *                  flag that processor to free it at its next nucleus entry
+ * Parameters   :   p - a terminated process, already off every queue and the tree
+ * Returns      :   TRUE if p will be freed elsewhere, FALSE if the caller frees it
+ */
+int reapElsewhere(pcb_PTR p) {
+    int i;
+
+    for (i = 0; i < NCPUS; i++) {
+        if ((i != CPUID()) && (cpus[i].pc_current == p)) {
+            cpus[i].pc_reap = TRUE;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*
+ * Function     :   onReadyQueue
+ * Purpose      :   Tell whether p waits on one of the processors' ready queues
+ * Parameters   :   p - the process
+ * Returns      :   TRUE if so
+ */
+int onReadyQueue(pcb_PTR p) {
+    int i;
+
+    for (i = 0; i < NCPUS; i++) {
+        if (p->p_queue == &(cpus[i].pc_readyQueue)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*
+ * Function     :   othersRunning
+ * Purpose      :   Tell whether another processor is running a process, which may make
+ *                  more work ready, so an idle processor with nothing to steal must wait
+ *                  rather than declare a deadlock
+ * Parameters   :   None
+ * Returns      :   TRUE if so
+ */
+int othersRunning(void) {
+    int i;
+
+    for (i = 0; i < NCPUS; i++) {
+        if ((i != CPUID()) && (cpus[i].pc_current != NULL)) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/******************************* WORK STEALING *****************************/
+
+/*
+ * Function     :   stealWork
+ * Purpose      :   Move the most urgent ready process of the next processor (in PRID
+ *                  order, starting after this one) that has any to this processor's
+ *                  ready queue. Starting after this processor spreads the thieves
+ * Parameters   :   None
+ * Returns      :   None (the ready queue is still empty if nobody had work)
+ */
+void stealWork(void) {
+    int me = CPUID();
+    int i, victim;
+
+    for (i = 1; i < NCPUS; i++) {
+        victim = (me + i) % NCPUS;
+        if (!emptyProcQ(cpus[victim].pc_readyQueue)) {
+            cpus[victim].pc_readyCount--;
+            makeReady(removeProcQ(&(cpus[victim].pc_readyQueue)));
+            return;
+        }
+    }
+}
+
+/******************************* TLB CONSISTENCY *****************************/
+
+/*
+ * Function     :   noteDispatch
+ * Purpose      :   Record the ASID about to run here and clear this processor's TLB if
+ *                  a page was invalidated (on any processor) since it was last cleared
+ * Parameters   :   p - the process being dispatched
+ * Returns      :   None
+ */
+void noteDispatch(pcb_PTR p) {
+    thisCPU.pc_asid = ((p->p_s.s_entryHI) >> ASIDSHIFT) & ASIDMASK;
+    if (thisCPU.pc_tlbEpoch != tlbEpoch) {
+        TLBCLR();
+        thisCPU.pc_tlbEpoch = tlbEpoch;
+    }
+}
+
+/*
+ * Function     :   ipiInterrupt
+ * Purpose      :   Handle an inter-processor interrupt (line 0). The only message sent is
+ *                  IPITLBFLUSH, from shootdownTLB: acknowledge it, clear this processor's
+ *                  TLB, record the epoch it is now current with, and resume the interrupted
+ *                  process (or look for one). Interrupts stay off in the nucleus, so no
+ *                  refill can reload a stale entry between the clear and the record
+ * Parameters   :   None
+ * Returns      :   None (does not return)
+ */
+void ipiInterrupt(void) {
+    *((memaddr *) IPIINBOX) = ALLOFF;
+    TLBCLR();
+    thisCPU.pc_tlbEpoch = tlbEpoch;
+
+    if (currentProcess != NULL) {
+        setTIMER(remainingTime);
+        RESUME(EXCSTATE);
+    }
+    scheduler();
+    PANIC();
+}
+
+/*
+ * Function     :   shootdownTLB
+ * Purpose      :   Called by the pager after it marked a page of asid invalid (and fixed
+ *                  its own TLB), before the frame is reused: bump tlbEpoch, send an
+ *                  IPITLBFLUSH to every other processor that runs asid on a TLB older than
+ *                  that, then wait until each has cleared it. The wait is one interrupt
+ *                  entry on those processors (or their next dispatch, if they are in the
+ *                  nucleus with interrupts off), not the rest of their slice, so the pager
+ *                  holds the Swap Pool mutex only briefly. A processor that runs another
+ *                  ASID clears its TLB before asid runs there (noteDispatch)
+ * Parameters   :   asid - ASID of the page's owner
+ * Returns      :   None
+ */
+void shootdownTLB(unsigned int asid) {
+    volatile percpu_t *other;
+    unsigned int status, epoch, recipients;
+    int i;
+
+    status = lockNucleus();
+    epoch = ++tlbEpoch;
+    unlockNucleus(status);
+
+    /* Interrupt every processor that may still map the page */
+    recipients = 0;
+    for (i = 0; i < NCPUS; i++) {
+        other = &cpus[i];
+        if ((i != CPUID()) && (other->pc_current != NULL) && (other->pc_asid == asid) &&
+            ((int) (other->pc_tlbEpoch - epoch) < 0)) {
+            recipients |= (1 << i);
+        }
+    }
+    if (recipients == 0) {
+        return;
+    }
+    *((memaddr *) IPIOUTBOX) = (recipients << IPIRECIPSHIFT) | IPITLBFLUSH;
+
+    /* Wait for each to clear its TLB (or to stop running asid) */
+    for (i = 0; i < NCPUS; i++) {
+        other = &cpus[i];
+        while (((recipients & (1 << i)) != 0) && (other->pc_current != NULL) &&
+               (other->pc_asid == asid) && ((int) (other->pc_tlbEpoch - epoch) < 0)) {
+            ;
+        }
+    }
+}
+
+#endif /* NCPUS > 1 */
+
+/******************************* END OF SMP.c *****************************/
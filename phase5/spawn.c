@@ -0,0 +1,82 @@
+/******************************* SPAWN.c ***************************************
+ *
+ * This module implements SYS27, which starts a new U-Proc on demand. a1 names
+ * the flash device holding the load image and a2 the block the image starts at.
+ * The device becomes the new U-Proc's backing store: text/data page i is paged
+ * from block (a2 + i), the stack from the device's last blocks down, exactly as
+ * for the U-Procs test() starts at boot from block 0. Nothing is read up front:
+ * the directory starts empty and the pager allocates tables and pages in the
+ * image on first touch. The new U-Proc is bound to the printer and terminal with
+ * its flash device's number, as at boot, and gets its own ASID from the same
+ * registry.
+ *
+ * The flash device must be installed and not home to (or referenced by) any
+ * live U-Proc, so a device whose U-Proc has terminated can be loaded with a new
+ * job and reused without rebooting the emulator.
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/06/05
+ *
+ ***********************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/initProc.h"
+#include "../h/vmSupport.h"
+#include "../h/spawn.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+/******************************* SYSCALL IMPLEMENTATION *******************************/
+
+/*
+ * Function     :   spawnUserProcess
+ * Purpose      :   Implement SYS27 to start a U-Proc from the load image at block a2
+ *                  of flash device a1. It builds a support structure, registers its
+ *                  address space (which checks the device and offset) and has test()
+ *                  create it
+ * Parameters   :   savedState - pointer to the user's saved processor state
+ * Returns      :   None (v0 holds the new U-Proc's ASID, or -1 if the device or
+ *                  offset is not usable or RAM, ASIDs or processes ran out)
+ */
+void spawnUserProcess(state_PTR savedState) {
+    /* ------------------------------------------------------------ *
+     * 0. Initialize Local Variables
+     * ------------------------------------------------------------ */
+    int flashDev = savedState->s_a1;                        /* device holding the image */
+    int blockBase = savedState->s_a2;                       /* block the image starts at */
+    support_t *supportStruct;                               /* new U-Proc's support structure */
+    state_t initialState;                                   /* its initial state */
+    int asid;                                               /* its ASID */
+
+    /* ------------------------------------------------------------ *
+     * 1. Build the support structure and claim the device
+     * ------------------------------------------------------------ */
+    if ((flashDev < 0) || (flashDev >= DEVPERINT) ||
+        ((supportStruct = newSupport(flashDev, flashDev, flashDev)) == NULL)) {
+        savedState->s_v0 = -1;
+        LDST(savedState);
+    }
+    supportStruct->sup_blockBase = blockBase;
+
+    asid = registerAddressSpace(supportStruct);
+    if (asid < 0) {
+        freeSupport(supportStruct);
+        savedState->s_v0 = -1;
+        LDST(savedState);
+    }
+
+    /* ------------------------------------------------------------ *
+     * 2. Have test() create it at the start of its image
+     * ------------------------------------------------------------ */
+    initialUProcState(&initialState, asid);
+    if (launchUProc(&initialState, supportStruct) != CREATESUCCESS) {
+        releaseAddressSpace(supportStruct);
+        freeSupport(supportStruct);
+        asid = -1;
+    }
+
+    savedState->s_v0 = asid;
+    LDST(savedState);
+}
+
+/******************************* END OF SPAWN.c *****************************/
@@ -0,0 +1,241 @@
+/******************************* SYSBENCH.c ***************************************
+ * 
+ * This module implements a microbenchmark for the nucleus syscall path. A
+ * kernel-mode process (SYS8 is only legal in kernel mode) issues BENCHCALLS
+ * SYS8 calls back to back, reads the raw TOD clock around the loop and reports
+ * the average cost per call, in processor cycles, on terminal BENCHTERM. An
+ * empty loop of the same length is timed too and subtracted, so the figure is
+ * the cost of the trap, dispatch and return alone. It then builds a chain of
+ * BENCHKILLDEPTH kernel-mode processes, each the only child of the previous
+ * one and blocked on a semaphore, has the root SYS2 itself, and reports the
+ * teardown cost the nucleus recorded in killTime.
+ *
+ * The module is compiled to nothing unless the kernel is built with -DSYSBENCH.
+ * 
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/05/26
+ * 
+ ***********************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/initProc.h"
+#include "../h/slab.h"
+#include "../h/sysBench.h"
+#include "../h/exceptions.h"
+#include "../h/smp.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+#ifdef SYSBENCH
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+HIDDEN int benchDone;                   /* V'ed by the benchmark process when it has reported */
+
+HIDDEN state_t nodeState;               /* initial state of the next chain member (built one at a time) */
+HIDDEN memaddr nodeStacks;              /* BENCHKILLDEPTH stacks of BENCHKILLSTACK bytes */
+HIDDEN int nodesBuilt;                  /* chain members created so far */
+HIDDEN int chainReady;                  /* V'ed by the last chain member */
+HIDDEN int chainGo;                     /* V'ed by the benchmark to have the root kill the chain */
+HIDDEN int chainHold;                   /* where the chain members block */
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+/*
+ * Function     :   readCycles
+ * Purpose      :   Read the raw TOD clock, which advances once per processor cycle
+ * Parameters   :   None
+ * Returns      :   The low word of the TOD clock
+ */
+HIDDEN unsigned int readCycles(void) {
+    return *((unsigned int *) TODLOADDR);
+}
+
+/*
+ * Function     :   benchPrint
+ * Purpose      :   Write a string to terminal BENCHTERM, one character per SYS5,
+ *                  holding the terminal's transmitter semaphore throughout
+ * Parameters   :   msg - the NUL-terminated string
+ * Returns      :   None
+ */
+HIDDEN void benchPrint(char *msg) {
+    devregarea_t *devRegArea = (devregarea_t *) RAMBASEADDR;
+    int index = ((TERMINT - OFFSET) * DEVPERINT) + BENCHTERM;
+
+    SYSCALL(SYS30CALL, (unsigned int) &devSemaphores[index + DEVPERINT], 0, 0);
+    while (*msg != EOS) {
+        /* Disable interrupts (and hold the kernel lock) so that COMMAND + SYS5 is atomic */
+        lockNucleus();
+        devRegArea->devreg[index].t_transm_command = (((unsigned int) *msg) << TERMINALSHIFT) | TRANSMITCHAR;
+        SYSCALL(SYS5CALL, TERMINT, BENCHTERM, FALSE);
+        unlockNucleus(IECON);
+        msg++;
+    }
+    SYSCALL(SYS31CALL, (unsigned int) &devSemaphores[index + DEVPERINT], 0, 0);
+}
+
+/*
+ * Function     :   benchPrintNumber
+ * Purpose      :   Write an unsigned decimal number to terminal BENCHTERM
+ * Parameters   :   value - the number
+ * Returns      :   None
+ */
+HIDDEN void benchPrintNumber(unsigned int value) {
+    char digits[11];
+    int i = 10;
+
+    digits[i] = EOS;
+    do {
+        digits[--i] = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0);
+    benchPrint(&digits[i]);
+}
+
+/******************************* CHAIN MEMBERS *****************************/
+
+/*
+ * Function     :   spawnNode
+ * Purpose      :   Create the next chain member as a kernel-mode process running code
+ *                  on the next free stack, as a child of the caller
+ * Parameters   :   code - the member's entry point
+ * Returns      :   None
+ */
+HIDDEN void spawnNode(void (*code)(void)) {
+    nodesBuilt++;
+    nodeState.s_pc = nodeState.s_t9 = (memaddr) code;
+    nodeState.s_sp      = nodeStacks + (nodesBuilt * BENCHKILLSTACK);
+    nodeState.s_status  = ALLOFF | IEPON | IMON | PLTON;
+    nodeState.s_entryHI = ALLOFF | (DELAYASID << ASIDSHIFT);
+    SYSCALL(SYS1CALL, (unsigned int) &nodeState, (unsigned int) NULL, 0);
+}
+
+/*
+ * Function     :   chainNode
+ * Purpose      :   Extend the chain by one member (or, as the last member, V
+ *                  chainReady), then block for good
+ * Parameters   :   None
+ * Returns      :   None
+ */
+HIDDEN void chainNode(void) {
+    if (nodesBuilt < BENCHKILLDEPTH) {
+        spawnNode(chainNode);
+    } else {
+        SYSCALL(SYS4CALL, (unsigned int) &chainReady, 0, 0);
+    }
+    SYSCALL(SYS3CALL, (unsigned int) &chainHold, 0, 0);
+}
+
+/*
+ * Function     :   chainRoot
+ * Purpose      :   Start the chain below it, wait for chainGo, then terminate
+ *                  itself and with it the whole chain
+ * Parameters   :   None
+ * Returns      :   None
+ */
+HIDDEN void chainRoot(void) {
+    spawnNode(chainNode);
+    SYSCALL(SYS3CALL, (unsigned int) &chainGo, 0, 0);
+    SYSCALL(SYS2CALL, 0, 0, 0);
+}
+
+/******************************* BENCHMARK PROCESS *****************************/
+
+/*
+ * Function     :   sysBench
+ * Purpose      :   Time BENCHCALLS SYS8 calls against an empty loop of the same
+ *                  length and report cycles per call; then have a BENCHKILLDEPTH
+ *                  process chain killed and report the teardown's cycles. Finally
+ *                  V benchDone and terminate
+ * Parameters   :   None
+ * Returns      :   None
+ */
+HIDDEN void sysBench(void) {
+    unsigned int start, loopCycles, callCycles;
+    volatile int sink = 0;
+    int i;
+
+    /* 1. Loop overhead */
+    start = readCycles();
+    for (i = 0; i < BENCHCALLS; i++) {
+        sink += i;
+    }
+    loopCycles = readCycles() - start;
+
+    /* 2. The same loop around SYS8 */
+    start = readCycles();
+    for (i = 0; i < BENCHCALLS; i++) {
+        sink += SYSCALL(SYS8CALL, 0, 0, 0);
+    }
+    callCycles = readCycles() - start;
+
+    /* 3. Report */
+    benchPrint("SYS8 x ");
+    benchPrintNumber(BENCHCALLS);
+    benchPrint(": ");
+    benchPrintNumber((callCycles - loopCycles) / BENCHCALLS);
+    benchPrint(" cycles/call\n");
+
+    /* 4. Build the chain and wait until its last member is blocked */
+    nodeStacks = (memaddr) allocPages((BENCHKILLDEPTH * BENCHKILLSTACK) / PAGESIZE);
+    if (nodeStacks != (memaddr) NULL) {
+        nodesBuilt = 0;
+        spawnNode(chainRoot);
+        SYSCALL(SYS3CALL, (unsigned int) &chainReady, 0, 0);
+
+        /* 5. Release the root, and spin until its SYS2 has been recorded */
+        killCount = 0;
+        SYSCALL(SYS4CALL, (unsigned int) &chainGo, 0, 0);
+        while (*((volatile int *) &killCount) == 0) {
+            ;
+        }
+
+        /* 6. Report; the stacks are not returned, as with this process's own */
+        benchPrint("SYS2 of a ");
+        benchPrintNumber(killCount);
+        benchPrint("-process chain: ");
+        benchPrintNumber(killTime);
+        benchPrint(" cycles, ");
+        benchPrintNumber(killTime / killCount);
+        benchPrint(" cycles/process\n");
+    }
+
+    SYSCALL(SYS4CALL, (unsigned int) &benchDone, 0, 0);
+    SYSCALL(SYS2CALL, 0, 0, 0);
+}
+
+/******************************* EXTERNAL ELEMENTS *****************************/
+
+/*
+ * Function     :   launchSysBench
+ * Purpose      :   Create the benchmark as a kernel-mode process (no support structure,
+ *                  interrupts and PLT on, ASID 0) on a stack frame from the page
+ *                  allocator, and block until it has reported. Under a benchmark
+ *                  build, the frame is given up for good
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void launchSysBench(void) {
+    state_t benchState;
+    memaddr stackPage = (memaddr) allocPage();
+
+    if (stackPage == (memaddr) NULL) {
+        return;
+    }
+
+    benchDone = 0;
+    benchState.s_pc = benchState.s_t9 = (memaddr) sysBench;
+    benchState.s_sp      = stackPage + PAGESIZE;
+    benchState.s_status  = ALLOFF | IEPON | IMON | PLTON;
+    benchState.s_entryHI = ALLOFF | (DELAYASID << ASIDSHIFT);
+
+    if (SYSCALL(SYS1CALL, (unsigned int) &benchState, (unsigned int) NULL, 0) == CREATESUCCESS) {
+        SYSCALL(SYS3CALL, (unsigned int) &benchDone, 0, 0);
+    }
+
+    /* The stack frame is not returned: the benchmark may still be on it between its V and its SYS2 */
+}
+
+#endif /* SYSBENCH */
+
+/******************************* END OF SYSBENCH.c *****************************/
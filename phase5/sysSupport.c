@@ -3,8 +3,9 @@
  * This module implements the Support Level's system call handlers for user process in the Pandos kernal. 
  * It provides:
  *  - SYS9  :   terminateUserProcess
- *              Terminate a U-Proc by releasing any device semaphores it holds, signaling InitProc's
- *              masterSemaphore, then invoking the kernel's SYS2 to terminate the process and its progeny
+ *              Terminate a U-Proc by releasing any device semaphores it holds and its address space,
+ *              signaling InitProc's masterSemaphore, then invoking the kernel's SYS2 to terminate the
+ *              process and its progeny
  *  - SYS10 :   Return the number of microseconds since system boot to the U‑Proc
  *  - SYS11 :   Perform mutual‑exclusion protected output of a user‑supplied string to the printer, 
  *              character by character; validate parameters and propagate any device errors
@@ -34,6 +35,15 @@
 #include "../h/sysSupport.h"
 #include "../h/deviceSupportDMA.h"
 #include "../h/delayDaemon.h"
+#include "../h/slab.h"
+#include "../h/trace.h"
+#include "../h/profile.h"
+#include "../h/utilization.h"
+#include "../h/smp.h"
+#include "../h/fork.h"
+#include "../h/spawn.h"
+#include "../h/zswap.h"
+#include "../h/loadControl.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /******************************* FUNCTION DECLARATIONS *******************************/ 
@@ -53,15 +63,20 @@ extern void flashGet(support_t *currentSupportStruct);
 
 /* Phase 5 */
 extern void delay(support_t *currentSupportStruct);                                   /* SYS18 */
+HIDDEN void setUserTickets(state_PTR savedState);                                     /* SYS23 */
+HIDDEN void setUserRealTime(state_PTR savedState);                                    /* SYS24 */
+HIDDEN void getUserDeadlineMisses(state_PTR savedState);                              /* SYS25 */
 
 /******************************* SYSCALL IMPLEMENTATIONS *******************************/
 
 /* 
  * Function     :   terminateUserProcess
  * Purpose      :   Implement SYS9 to terminate a User Process. First, it will release 
- *                  any device semaphores held by the U-proc. Then, it performs a V operation
- *                  on the masterSemaphore so InitProc can wake up and reclaim resources.
- *                  Finally, it invokes a SYS2 to terminate this U-Proc and its progeny
+ *                  any device semaphores held by the U-proc and free its Swap Pool frames
+ *                  and page tables. Then, it performs a V operation on the masterSemaphore
+ *                  so InitProc can wake up and reclaim resources.
+ *                  Finally, it returns its exception stacks and support structure to
+ *                  their pools and invokes a SYS2 to terminate this U-Proc and its progeny
  * Parameters   :   currentSupportStruct - pointer to the support structure of the U-Proc to be terminated
  * Returns      :   None
  */
@@ -70,7 +85,7 @@ void terminateUserProcess(support_t *currentSupportStruct)
     /* ---------------------------------------------------------- *
      * 0.  Declare local variable
      * ---------------------------------------------------------- */
-    int asid = currentSupportStruct->sup_asid;   /* 1‑8 */
+    int deviceNum;                               /* Device this U-Proc is bound to on the line */
 
     /* ---------------------------------------------------------- *
      * 1. Release all device semaphores this U-Proc may hold
@@ -78,21 +93,38 @@ void terminateUserProcess(support_t *currentSupportStruct)
     int line;
     /* Plus 1 since for each terminal, there are a transmitter and a receiver */
     for (line = 0; line < DEVTYPES + 1; line++) {
-        int index = (line * DEVPERINT) + (asid - 1);
-        if (devSemaphores[index] == 0) {
-            /* Release it */
-            SYSCALL(SYS4CALL, (unsigned int) &devSemaphores[index], 0, 0);
+        if (line == PRNTINT - OFFSET) {
+            deviceNum = currentSupportStruct->sup_printerDev;
+        } else if (line >= TERMINT - OFFSET) {
+            deviceNum = currentSupportStruct->sup_termDev;
+        } else {
+            deviceNum = currentSupportStruct->sup_flashDev;
         }
+        int index = (line * DEVPERINT) + deviceNum;
+        /* Release it if this U-Proc holds it: SYS31 refuses (v0 = -1) to unlock a
+           mutex held by another process, or one that is free */
+        SYSCALL(SYS31CALL, (unsigned int) &devSemaphores[index], 0, 0);
     }
 
     /* ---------------------------------------------------------- *
-     * 2. V the masterSemaphore so InitProc can wake up
+     * 2. Free the U-Proc's Swap Pool frames and page tables
+     * ---------------------------------------------------------- */
+    releaseAddressSpace(currentSupportStruct);
+
+    /* ---------------------------------------------------------- *
+     * 3. V the masterSemaphore so InitProc can wake up
      * ---------------------------------------------------------- */
     SYSCALL(SYS4CALL, (unsigned int) &masterSemaphore, 0, 0);
 
     /* ---------------------------------------------------------- *
-     * 3. Finally, invoke SYS2 to terminate this U-Proc
+     * 4. Return the stacks and support structure and invoke SYS2
      * ---------------------------------------------------------- */
+    /* NOTE: Interrupts stay off, and the kernel lock held (SYS2 inherits it), so
+     * nothing can reuse the structure (and the stack we are running on) before the
+     * nucleus removes this U-Proc */
+    lockNucleus();
+    freeStacks((void *) (currentSupportStruct->sup_exceptContext[PGFAULTEXCEPT].c_stackPtr - EXCSTACKSIZE));
+    slabFree(&supportCache, currentSupportStruct);
     SYSCALL(SYS2CALL, 0, 0, 0);                         /* never returns */
 }
 
@@ -121,6 +153,44 @@ void getTOD(state_PTR savedState) {
     LDST(savedState); 
 }
 
+/*
+ * Function     :   setUserTickets
+ * Purpose      :   Implement SYS23 to set the calling U-Proc's stride tickets to a1,
+ *                  through the nucleus's SYS32. A U-Proc's tickets are also its
+ *                  group's share, so this moves cpu time between U-Procs.
+ * Parameters   :   savedState - pointer to the user's saved processor state
+ * Returns      :   None (v0 holds the previous tickets)
+ */
+void setUserTickets(state_PTR savedState) {
+    savedState->s_v0 = SYSCALL(SYS32CALL, savedState->s_a1, FALSE, 0);
+    LDST(savedState);
+}
+
+/*
+ * Function     :   setUserRealTime
+ * Purpose      :   Implement SYS24 to put the calling U-Proc in the real-time class with
+ *                  period a1 and budget a2 (microseconds), or take it out (a1 = 0),
+ *                  through the nucleus's SYS33
+ * Parameters   :   savedState - pointer to the user's saved processor state
+ * Returns      :   None (v0 holds 0, or -1 if the reservation was refused)
+ */
+void setUserRealTime(state_PTR savedState) {
+    savedState->s_v0 = SYSCALL(SYS33CALL, savedState->s_a1, savedState->s_a2, 0);
+    LDST(savedState);
+}
+
+/*
+ * Function     :   getUserDeadlineMisses
+ * Purpose      :   Implement SYS25 to return the calling U-Proc's deadline misses, or
+ *                  with a1 TRUE those of every process, through the nucleus's SYS34
+ * Parameters   :   savedState - pointer to the user's saved processor state
+ * Returns      :   None (v0 holds the count)
+ */
+void getUserDeadlineMisses(state_PTR savedState) {
+    savedState->s_v0 = SYSCALL(SYS34CALL, savedState->s_a1, 0, 0);
+    LDST(savedState);
+}
+
 /*
  * Function     :   writeToPrinter
  * Purpose      :   Implement SYS11 to write a user-supplied string to the printer.
@@ -169,8 +239,8 @@ void writeToPrinter(state_PTR savedState, support_t *currentSupportStruct) {
     /* Pointer to device register area */
     devregarea_t *devRegArea = (devregarea_t *) RAMBASEADDR;
 
-    /* Get the processor number from the ASID stored in the support struct */
-    deviceNum = currentSupportStruct->sup_asid - 1;                /* Subtract 1 to get an index 0..7 */
+    /* Get the printer this U-Proc is bound to from its support struct */
+    deviceNum = currentSupportStruct->sup_printerDev;
 
     /* Compute the index into the device register array */
     index = ((PRNTINT - OFFSET) * DEVPERINT) + deviceNum;            
@@ -178,15 +248,15 @@ void writeToPrinter(state_PTR savedState, support_t *currentSupportStruct) {
     /* ------------------------------------------------------------ *
      * 4. Gain mutual exclusion over the device 
      * ------------------------------------------------------------ */
-    SYSCALL(SYS3CALL, (unsigned int) &devSemaphores[index], 0, 0);
+    SYSCALL(SYS30CALL, (unsigned int) &devSemaphores[index], 0, 0);
 
     /* ------------------------------------------------------------ *
      * 5. Transmit each character to the printer
      * ------------------------------------------------------------ */
     int i;
     for (i = 0; i < stringLength; i++) {
-        /* Disable interrupt so that COMMAND + SYS5 is atomic */
-        setSTATUS(getSTATUS() & IECOFF);
+        /* Disable interrupts (and hold the kernel lock) so that COMMAND + SYS5 is atomic */
+        lockNucleus();
 
         /* Write the character to DATA0, issue the transmit command in COMMAND */
         devRegArea->devreg[index].d_data0   = *(virtualAddress + i);
@@ -196,7 +266,7 @@ void writeToPrinter(state_PTR savedState, support_t *currentSupportStruct) {
         status = SYSCALL(SYS5CALL, PRNTINT, deviceNum, FALSE);
 
         /* Re-enable interrupts now that the atomic operation is complete */
-        setSTATUS(getSTATUS() | IECON);
+        unlockNucleus(IECON);
 
         /* Mask off low byte to get status code from device status */
         statusCode = status & STATUSMASK ;
@@ -206,7 +276,7 @@ void writeToPrinter(state_PTR savedState, support_t *currentSupportStruct) {
             savedState->s_v0 = -1 * statusCode;
 
             /* Release the device semaphore */
-            SYSCALL(SYS4CALL, (unsigned int) &devSemaphores[index], 0, 0);
+            SYSCALL(SYS31CALL, (unsigned int) &devSemaphores[index], 0, 0);
 
             /* Return control to the instruction after SYSCALL instruction */
             LDST(savedState);
@@ -221,7 +291,7 @@ void writeToPrinter(state_PTR savedState, support_t *currentSupportStruct) {
     /* ------------------------------------------------------------ *
      * 7. Release device semaphore
      * ------------------------------------------------------------ */
-    SYSCALL(SYS4CALL, (unsigned int) &devSemaphores[index], 0, 0); 
+    SYSCALL(SYS31CALL, (unsigned int) &devSemaphores[index], 0, 0); 
 
     /* ------------------------------------------------------------ *
      * 8. Return control to the instruction after SYSCALL instruction
@@ -278,8 +348,8 @@ void writeToTerminal(state_PTR savedState, support_t *currentSupportStruct) {
    /* Pointer to device register area */
     devregarea_t *devRegArea = (devregarea_t *) RAMBASEADDR;
 
-    /* Get the processor number from the ASID stored in the support struct */
-    deviceNum = currentSupportStruct->sup_asid - 1;                /* Subtract 1 to get an index 0..7 */
+    /* Get the terminal this U-Proc is bound to from its support struct */
+    deviceNum = currentSupportStruct->sup_termDev;
 
     /* Compute the index into the device register array */
     index = ((TERMINT - OFFSET) * DEVPERINT) + deviceNum;
@@ -288,15 +358,15 @@ void writeToTerminal(state_PTR savedState, support_t *currentSupportStruct) {
      * 4. Gain mutual exclusion over the device 
      * ------------------------------------------------------------ */
    /* Note that the transmitter is DEVPERINT (8) index behind the receiver */
-    SYSCALL(SYS3CALL, (unsigned int) &devSemaphores[index + DEVPERINT], 0, 0);   
+    SYSCALL(SYS30CALL, (unsigned int) &devSemaphores[index + DEVPERINT], 0, 0);   
 
     /* ------------------------------------------------------------ *
      * 5. Transmit each character to the terminal
      * ------------------------------------------------------------ */
     int i;
     for (i = 0; i < stringLength; i++) {
-        /* Disable interrupt so that COMMAND + SYS5 is atomic */
-        setSTATUS(getSTATUS() & IECOFF);
+        /* Disable interrupts (and hold the kernel lock) so that COMMAND + SYS5 is atomic */
+        lockNucleus();
 
         /* Place the transmit char and transmit command into TRANSM_FIELD */
         devRegArea->devreg[index].t_transm_command = (*(virtualAddress + i) << TERMINALSHIFT) | TRANSMITCHAR;
@@ -305,7 +375,7 @@ void writeToTerminal(state_PTR savedState, support_t *currentSupportStruct) {
         status = SYSCALL(SYS5CALL, TERMINT, deviceNum, FALSE);
 
         /* Re-enable interrupts now that the atomic operation is complete */
-        setSTATUS(getSTATUS() | IECON);
+        unlockNucleus(IECON);
 
         /* Mask off low byte to get status code from device status */
         statusCode = status & STATUSMASK;
@@ -315,7 +385,7 @@ void writeToTerminal(state_PTR savedState, support_t *currentSupportStruct) {
             savedState->s_v0 = -1 * statusCode;
 
             /* Release the device semaphore */
-            SYSCALL(SYS4CALL, (unsigned int) &devSemaphores[index + DEVPERINT], 0, 0);
+            SYSCALL(SYS31CALL, (unsigned int) &devSemaphores[index + DEVPERINT], 0, 0);
 
             /* Return control to the instruction after SYSCALL instruction */
             LDST(savedState);
@@ -330,7 +400,7 @@ void writeToTerminal(state_PTR savedState, support_t *currentSupportStruct) {
     /* ------------------------------------------------------------ *
      * 7. Release device semaphore
      * ------------------------------------------------------------ */
-    SYSCALL(SYS4CALL, (unsigned int) &devSemaphores[index + DEVPERINT], 0, 0);
+    SYSCALL(SYS31CALL, (unsigned int) &devSemaphores[index + DEVPERINT], 0, 0);
 
     /* ------------------------------------------------------------ *
      * 8. Return control to the instruction after SYSCALL instruction
@@ -386,8 +456,8 @@ void readFromTerminal(state_PTR savedState, support_t *currentSupportStruct) {
     /* Pointer to device register area */
     devregarea_t *devRegArea = (devregarea_t *) RAMBASEADDR;
 
-    /* Get the processor number from the ASID stored in the support struct */
-    deviceNum = currentSupportStruct->sup_asid - 1;                /* Subtract 1 to get an index 0..7 */
+    /* Get the terminal this U-Proc is bound to from its support struct */
+    deviceNum = currentSupportStruct->sup_termDev;
 
     /* Compute the index into the device register array */
     index = ((TERMINT - OFFSET) * DEVPERINT) + deviceNum;            
@@ -395,7 +465,7 @@ void readFromTerminal(state_PTR savedState, support_t *currentSupportStruct) {
     /* ------------------------------------------------------------ *
     * 4. Gain mutual exclusion over the device 
     * ------------------------------------------------------------ */
-    SYSCALL(SYS3CALL, (unsigned int) &devSemaphores[index], 0, 0);
+    SYSCALL(SYS30CALL, (unsigned int) &devSemaphores[index], 0, 0);
 
     /* ------------------------------------------------------------ *
     * 5. Read each character from the terminal
@@ -406,8 +476,8 @@ void readFromTerminal(state_PTR savedState, support_t *currentSupportStruct) {
     /* Loop until reach EOL ("\n") character or error signal from the terminal  */
     int currentChar;                       /* Char just read from the terminal */
     do {
-        /* Disable interrupts so that COMMAND + SYS5 is atomic */
-        setSTATUS(getSTATUS() & IECOFF);
+        /* Disable interrupts (and hold the kernel lock) so that COMMAND + SYS5 is atomic */
+        lockNucleus();
 
         /* Write the receive command in COMMAND */
         devRegArea->devreg[index].t_recv_command = RECEIVECHAR;
@@ -416,7 +486,7 @@ void readFromTerminal(state_PTR savedState, support_t *currentSupportStruct) {
         status = SYSCALL(SYS5CALL, TERMINT, deviceNum, TRUE);
 
         /* Re-enable interrupts now that the atomic operation is complete */
-        setSTATUS(getSTATUS() | IECON);
+        unlockNucleus(IECON);
 
         /* Mask off low byte to get status code from device status */
         statusCode = status & STATUSMASK;
@@ -427,7 +497,7 @@ void readFromTerminal(state_PTR savedState, support_t *currentSupportStruct) {
             savedState->s_v0 = -1 * statusCode;
 
             /* Release the device semaphore */
-            SYSCALL(SYS4CALL, (unsigned int) &devSemaphores[index], 0, 0);
+            SYSCALL(SYS31CALL, (unsigned int) &devSemaphores[index], 0, 0);
 
             /* Return control to the instruction after SYSCALL instruction */
             LDST(savedState);
@@ -458,7 +528,7 @@ void readFromTerminal(state_PTR savedState, support_t *currentSupportStruct) {
     /* ------------------------------------------------------------ *
      * 7. Release device semaphore
      * ------------------------------------------------------------ */
-    SYSCALL(SYS4CALL, (unsigned int) &devSemaphores[index], 0, 0); 
+    SYSCALL(SYS31CALL, (unsigned int) &devSemaphores[index], 0, 0); 
 
     /* ------------------------------------------------------------ *
      * 8. Return control to the instruction after SYSCALL instruction
@@ -469,17 +539,21 @@ void readFromTerminal(state_PTR savedState, support_t *currentSupportStruct) {
 /*
  * Function     :   VMgeneralExceptionHandler
  * Purpose      :   Top-level support exception dispatcher for U-Procs.
- *                  Retrieves the current process's support structure and saved
- *                  state, decodes the exception code, and routes the exception
- *                  to either syscall or program trap handler
- * Parameters   :   None
+ *                  Takes the current process's support structure (passed in a0
+ *                  by the nucleus, so no SYS8 is needed) and saved state, decodes
+ *                  the exception code, and routes the exception to either syscall
+ *                  or program trap handler
+ * Parameters   :   currentSupportStruct - the current U-Proc's support structure
  * Returns      :   None
  */
-void VMgeneralExceptionHandler(void) {
+void VMgeneralExceptionHandler(support_t *currentSupportStruct) {
     /* ---------------------------------------------------------- *
-     * 1. Invoke SYS8 to get the support structure 
+     * 1. Check the stack the nucleus handed us
      * ---------------------------------------------------------- */
-    support_t *currentSupportStruct = (support_t *) SYSCALL(SYS8CALL, 0, 0, 0);
+    /* A handler that overran this stack last time has clobbered the guard band: treat as a trap */
+    if (stackIntact(currentSupportStruct->sup_exceptContext[GENERALEXCEPT].c_stackPtr) == FALSE) {
+        VMprogramTrapExceptionHandler(currentSupportStruct);
+    }
 
     /* ---------------------------------------------------------- *
      * 2. Retrieve processor state at time of exception
@@ -515,6 +589,18 @@ void VMgeneralExceptionHandler(void) {
  *                      - SYS11   -> writeToPrinter
  *                      - SYS12   -> writeToTerminal
  *                      - SYS13   -> readFromTerminal
+ *                      - SYS14-18 -> DMA disk/flash transfers and delay
+ *                      - SYS19   -> dumpTrace
+ *                      - SYS20   -> exportProfile
+ *                      - SYS21   -> getUtilization
+ *                      - SYS22   -> getInterruptStats
+ *                      - SYS23   -> setUserTickets
+ *                      - SYS24   -> setUserRealTime
+ *                      - SYS25   -> getUserDeadlineMisses
+ *                      - SYS26   -> forkUserProcess
+ *                      - SYS27   -> spawnUserProcess
+ *                      - SYS28   -> getSwapStats
+ *                      - SYS29   -> setLoadControl
  *                      - default -> treat as program trap and call program trap handler
  * Parameters   :   savedState - pointer to the saved processor state
  *                  currentSupportStruct - user’s support struct (holds a1, a2 in its state)
@@ -531,6 +617,7 @@ void VMsyscallExceptionHandler(state_PTR savedState, support_t *currentSupportSt
      * 2. Read the SYSCALL number from register a0
      * ------------------------------------------------------------ */
     int sysNum = savedState->s_a0;
+    SUPTRACE(TRSUPSYSCALL, currentSupportStruct->sup_asid, sysNum, savedState->s_a1);
 
     /* ------------------------------------------------------------ *
      * 3. Route to the appropriate handler
@@ -587,6 +674,61 @@ void VMsyscallExceptionHandler(state_PTR savedState, support_t *currentSupportSt
             delay(currentSupportStruct);
             break;
 
+        case SYS19CALL:
+            /* SYS19: Copy the kernel trace ring to the user */
+            dumpTrace(savedState, currentSupportStruct);
+            break;
+
+        case SYS20CALL:
+            /* SYS20: Copy the PC sampling profile to the user */
+            exportProfile(savedState, currentSupportStruct);
+            break;
+
+        case SYS21CALL:
+            /* SYS21: Report CPU utilization over the last N pseudo-clock ticks */
+            getUtilization(savedState, currentSupportStruct);
+            break;
+
+        case SYS22CALL:
+            /* SYS22: Copy the peripheral interrupt counters to the user */
+            getInterruptStats(savedState, currentSupportStruct);
+            break;
+
+        case SYS23CALL:
+            /* SYS23: Set the U-Proc's stride tickets */
+            setUserTickets(savedState);
+            break;
+
+        case SYS24CALL:
+            /* SYS24: Enter or leave the real-time class */
+            setUserRealTime(savedState);
+            break;
+
+        case SYS25CALL:
+            /* SYS25: Return deadline misses */
+            getUserDeadlineMisses(savedState);
+            break;
+
+        case SYS26CALL:
+            /* SYS26: Duplicate this U-Proc, copy-on-write */
+            forkUserProcess(savedState, currentSupportStruct);
+            break;
+
+        case SYS27CALL:
+            /* SYS27: Start a U-Proc from a flash device */
+            spawnUserProcess(savedState);
+            break;
+
+        case SYS28CALL:
+            /* SYS28: Copy the compressed swap tier's counters to the user */
+            getSwapStats(savedState, currentSupportStruct);
+            break;
+
+        case SYS29CALL:
+            /* SYS29: Turn load control off or on */
+            setLoadControl(savedState);
+            break;
+
         default:
             /* For anything else, treat as *fatal* program trap */
             VMprogramTrapExceptionHandler(currentSupportStruct);
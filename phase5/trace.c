@@ -0,0 +1,113 @@
+/******************************* TRACE.c ***************************************
+ * 
+ * This module owns the kernel trace ring and implements SYS19, which copies it
+ * out to a U-Proc. The ring is a tracering_t: a TRACEMAGIC word, the count of
+ * records ever written, and TRACEENTRIES records that are overwritten oldest
+ * first. Records are appended in place by the TRACE / SUPTRACE macros of
+ * trace.h; nothing here runs on the traced paths. Because the magic word leads
+ * the ring, a raw memory dump of the kernel can be decoded without its symbol
+ * table (host/tracedump).
+ *
+ * Without -DKTRACE the ring does not exist and SYS19 returns 0 records.
+ * 
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/05/27
+ * 
+ ***********************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/trace.h"
+#include "../h/sysSupport.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+#ifdef KTRACE
+tracering_t traceRing = {TRACEMAGIC, 0};       /* The kernel trace ring */
+#endif
+
+/******************************* SYSCALL IMPLEMENTATION *******************************/
+
+/*
+ * Function     :   dumpTrace
+ * Purpose      :   Implement SYS19 to copy the most recent trace records, oldest first,
+ *                  into a user buffer. a1 holds the buffer's virtual address and a2 the
+ *                  number of trace_t records it can hold. Each record is read with
+ *                  the nucleus locked and then stored into the buffer after unlocking it,
+ *                  since the store may page fault. The copy stops early if the ring wraps
+ *                  past the record about to be copied, so the result is always a
+ *                  contiguous, in-order stretch of the trace.
+ * Parameters   :   savedState - pointer to the user's saved processor state
+ *                  currentSupportStruct - user's support struct (holds a1, a2 in its state)
+ * Returns      :   None (v0 holds the number of records copied)
+ */
+void dumpTrace(state_PTR savedState, support_t *currentSupportStruct) {
+    /* ------------------------------------------------------------ *
+     * 0. Initialize Local Variables 
+     * ------------------------------------------------------------ */
+    trace_t *buffer = (trace_t *) savedState->s_a1;     /* user buffer */
+    int maxRecords = savedState->s_a2;                  /* its capacity in records */
+    int copied = 0;                                     /* records copied so far */
+#ifdef KTRACE
+    unsigned int status;                                /* status to restore after each read */
+    unsigned int first;                                 /* index of the oldest record copied */
+    unsigned int available;                             /* records still in the ring */
+    trace_t *record;                                    /* record being copied */
+    unsigned int tod, event, arg0, arg1;                /* its fields, read under lockNucleus */
+#endif
+
+    /* ------------------------------------------------------------ *
+     * 1. Check if the parameters are valid
+     * ------------------------------------------------------------ */
+    /* The buffer must lie in the user segment: be brutal otherwise */
+    if (((int) buffer < KUSEG) || (maxRecords < 0)) {
+        VMprogramTrapExceptionHandler(currentSupportStruct);
+    }
+
+#ifdef KTRACE
+    /* ------------------------------------------------------------ *
+     * 2. Choose the stretch to copy: the newest maxRecords records
+     * ------------------------------------------------------------ */
+    status = lockNucleus();
+    available = MIN(traceRing.tb_head, TRACEENTRIES);
+    if (available > (unsigned int) maxRecords) {
+        available = maxRecords;
+    }
+    first = traceRing.tb_head - available;
+    unlockNucleus(status);
+
+    /* ------------------------------------------------------------ *
+     * 3. Copy record by record, oldest first
+     * ------------------------------------------------------------ */
+    while ((unsigned int) copied < available) {
+        status = lockNucleus();
+        if ((traceRing.tb_head - (first + copied)) > TRACEENTRIES) {
+            /* The ring wrapped past this record while we were copying */
+            unlockNucleus(status);
+            break;
+        }
+        record = &traceRing.tb_rec[(first + copied) & (TRACEENTRIES - 1)];
+        tod   = record->tr_tod;
+        event = record->tr_event;
+        arg0  = record->tr_arg0;
+        arg1  = record->tr_arg1;
+        unlockNucleus(status);
+
+        /* Field by field, as copyState does: no struct copy (and no memcpy) */
+        buffer[copied].tr_tod   = tod;
+        buffer[copied].tr_event = event;
+        buffer[copied].tr_arg0  = arg0;
+        buffer[copied].tr_arg1  = arg1;
+        copied++;
+    }
+#endif
+
+    /* ------------------------------------------------------------ *
+     * 4. Return the number of records copied
+     * ------------------------------------------------------------ */
+    savedState->s_v0 = copied;
+    LDST(savedState);
+}
+
+/******************************* END OF TRACE.c *****************************/
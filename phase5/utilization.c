@@ -0,0 +1,258 @@
+/******************************* UTILIZATION.c ***************************************
+ *
+ * This module implements the nucleus's idle and blocked time accounting and SYS21,
+ * which reports CPU utilization over the last N pseudo-clock ticks.
+ *  - Idle time: the scheduler calls startIdle just before its WAIT, and the
+ *    interrupt handler calls endIdle with the TOD it read on entry, so idleTime
+ *    holds every microsecond the processors spent waiting. Each processor keeps
+ *    its own idle interval (see smp.h); a tick's span counts all NCPUS of them.
+ *  - Blocked time: SYS5 and SYS7 stamp p_blockTOD when they block a process, and
+ *    the interrupt handlers (or terminateProcess) charge now - p_blockTOD to the
+ *    wait's class (disk, flash, network, printer, terminal, pseudo-clock) when the
+ *    wait ends. Blocked time is process time: two processes blocked for 1ms add 2ms.
+ *  - Every Interval Timer interrupt closes a utilsample_t holding the tick's span,
+ *    idle time and blocked time in a ring of UTILTICKS samples.
+ * SYS22 copies out the peripheral interrupt counters kept by interrupts.c.
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/05/29
+ *
+ ***********************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/initial.h"
+#include "../h/interrupts.h"
+#include "../h/utilization.h"
+#include "../h/sysSupport.h"
+#include "../h/smp.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+cpu_t idleTime;                                 /* Microseconds spent idle since boot */
+cpu_t blockedTime[BLOCKCLASSES];                /* Process-microseconds blocked since boot, per class */
+
+
+HIDDEN utilsample_t utilRing[UTILTICKS];        /* The last UTILTICKS closed ticks */
+HIDDEN int utilNext;                            /* Ring slot the next tick closes into */
+HIDDEN int utilTicks;                           /* Ticks closed since boot, up to UTILTICKS */
+HIDDEN cpu_t tickStart;                         /* TOD the current tick started at */
+HIDDEN cpu_t idleBase;                          /* idleTime when the current tick started */
+HIDDEN cpu_t blockedBase[BLOCKCLASSES];         /* blockedTime when the current tick started */
+
+/******************************* ACCOUNTING *****************************/
+
+/*
+ * Function     :   initUtilization
+ * Purpose      :   Start the first tick. Called once by main, right after the
+ *                  Interval Timer is first loaded
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void initUtilization(void) {
+    int i;
+
+    idleTime  = 0;
+    utilNext  = 0;
+    utilTicks = 0;
+    idleBase  = 0;
+    for (i = 0; i < BLOCKCLASSES; i++) {
+        blockedTime[i] = 0;
+        blockedBase[i] = 0;
+    }
+    STCK(tickStart);
+}
+
+/*
+ * Function     :   startIdle
+ * Purpose      :   Note that the scheduler is about to WAIT
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void startIdle(void) {
+    thisCPU.pc_idling = TRUE;
+    STCK(thisCPU.pc_idleStart);
+}
+
+/*
+ * Function     :   endIdle
+ * Purpose      :   Close the idle interval, if the processor was idle
+ * Parameters   :   now - TOD read on entry to the interrupt handler
+ * Returns      :   None
+ */
+void endIdle(cpu_t now) {
+    if (thisCPU.pc_idling) {
+        idleTime += (now - thisCPU.pc_idleStart);
+        thisCPU.pc_idling = FALSE;
+    }
+}
+
+/*
+ * Function     :   blockClassOf
+ * Purpose      :   Map a deviceSemaphores index to its blocked time class. The
+ *                  terminal's receive and transmit semaphores share TERMCLASS
+ * Parameters   :   semIndex - index into deviceSemaphores
+ * Returns      :   The class, in [0..BLOCKCLASSES - 1]
+ */
+int blockClassOf(int semIndex) {
+    if (semIndex == PCLOCKIDX) {
+        return CLOCKCLASS;
+    }
+    if ((semIndex / DEVPERINT) > TERMCLASS) {
+        return TERMCLASS;
+    }
+    return semIndex / DEVPERINT;
+}
+
+/*
+ * Function     :   accountBlocked
+ * Purpose      :   Charge the wait p just finished to its class
+ * Parameters   :   p - the process leaving a device or pseudo-clock semaphore
+ *                  blockClass - the wait's class
+ *                  now - current TOD
+ * Returns      :   None
+ */
+void accountBlocked(pcb_PTR p, int blockClass, cpu_t now) {
+    blockedTime[blockClass] += (now - p->p_blockTOD);
+}
+
+/*
+ * Function     :   utilTick
+ * Purpose      :   Close the current tick into the ring and start the next one.
+ *                  Called by the Interval Timer handler after it has released the
+ *                  pseudo-clock waiters, so their waits count in the closing tick
+ * Parameters   :   now - TOD read on entry to the interrupt handler
+ * Returns      :   None
+ */
+void utilTick(cpu_t now) {
+    utilsample_t *sample = &utilRing[utilNext];
+    int i;
+
+    sample->us_span = (now - tickStart) * NCPUS;
+    sample->us_idle = idleTime - idleBase;
+    for (i = 0; i < BLOCKCLASSES; i++) {
+        sample->us_blocked[i] = blockedTime[i] - blockedBase[i];
+        blockedBase[i] = blockedTime[i];
+    }
+    idleBase  = idleTime;
+    tickStart = now;
+
+    utilNext = (utilNext + 1) % UTILTICKS;
+    if (utilTicks < UTILTICKS) {
+        utilTicks++;
+    }
+}
+
+/******************************* SYSCALL IMPLEMENTATION *******************************/
+
+/*
+ * Function     :   getUtilization
+ * Purpose      :   Implement SYS21 to report CPU utilization over the last N closed
+ *                  pseudo-clock ticks. a1 holds N (clamped to [1..UTILTICKS] and to the
+ *                  ticks closed so far), a2 the virtual address of a utilsample_t to
+ *                  receive the window's summed span, idle and blocked times, or 0. The
+ *                  ring is summed with the nucleus locked and the result stored after
+ *                  unlocking it, since the store may page fault.
+ * Parameters   :   savedState - pointer to the user's saved processor state
+ *                  currentSupportStruct - user's support struct
+ * Returns      :   None (v0 holds the busy percentage of the window, or -1 if no
+ *                  tick has closed yet)
+ */
+void getUtilization(state_PTR savedState, support_t *currentSupportStruct) {
+    /* ------------------------------------------------------------ *
+     * 0. Initialize Local Variables
+     * ------------------------------------------------------------ */
+    int ticks = savedState->s_a1;                                   /* window length */
+    utilsample_t *buffer = (utilsample_t *) savedState->s_a2;      /* optional user buffer */
+    cpu_t span, idle, blocked[BLOCKCLASSES];                        /* window sums */
+    unsigned int status;                                            /* status to restore */
+    int i, c, slot;
+
+    /* ------------------------------------------------------------ *
+     * 1. Check if the parameters are valid
+     * ------------------------------------------------------------ */
+    /* A buffer must lie in the user segment: be brutal otherwise */
+    if ((buffer != 0) && ((int) buffer < KUSEG)) {
+        VMprogramTrapExceptionHandler(currentSupportStruct);
+    }
+    if (ticks < 1) {
+        ticks = 1;
+    }
+    if (ticks > UTILTICKS) {
+        ticks = UTILTICKS;
+    }
+
+    /* ------------------------------------------------------------ *
+     * 2. Sum the newest ticks with the nucleus locked
+     * ------------------------------------------------------------ */
+    span = 0;
+    idle = 0;
+    for (c = 0; c < BLOCKCLASSES; c++) {
+        blocked[c] = 0;
+    }
+
+    status = lockNucleus();
+    if (ticks > utilTicks) {
+        ticks = utilTicks;
+    }
+    slot = utilNext;
+    for (i = 0; i < ticks; i++) {
+        slot = (slot + UTILTICKS - 1) % UTILTICKS;
+        span += utilRing[slot].us_span;
+        idle += utilRing[slot].us_idle;
+        for (c = 0; c < BLOCKCLASSES; c++) {
+            blocked[c] += utilRing[slot].us_blocked[c];
+        }
+    }
+    unlockNucleus(status);
+
+    /* ------------------------------------------------------------ *
+     * 3. Copy the sums out and return the busy percentage
+     * ------------------------------------------------------------ */
+    if (buffer != 0) {
+        buffer->us_span = span;
+        buffer->us_idle = idle;
+        for (c = 0; c < BLOCKCLASSES; c++) {
+            buffer->us_blocked[c] = blocked[c];
+        }
+    }
+
+    savedState->s_v0 = (span > 0) ? (((span - idle) * 100) / span) : -1;
+    LDST(savedState);
+}
+
+/*
+ * Function     :   getInterruptStats
+ * Purpose      :   Implement SYS22 to copy the peripheral interrupt counters (handler
+ *                  entries, and device interrupts serviced by them) into the intstat_t
+ *                  whose virtual address is in a1. Entries per service below 1 means
+ *                  devices are being serviced in bursts.
+ * Parameters   :   savedState - pointer to the user's saved processor state
+ *                  currentSupportStruct - user's support struct
+ * Returns      :   None (v0 holds 0)
+ */
+void getInterruptStats(state_PTR savedState, support_t *currentSupportStruct) {
+    intstat_t *buffer = (intstat_t *) savedState->s_a1;    /* user buffer */
+    unsigned int status;                                    /* status to restore */
+    unsigned int entries, services;                         /* counters, read together */
+
+    /* The buffer must lie in the user segment: be brutal otherwise */
+    if ((int) buffer < KUSEG) {
+        VMprogramTrapExceptionHandler(currentSupportStruct);
+    }
+
+    /* Read both counters with the nucleus locked, then store them */
+    status = lockNucleus();
+    entries  = deviceIntStats.is_entries;
+    services = deviceIntStats.is_services;
+    unlockNucleus(status);
+
+    buffer->is_entries  = entries;
+    buffer->is_services = services;
+
+    savedState->s_v0 = 0;
+    LDST(savedState);
+}
+
+/******************************* END OF UTILIZATION.c *****************************/
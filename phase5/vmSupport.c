@@ -7,9 +7,45 @@
  * The pager coordinates acquiring the Swap Pool lock, evicting pages if necessary, reading 
  * in the requested page from flash, updating the process's page table and TLB, and
  * return control to the faulting process.
- * 
+ *
+ * Each U-proc's address space is described by a two-level page table: a small page
+ * directory in the support structure whose slots point to 1KB second-level tables
+ * taken from a slab cache. The text/data region grows up from VPNSTART and the
+ * stack region grows down from STACKPAGEVPN; on the backing flash device the text pages
+ * occupy blocks from 0 upward and the stack pages occupy blocks from the last one downward.
+ * A fault outside both regions, or where the two regions would meet on the backing store,
+ * is reported by terminating the U-proc instead of being folded onto another page.
+ *
+ * The Swap Pool is not a fixed carve-out: at boot it takes 1/SWAPPOOLSHARE of the
+ * frames the page allocator has left, so it scales with the installed RAM.
+ *
+ * Every page table entry also names the block its page is paged from (pt_backing),
+ * which starts as the U-proc's own ("home") block for the page. SYS26 duplicates an
+ * address space by copying the page tables: the child's entries name the parent's
+ * blocks, and resident pages are mapped read-only in both, the frame counting its
+ * mappers in refs. A block may only be written by an address space that is its
+ * sole user, so pages are mapped writable only when their block is their home and
+ * no other address space references it (blockRefs). The first write to any other
+ * page raises a TLB-Modification, where the pager breaks the sharing: a writer that
+ * does not own the block moves the page to its own home block (copying the frame
+ * if others still map it), while an owner first copies the page to the home block
+ * of every other address space still referencing the block. Frames that were
+ * never writable hold exactly their block's contents and are not written back.
+ *
+ * The .text pages of a load image (sized from the aout header in page 0) are mapped
+ * read-only too. When one is paged in, the pager hashes it and looks for a resident
+ * frame holding the same words at the same VPN, left by another U-Proc running an
+ * identical image; if there is one, the page maps that frame instead (refs counts
+ * the sharers, and eviction unmaps them all). A write to image text is copied on
+ * write like any other shared page.
+ *
+ * Pages go to and come from their backing blocks through the compressed swap tier
+ * (zswap.c), which keeps evicted dirty pages compressed in RAM and writes them to
+ * flash only when it runs out of room. Every fault also feeds the load controller
+ * (loadControl.c), which suspends U-Procs while their working sets overflow the pool.
+ *
  * Written by  : Uyen Nguyen
- * Last update : 2025/04/17
+ * Last update : 2025/06/08
  * 
  ***********************************************************************************/
 
@@ -20,6 +56,11 @@
 #include "../h/vmSupport.h"
 #include "../h/sysSupport.h"
 #include "../h/deviceSupportDMA.h"
+#include "../h/slab.h"
+#include "../h/trace.h"
+#include "../h/smp.h"
+#include "../h/zswap.h"
+#include "../h/loadControl.h"
 #include "/usr/include/umps3/umps/libumps.h"
 
 /* For phase 4: move the flashOperation to deviceSupportDMA.c */
@@ -27,24 +68,135 @@ extern int flashOperation(support_t *currentSupportStruct, int logicalAddress, i
 
 /************************* VMSUPPORT GLOBAL VARIABLES *************************/
 
-int swapPoolSemaphore;                          /* Semaphore for the Swap Pool Table */
-HIDDEN swap_t swapPoolTable[SWAPPOOLSIZE];      /* THE Swap Pool Table: one entry per swap pool frame */
+mutex_t swapPoolSemaphore;                      /* Mutex for the Swap Pool Table */
+HIDDEN swap_t *swapPoolTable;                   /* THE Swap Pool Table: one entry per swap pool frame */
+int swapPoolSize;                               /* Number of frames in the Swap Pool (sized at boot) */
+HIDDEN memaddr swapPoolStart;                   /* Address of the first Swap Pool frame */
+HIDDEN slab_t pageTableCache;                   /* Slab cache of second-level page tables */
+support_t *addressSpaces[MAXASID + 1];          /* Live address spaces by ASID, NULL if the ASID is free */
+HIDDEN unsigned char *blockRefs[DEVPERINT];     /* Per flash device: references to each block from the
+                                                   address spaces it is not home to (NULL until shared) */
+HIDDEN int deviceRefs[DEVPERINT];               /* Per flash device: the sum of its blockRefs */
+
+/******************************* PAGE TABLE POOL *******************************/
+
+/*
+ * Function     :   flashBlocks
+ * Purpose      :   Read the size of a flash device
+ * Parameters   :   flashDev - flash device number (0..7)
+ * Returns      :   Number of blocks on the device
+ */
+HIDDEN int flashBlocks(int flashDev) {
+    devregarea_t *devRegArea = (devregarea_t *) RAMBASEADDR;
+    return devRegArea->devreg[((FLASHINT - OFFSET) * DEVPERINT) + flashDev].d_data1;
+}
+
+/*
+ * Function     :   homeBlocks
+ * Purpose      :   Count the blocks of a U-Proc's home: its flash device from the block
+ *                  its load image starts at (sup_blockBase) to the last one
+ * Parameters   :   currentSupportStruct - support structure of the U-Proc
+ * Returns      :   The number of blocks both regions share
+ */
+HIDDEN int homeBlocks(support_t *currentSupportStruct) {
+    return flashBlocks(currentSupportStruct->sup_flashDev) - currentSupportStruct->sup_blockBase;
+}
+
+/*
+ * Function     :   homeBacking
+ * Purpose      :   Compute the home block of a page on its U-Proc's flash device: text/data
+ *                  page i lives in block (sup_blockBase + i) and stack page j in block
+ *                  (maxBlock - 1 - j)
+ * Parameters   :   currentSupportStruct - support structure of the page's U-Proc
+ *                  vpn - virtual page number of the page (in either region)
+ * Returns      :   BACKING(flash device, block)
+ */
+HIDDEN unsigned int homeBacking(support_t *currentSupportStruct, unsigned int vpn) {
+    unsigned int offset = vpn - VPNSTART;
+
+    if (offset < MAXTEXTPAGES) {
+        return BACKING(currentSupportStruct->sup_flashDev, currentSupportStruct->sup_blockBase + offset);
+    }
+    return BACKING(currentSupportStruct->sup_flashDev,
+                   flashBlocks(currentSupportStruct->sup_flashDev) - 1 - (STACKPAGEVPN - vpn));
+}
+
+/*
+ * Function     :   allocPageTable
+ * Purpose      :   Take a second-level page table from the cache and initialize each
+ *                  entry with its VPN, the owner's ASID (not valid, dirty on) and the
+ *                  page's home block. Text tables map VPNs upward from VPNSTART, stack
+ *                  tables map VPNs downward from STACKPAGEVPN
+ * Parameters   :   currentSupportStruct - support structure of the table's owner
+ *                  firstOffset - page offset (within its region) of the table's first entry
+ *                  isStack - TRUE for a stack table, FALSE for a text/data table
+ * Returns      :   Pointer to the new table, or NULL if RAM is exhausted
+ */
+HIDDEN pte_t *allocPageTable(support_t *currentSupportStruct, unsigned int firstOffset, int isStack) {
+    pte_t *pageTable = slabAlloc(&pageTableCache);
+    if (pageTable == NULL) {
+        return NULL;
+    }
+
+    int i;
+    unsigned int vpn;
+    for (i = 0; i < PTESPERTABLE; i++) {
+        vpn = (isStack == TRUE) ? (STACKPAGEVPN - (firstOffset + i)) : (VPNSTART + firstOffset + i);
+        pageTable[i].pt_entryHI = ALLOFF | (vpn << VPNSHIFT) | (currentSupportStruct->sup_asid << ASIDSHIFT);
+        pageTable[i].pt_entryLO = ALLOFF | DIRTYON;
+        pageTable[i].pt_backing = homeBacking(currentSupportStruct, vpn);
+    }
+    return pageTable;
+}
 
 /*
  * Function     :   initSwapStructs
- * Purpose      :   Initialize the Swap Pool semaphore and mark all frames free
+ * Purpose      :   Initialize the Swap Pool semaphore, size the Swap Pool from the
+ *                  frames left to the page allocator, mark all frames free and set
+ *                  up the page table cache
  * Parameters   :   None
  * Returns      :   None 
  */
 void initSwapStructs(void) {
     /* Initialize the Swap Pool Semaphore to 1 (mutual exclusion) */
-    swapPoolSemaphore = 1;
+    swapPoolSemaphore.mx_value = MUTEXFREE;
+    swapPoolSemaphore.mx_owner = NULL;
+    swapPoolSemaphore.mx_next  = NULL;
+
+    /* Give the Swap Pool its share of the free frames, less the frames its table needs */
+    int tablePages;
+    swapPoolSize = freePageCount() / SWAPPOOLSHARE;
+    tablePages   = ((swapPoolSize * sizeof(swap_t)) + PAGESIZE - 1) / PAGESIZE;
+    swapPoolSize = swapPoolSize - tablePages;
+
+    swapPoolTable = allocPages(tablePages);
+    swapPoolStart = (memaddr) allocPages(swapPoolSize);
+
+    /* Not even one frame to page into: nothing can run */
+    if ((swapPoolSize <= 0) || (swapPoolTable == NULL) || (swapPoolStart == (memaddr) NULL)) {
+        PANIC();
+    }
 
     /* Iteratively initialize the Swap Pool table */
     int i;
-    for (i = 0; i < SWAPPOOLSIZE; i++) {
+    for (i = 0; i < swapPoolSize; i++) {
         swapPoolTable[i].asid = EMPTYFRAME;     /* Set the ASID to EMPTYFRAME (-1) */
     }
+
+    /* No address space yet, and no block shared */
+    for (i = 0; i <= MAXASID; i++) {
+        addressSpaces[i] = NULL;
+    }
+    for (i = 0; i < DEVPERINT; i++) {
+        blockRefs[i]  = NULL;
+        deviceRefs[i] = 0;
+    }
+
+    /* The compressed tier takes its share of what the Swap Pool left */
+    initZswap();
+
+    /* Second-level tables are carved on demand */
+    slabInit(&pageTableCache, PTESPERTABLE * sizeof(pte_t), WORDLEN);
 }
 
 /******************************* HELPER FUNCTIONS *******************************/
@@ -68,18 +220,19 @@ void setInterrupt(int status) {
 
 /*
  * Function     :   mutex
- * Purpose      :   Provide mutual exclusion by performing P or V on the given semaphore
- * Parameters   :   semaphore - pointer to the integer semaphore variable for mutual exclusion
- *                  doLock - TRUE for P, FALSE for V 
+ * Purpose      :   Provide mutual exclusion by locking (SYS30) or unlocking (SYS31) the
+ *                  given priority-inheritance mutex
+ * Parameters   :   semaphore - pointer to the mutex
+ *                  doLock - TRUE to lock, FALSE to unlock
  * Return       :   None
  */
-void mutex(int *semaphore, int doLock) {
+void mutex(mutex_t *semaphore, int doLock) {
     /* If doLock is TRUE, then wait on the semaphore */
     if (doLock == TRUE) {
-        SYSCALL(SYS3CALL, (unsigned int) semaphore, 0, 0);  /* P operation */
+        SYSCALL(SYS30CALL, (unsigned int) semaphore, 0, 0); /* Lock */
     } else {
         /* Else, signal the semaphore instead */
-        SYSCALL(SYS4CALL, (unsigned int) semaphore, 0, 0);  /* V operation */
+        SYSCALL(SYS31CALL, (unsigned int) semaphore, 0, 0); /* Unlock */
     }
 }
 
@@ -91,10 +244,11 @@ void mutex(int *semaphore, int doLock) {
 *                  to select a physical frame in the Swap Pool to satisfy the
 *                  page-in request. First, it scans for a free frame. If no free
 *                  frame available, it will evict using round-robin
-* Parameters   :   None
+* Parameters   :   pinned - a frame that must not be chosen (the source of a
+*                           copy-on-write copy), or -1
 * Returns      :   int - Index into Swap Pool Table of chosen victim frame
 */
-int pageReplacement(void) {
+int pageReplacement(int pinned) {
     /* --------------------------------------------------------------
      * 0. Local variables declaration
      * -------------------------------------------------------------- */    
@@ -109,9 +263,9 @@ int pageReplacement(void) {
      * -------------------------------------------------------------- */   
     /* First, scan through the entire Swap Pool for a free frame */
     int i;
-    for (i = 0; i < SWAPPOOLSIZE; i++) {
+    for (i = 0; i < swapPoolSize; i++) {
         /* Compute the candidate index (wrap around via modulo) */
-        int index = (hand + i) % (SWAPPOOLSIZE);
+        int index = (hand + i) % (swapPoolSize);
 
         /* If we found a free frame */
         if (swapPoolTable[index].asid == EMPTYFRAME) {
@@ -119,7 +273,7 @@ int pageReplacement(void) {
             victim = index;
 
             /* Advance hand to the slot after the one we just took */
-            hand = (index + 1) % (SWAPPOOLSIZE);
+            hand = (index + 1) % (swapPoolSize);
 
             /* Return the index to the free frame in the Swap Pool we just found */
             return victim;
@@ -129,11 +283,14 @@ int pageReplacement(void) {
     /* --------------------------------------------------------------
      * 2. Since none available, evict through round-robin
      * -------------------------------------------------------------- */   
-    /* No free frame was found. We need to evict the frame at hand */
+    /* No free frame was found. We need to evict the frame at hand (never the pinned one) */
+    if (hand == pinned) {
+        hand = (hand + 1) % (swapPoolSize);
+    }
     victim = hand;
 
     /* Advance hand for next round (round-robin) */
-    hand = (hand + 1) % (SWAPPOOLSIZE);
+    hand = (hand + 1) % (swapPoolSize);
 
     /* Return the index into swapPoolTable of the chosen victim frame */
     return victim;
@@ -169,6 +326,708 @@ void updateTLB(pte_t *ptEntry) {
     /* If no match was found, leave the TLB unchange */
 }
 
+/************************* ADDRESS SPACE FUNCTIONS *************************/
+
+/*
+ * Function     :   pageEntry
+ * Purpose      :   Find a VPN's page table entry without extending the page table
+ * Parameters   :   currentSupportStruct - support structure of the address space
+ *                  vpn - virtual page number
+ * Returns      :   Pointer to the entry, or NULL if no second-level table covers it
+ */
+HIDDEN pte_t *pageEntry(support_t *currentSupportStruct, unsigned int vpn) {
+    unsigned int offset;
+    pte_t *pageTable = NULL;
+
+    if ((offset = vpn - VPNSTART) < MAXTEXTPAGES) {
+        pageTable = currentSupportStruct->sup_textPgTbl[offset >> PTESHIFT];
+    } else if ((offset = STACKPAGEVPN - vpn) < MAXSTACKPAGES) {
+        pageTable = currentSupportStruct->sup_stackPgTbl[offset >> PTESHIFT];
+    }
+    return (pageTable == NULL) ? NULL : &(pageTable[offset & PTEMASK]);
+}
+
+/*
+ * Function     :   frameOf
+ * Purpose      :   Find the Swap Pool frame a valid page table entry maps
+ * Parameters   :   ptEntry - the entry
+ * Returns      :   Index into the Swap Pool table
+ */
+HIDDEN int frameOf(pte_t *ptEntry) {
+    return ((ptEntry->pt_entryLO & PFNMASK) - swapPoolStart) / PAGESIZE;
+}
+
+/*
+ * Function     :   isPrivate
+ * Purpose      :   Tell whether an address space may write a block: the block must be
+ *                  its home, and no other address space may reference it
+ * Parameters   :   currentSupportStruct - support structure of the address space
+ *                  backing - BACKING(flash device, block)
+ * Returns      :   TRUE if a page backed by the block may be mapped writable
+ */
+HIDDEN int isPrivate(support_t *currentSupportStruct, unsigned int backing) {
+    int flashDev = BACKINGDEV(backing);
+
+    return (flashDev == currentSupportStruct->sup_flashDev) &&
+           ((blockRefs[flashDev] == NULL) || (blockRefs[flashDev][BACKINGBLK(backing)] == 0));
+}
+
+/*
+ * Function     :   addReference
+ * Purpose      :   Count a reference to a block from an address space it is not home to
+ * Parameters   :   backing - BACKING(flash device, block)
+ * Returns      :   None
+ */
+HIDDEN void addReference(unsigned int backing) {
+    blockRefs[BACKINGDEV(backing)][BACKINGBLK(backing)]++;
+    deviceRefs[BACKINGDEV(backing)]++;
+}
+
+/*
+ * Function     :   dropReference
+ * Purpose      :   Undo addReference
+ * Parameters   :   backing - BACKING(flash device, block)
+ * Returns      :   None
+ */
+HIDDEN void dropReference(unsigned int backing) {
+    blockRefs[BACKINGDEV(backing)][BACKINGBLK(backing)]--;
+    deviceRefs[BACKINGDEV(backing)]--;
+}
+
+/*
+ * Function     :   findMapping
+ * Purpose      :   Find a page table entry, other than the given one, that maps a frame.
+ *                  Sharers always map a frame at the same VPN, so only that VPN's entry
+ *                  in each live address space needs looking at
+ * Parameters   :   frameNumber - index into the Swap Pool table
+ *                  except - entry to skip, or NULL
+ *                  asid - output: the ASID of the entry found
+ * Returns      :   Pointer to the entry, or NULL if no other entry maps the frame
+ */
+HIDDEN pte_t *findMapping(int frameNumber, pte_t *except, int *asid) {
+    memaddr frameAddress = (frameNumber * PAGESIZE) + swapPoolStart;
+    pte_t *ptEntry;
+    int i;
+
+    for (i = 1; i <= MAXASID; i++) {
+        if (addressSpaces[i] == NULL) {
+            continue;
+        }
+        ptEntry = pageEntry(addressSpaces[i], swapPoolTable[frameNumber].vpn);
+        if ((ptEntry != NULL) && (ptEntry != except) && ((ptEntry->pt_entryLO & VALIDON) != 0) &&
+            ((ptEntry->pt_entryLO & PFNMASK) == frameAddress)) {
+            *asid = i;
+            return ptEntry;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Function     :   unmapPage
+ * Purpose      :   Mark a page table entry not valid and drop it from the TLBs
+ * Parameters   :   ptEntry - the entry
+ *                  asid - ASID of the entry's address space
+ * Returns      :   None
+ */
+HIDDEN void unmapPage(pte_t *ptEntry, int asid) {
+    /* NOTE: Disable interrupt so the entry and the TLB change atomically */
+    setInterrupt(FALSE);
+    ptEntry->pt_entryLO = ptEntry->pt_entryLO & VALIDOFF;
+    updateTLB(ptEntry);
+    setInterrupt(TRUE);
+
+    /* On a multiprocessor, wait until no other TLB can still map the page */
+    shootdownTLB(asid);
+}
+
+/*
+ * Function     :   evictFrame
+ * Purpose      :   Swap out the page occupying a frame: unmap it from every page table
+ *                  that maps it, then write it to its backing block, unless the frame was
+ *                  never writable and so still holds exactly the block's contents. The
+ *                  frame is free afterwards, unless the write failed
+ * Parameters   :   currentSupportStruct - support structure of the faulting U-Proc
+ *                  frameNumber - index into the Swap Pool table
+ * Returns      :   READY, or the negated device status if the write failed
+ */
+HIDDEN int evictFrame(support_t *currentSupportStruct, int frameNumber) {
+    swap_t *frame = &swapPoolTable[frameNumber];
+    pte_t *sharer;
+    int asid;
+    int status = READY;
+
+    /* a. & b. Mark the occupant's Page Table entry as not valid and update the TLB */
+    unmapPage(frame->pte, frame->asid);
+
+    /* A frame duplicated by SYS26 is unmapped from its other sharers too */
+    if (frame->refs > 1) {
+        while ((sharer = findMapping(frameNumber, NULL, &asid)) != NULL) {
+            unmapPage(sharer, asid);
+        }
+    }
+
+    /* c. Update the backing store (the compressed tier, or flash), if the page may have been written */
+    if (frame->dirty == TRUE) {
+        status = zswapPageOut(currentSupportStruct, (frameNumber * PAGESIZE) + swapPoolStart,
+                              frame->flash, frame->block);
+    }
+    if (status == READY) {
+        frame->asid = EMPTYFRAME;
+    }
+    return status;
+}
+
+/*
+ * Function     :   lookupPage
+ * Purpose      :   Translate a VPN into its page table entry, allocating the covering
+ *                  second-level table on first touch; the entry names the page's backing
+ *                  block. A new entry's block is the page's home: text/data page i lives
+ *                  in block (sup_blockBase + i) and stack page j in block (maxBlock - 1 - j),
+ *                  so the two regions may grow toward each other until they meet on the
+ *                  flash device. Must be called while holding the Swap Pool semaphore
+ * Parameters   :   currentSupportStruct - support structure of the faulting U-Proc
+ *                  vpn - virtual page number of the faulting address
+ * Returns      :   Pointer to the page table entry, or NULL if the VPN is out of range
+ *                  (or no page table could be allocated)
+ */
+HIDDEN pte_t *lookupPage(support_t *currentSupportStruct, unsigned int vpn) {
+    int maxBlock = homeBlocks(currentSupportStruct);
+
+    unsigned int offset;
+    pte_t **slot;
+    int isStack;
+
+    if ((offset = vpn - VPNSTART) < MAXTEXTPAGES) {
+        /* Text/data page: must stay below the blocks already claimed by the stack */
+        if ((int) offset >= maxBlock - currentSupportStruct->sup_stackPages) {
+            return NULL;
+        }
+        slot = &(currentSupportStruct->sup_textPgTbl[offset >> PTESHIFT]);
+        isStack = FALSE;
+    } else if ((offset = STACKPAGEVPN - vpn) < MAXSTACKPAGES) {
+        /* Stack page: must stay above the blocks already claimed by text/data */
+        if ((int) offset >= maxBlock - currentSupportStruct->sup_textPages) {
+            return NULL;
+        }
+        slot = &(currentSupportStruct->sup_stackPgTbl[offset >> PTESHIFT]);
+        isStack = TRUE;
+    } else {
+        /* Neither region covers this page */
+        return NULL;
+    }
+
+    /* Allocate the second-level table on first touch */
+    if (*slot == NULL) {
+        *slot = allocPageTable(currentSupportStruct, offset & ~PTEMASK, isStack);
+        if (*slot == NULL) {
+            return NULL;
+        }
+    }
+
+    /* Record how far the region has grown */
+    if (isStack == TRUE) {
+        currentSupportStruct->sup_stackPages = MAX(currentSupportStruct->sup_stackPages, (int) offset + 1);
+    } else {
+        currentSupportStruct->sup_textPages = MAX(currentSupportStruct->sup_textPages, (int) offset + 1);
+    }
+
+    return &((*slot)[offset & PTEMASK]);
+}
+
+/*
+ * Function     :   freePageTable
+ * Purpose      :   Return a second-level page table to the cache, after giving up each
+ *                  frame its entries map (a frame other sharers still map passes to one
+ *                  of them) and each reference they hold to another address space's block
+ * Parameters   :   currentSupportStruct - support structure of the table's owner
+ *                  pageTable - pointer to the table to be freed
+ * Returns      :   None
+ */
+HIDDEN void freePageTable(support_t *currentSupportStruct, pte_t *pageTable) {
+    swap_t *frame;
+    int i, asid;
+
+    for (i = 0; i < PTESPERTABLE; i++) {
+        if ((pageTable[i].pt_entryLO & VALIDON) != 0) {
+            frame = &swapPoolTable[frameOf(&pageTable[i])];
+            frame->refs--;
+            if (frame->pte == &pageTable[i]) {
+                frame->pte  = (frame->refs > 0) ? findMapping(frameOf(&pageTable[i]), &pageTable[i], &asid) : NULL;
+                frame->asid = (frame->pte != NULL) ? asid : EMPTYFRAME;
+            }
+        }
+        if (BACKINGDEV(pageTable[i].pt_backing) != currentSupportStruct->sup_flashDev) {
+            dropReference(pageTable[i].pt_backing);
+        }
+    }
+    slabFree(&pageTableCache, pageTable);
+}
+
+/*
+ * Function     :   freeAddressSpace
+ * Purpose      :   Free every second-level table of an address space, then any Swap Pool
+ *                  frame still in its name (a page whose write-back failed), and give
+ *                  its ASID back. Must be called while holding the Swap Pool semaphore
+ * Parameters   :   currentSupportStruct - support structure of the address space
+ * Returns      :   None
+ */
+HIDDEN void freeAddressSpace(support_t *currentSupportStruct) {
+    int i;
+
+    for (i = 0; i < TEXTTABLES; i++) {
+        if (currentSupportStruct->sup_textPgTbl[i] != NULL) {
+            freePageTable(currentSupportStruct, currentSupportStruct->sup_textPgTbl[i]);
+            currentSupportStruct->sup_textPgTbl[i] = NULL;
+        }
+    }
+    for (i = 0; i < STACKTABLES; i++) {
+        if (currentSupportStruct->sup_stackPgTbl[i] != NULL) {
+            freePageTable(currentSupportStruct, currentSupportStruct->sup_stackPgTbl[i]);
+            currentSupportStruct->sup_stackPgTbl[i] = NULL;
+        }
+    }
+
+    for (i = 0; i < swapPoolSize; i++) {
+        if (swapPoolTable[i].asid == currentSupportStruct->sup_asid) {
+            swapPoolTable[i].asid = EMPTYFRAME;
+        }
+    }
+
+    if (addressSpaces[currentSupportStruct->sup_asid] == currentSupportStruct) {
+        addressSpaces[currentSupportStruct->sup_asid] = NULL;
+    }
+}
+
+/*
+ * Function     :   claimASID
+ * Purpose      :   Give an address space the lowest free ASID and register it as live.
+ *                  Must be called while holding the Swap Pool semaphore
+ * Parameters   :   currentSupportStruct - the address space's support structure
+ * Returns      :   The ASID, or -1 if all MAXASID are in use
+ */
+HIDDEN int claimASID(support_t *currentSupportStruct) {
+    int asid;
+
+    for (asid = 1; asid <= MAXASID; asid++) {
+        if (addressSpaces[asid] == NULL) {
+            addressSpaces[asid] = currentSupportStruct;
+            currentSupportStruct->sup_asid = asid;
+            return asid;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Function     :   releaseAddressSpace
+ * Purpose      :   Tear down a terminating U-Proc's address space: free every Swap Pool
+ *                  frame only it maps, drop its references to other address spaces'
+ *                  blocks, return its second-level tables to the cache (so no Swap Pool
+ *                  entry is left pointing into a recycled table) and free its ASID
+ * Parameters   :   currentSupportStruct - support structure of the terminating U-Proc
+ * Returns      :   None
+ */
+void releaseAddressSpace(support_t *currentSupportStruct) {
+    mutex(&swapPoolSemaphore, TRUE);
+
+    freeAddressSpace(currentSupportStruct);
+
+    /* Its working set no longer competes for frames: a suspended U-Proc may fit now */
+    loadControl();
+
+    /* Its compressed pages are garbage, unless a SYS26 child still reads its blocks */
+    if (deviceRefs[currentSupportStruct->sup_flashDev] == 0) {
+        zswapPurge(currentSupportStruct->sup_flashDev);
+    }
+
+    /* Processors it ran on clear their TLBs before its ASID runs there again, and so
+       does this one, since the ASID may be handed out again */
+    shootdownTLB(currentSupportStruct->sup_asid);
+    TLBCLR();
+
+    mutex(&swapPoolSemaphore, FALSE);
+}
+
+/*
+ * Function     :   shareEntry
+ * Purpose      :   Make a child's page table entry share its parent's page: the same
+ *                  backing block and, if the page is resident, the same frame, mapped
+ *                  read-only in both
+ * Parameters   :   parentEntry - the parent's entry
+ *                  childEntry - the child's entry, fresh from allocPageTable
+ * Returns      :   None
+ */
+HIDDEN void shareEntry(pte_t *parentEntry, pte_t *childEntry) {
+    childEntry->pt_backing = parentEntry->pt_backing;
+    addReference(parentEntry->pt_backing);
+
+    if ((parentEntry->pt_entryLO & VALIDON) != 0) {
+        parentEntry->pt_entryLO = parentEntry->pt_entryLO & DIRTYOFF;
+        childEntry->pt_entryLO  = parentEntry->pt_entryLO;
+        swapPoolTable[frameOf(parentEntry)].refs++;
+    }
+}
+
+/*
+ * Function     :   deviceFree
+ * Purpose      :   Tell whether a flash device can become a new address space's home:
+ *                  it must be installed, home to no live address space, and hold no
+ *                  block another address space still references
+ * Parameters   :   flashDev - flash device number
+ * Returns      :   TRUE if the device is free
+ */
+HIDDEN int deviceFree(int flashDev) {
+    devregarea_t *devRegArea = (devregarea_t *) RAMBASEADDR;
+    int i;
+
+    if ((flashDev < 0) || (flashDev >= DEVPERINT) ||
+        ((devRegArea->inst_dev[FLASHINT - OFFSET] & (1 << flashDev)) == 0) || (deviceRefs[flashDev] != 0)) {
+        return FALSE;
+    }
+    for (i = 1; i <= MAXASID; i++) {
+        if ((addressSpaces[i] != NULL) && (addressSpaces[i]->sup_flashDev == flashDev)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/*
+ * Function     :   registerAddressSpace
+ * Purpose      :   Give a new U-Proc's (still empty) address space an ASID, if its home
+ *                  is usable: the flash device must be free and its load image must
+ *                  start at a block that leaves room for at least one stack page
+ * Parameters   :   currentSupportStruct - the U-Proc's support structure, devices and
+ *                                         sup_blockBase set
+ * Returns      :   The ASID, also stored in sup_asid, or -1 if the home is not usable
+ *                  or all MAXASID are in use
+ */
+int registerAddressSpace(support_t *currentSupportStruct) {
+    int asid = -1;
+
+    mutex(&swapPoolSemaphore, TRUE);
+    if ((deviceFree(currentSupportStruct->sup_flashDev) == TRUE) && (currentSupportStruct->sup_blockBase >= 0) &&
+        (homeBlocks(currentSupportStruct) > 1)) {
+        asid = claimASID(currentSupportStruct);
+        zswapPurge(currentSupportStruct->sup_flashDev);     /* Pages of the device's last user */
+    }
+    mutex(&swapPoolSemaphore, FALSE);
+    return asid;
+}
+
+/*
+ * Function     :   duplicateAddressSpace
+ * Purpose      :   Give a child U-Proc a copy-on-write duplicate of its parent's address
+ *                  space (SYS26). The child's home device must be free and at least as
+ *                  large as the parent's. Each of the parent's second-level tables is
+ *                  copied, the child's entries sharing the parent's blocks and resident
+ *                  frames: text/data pages up to where the parent's stack starts on its
+ *                  device (so image pages the parent never faulted are shared too), and
+ *                  the stack pages the parent touched. Both text high-water marks then
+ *                  cover the shared pages, so neither stack can grow over them
+ * Parameters   :   parent - support structure of the calling U-Proc
+ *                  child - the child's support structure: devices set, directory empty
+ * Returns      :   The child's ASID, or -1 if it could not be created
+ */
+int duplicateAddressSpace(support_t *parent, support_t *child) {
+    /* ------------------------------------------------------------ *
+     * 0. Initialize Local Variables
+     * ------------------------------------------------------------ */
+    int parentBlocks = homeBlocks(parent);                          /* size of the parent's home */
+    int textLimit = parentBlocks - parent->sup_stackPages;          /* text/data pages that can be shared */
+    int textShared = 0;                                             /* text/data pages shared */
+    int i, j, asid;
+
+    mutex(&swapPoolSemaphore, TRUE);
+
+    /* ------------------------------------------------------------ *
+     * 1. Check the child's home, and count references to the parent's
+     * ------------------------------------------------------------ */
+    if ((deviceFree(child->sup_flashDev) == FALSE) || (homeBlocks(child) < parentBlocks) ||
+        (flashBlocks(parent->sup_flashDev) > MAXSHAREDBLOCKS)) {
+        mutex(&swapPoolSemaphore, FALSE);
+        return -1;
+    }
+    if (blockRefs[parent->sup_flashDev] == NULL) {
+        if ((blockRefs[parent->sup_flashDev] = allocPage()) == NULL) {
+            mutex(&swapPoolSemaphore, FALSE);
+            return -1;
+        }
+        for (i = 0; i < MAXSHAREDBLOCKS; i++) {
+            blockRefs[parent->sup_flashDev][i] = 0;
+        }
+    }
+
+    /* ------------------------------------------------------------ *
+     * 2. Give the child an ASID
+     * ------------------------------------------------------------ */
+    if ((asid = claimASID(child)) < 0) {
+        mutex(&swapPoolSemaphore, FALSE);
+        return -1;
+    }
+    zswapPurge(child->sup_flashDev);
+
+    /* ------------------------------------------------------------ *
+     * 3. Copy the page tables, sharing every page read-only
+     * ------------------------------------------------------------ */
+    for (i = 0; i < TEXTTABLES; i++) {
+        if (parent->sup_textPgTbl[i] == NULL) {
+            continue;
+        }
+        if ((child->sup_textPgTbl[i] = allocPageTable(child, i * PTESPERTABLE, FALSE)) == NULL) {
+            freeAddressSpace(child);
+            mutex(&swapPoolSemaphore, FALSE);
+            return -1;
+        }
+        for (j = 0; (j < PTESPERTABLE) && ((i * PTESPERTABLE) + j < textLimit); j++) {
+            shareEntry(&(parent->sup_textPgTbl[i][j]), &(child->sup_textPgTbl[i][j]));
+            textShared = (i * PTESPERTABLE) + j + 1;
+        }
+    }
+    for (i = 0; i < STACKTABLES; i++) {
+        if (parent->sup_stackPgTbl[i] == NULL) {
+            continue;
+        }
+        if ((child->sup_stackPgTbl[i] = allocPageTable(child, i * PTESPERTABLE, TRUE)) == NULL) {
+            freeAddressSpace(child);
+            mutex(&swapPoolSemaphore, FALSE);
+            return -1;
+        }
+        for (j = 0; (j < PTESPERTABLE) && ((i * PTESPERTABLE) + j < parent->sup_stackPages); j++) {
+            shareEntry(&(parent->sup_stackPgTbl[i][j]), &(child->sup_stackPgTbl[i][j]));
+        }
+    }
+    parent->sup_textPages = MAX(parent->sup_textPages, textShared);
+    child->sup_imageText  = parent->sup_imageText;
+    child->sup_textPages  = parent->sup_textPages;
+    child->sup_stackPages = parent->sup_stackPages;
+
+    /* ------------------------------------------------------------ *
+     * 4. The parent's writable TLB entries are stale: flush them
+     * ------------------------------------------------------------ */
+    TLBCLR();
+    shootdownTLB(parent->sup_asid);
+
+    mutex(&swapPoolSemaphore, FALSE);
+    return asid;
+}
+
+/*
+ * Function     :   copyOnWrite
+ * Purpose      :   Handle a TLB-Modification: the first write to a page mapped read-only
+ *                  because its backing block or its frame is shared, or because it is
+ *                  image text. If the block is the faulting U-Proc's home, the page is
+ *                  first written to the home block of every other address space still
+ *                  referencing the block (and unmapped from those sharing its frame,
+ *                  which refault their own copy). Otherwise the page moves to the
+ *                  U-Proc's own home block. Either way it keeps its frame if no one else
+ *                  maps it, or else takes a copy of it in a new frame, and ends up
+ *                  private and writable
+ * Parameters   :   currentSupportStruct - support structure of the faulting U-Proc
+ *                  savedState - the faulting U-Proc's saved state
+ * Returns      :   None (resumes the U-Proc, or terminates it on a flash error)
+ */
+HIDDEN void copyOnWrite(support_t *currentSupportStruct, state_PTR savedState) {
+    /* ------------------------------------------------------------ *
+     * 0. Initialize Local Variables
+     * ------------------------------------------------------------ */
+    unsigned int vpn;                   /* Page written to */
+    unsigned int backing;               /* Its shared backing block */
+    pte_t *page;                        /* Its page table entry */
+    pte_t *sharer;                      /* Another address space's entry for the page */
+    int frameNumber;                    /* Frame the page occupies */
+    int copyNumber;                     /* Frame the writable page ends up in */
+    memaddr *frameAddress, *copyAddress;
+    int i, status;
+    int asid = EMPTYFRAME;              /* Owner of the original frame after the copy */
+
+    /* ------------------------------------------------------------ *
+     * 1. Acquire mutual exclusion over the Swap Pool table and find the page
+     * ------------------------------------------------------------ */
+    mutex(&swapPoolSemaphore, TRUE);
+    vpn  = ((savedState->s_entryHI) & VPNMASK) >> VPNSHIFT;
+    page = pageEntry(currentSupportStruct, vpn);
+
+    /* The page was evicted, or made writable, since this TLB entry was loaded: retry */
+    if ((page == NULL) || ((page->pt_entryLO & VALIDON) == 0) || ((page->pt_entryLO & DIRTYON) != 0)) {
+        if (page != NULL) {
+            setInterrupt(FALSE);
+            updateTLB(page);
+            setInterrupt(TRUE);
+        }
+        mutex(&swapPoolSemaphore, FALSE);
+        LDST(savedState);
+    }
+
+    frameNumber  = frameOf(page);
+    frameAddress = (memaddr *) ((frameNumber * PAGESIZE) + swapPoolStart);
+    backing      = page->pt_backing;
+    copyNumber   = frameNumber;
+
+    if (BACKINGDEV(backing) == currentSupportStruct->sup_flashDev) {
+        /* ------------------------------------------------------------ *
+         * 2. The block is our home: give every other user its own copy
+         * ------------------------------------------------------------ */
+        for (i = 1; i <= MAXASID; i++) {
+            if ((addressSpaces[i] == NULL) || (addressSpaces[i] == currentSupportStruct)) {
+                continue;
+            }
+            sharer = pageEntry(addressSpaces[i], vpn);
+            if ((sharer == NULL) || (sharer->pt_backing != backing)) {
+                continue;
+            }
+
+            status = zswapPageOut(currentSupportStruct, (memaddr) frameAddress, addressSpaces[i]->sup_flashDev,
+                                  BACKINGBLK(homeBacking(addressSpaces[i], vpn)));
+            if (status != READY) {
+                mutex(&swapPoolSemaphore, FALSE);
+                VMprogramTrapExceptionHandler(currentSupportStruct);
+            }
+
+            if (((sharer->pt_entryLO & VALIDON) != 0) && (frameOf(sharer) == frameNumber)) {
+                unmapPage(sharer, i);
+                swapPoolTable[frameNumber].refs--;
+            }
+            dropReference(backing);
+            sharer->pt_backing = homeBacking(addressSpaces[i], vpn);
+        }
+    } else {
+        /* ------------------------------------------------------------ *
+         * 3. The block is another's: move the page to our home block
+         * ------------------------------------------------------------ */
+        dropReference(backing);
+        page->pt_backing = homeBacking(currentSupportStruct, vpn);
+    }
+
+    /* ------------------------------------------------------------ *
+     * 4. Others still map the frame (a SYS26 sharer, or an identical
+     *    image's): copy it into a frame of our own
+     * ------------------------------------------------------------ */
+    if (swapPoolTable[frameNumber].refs > 1) {
+        copyNumber = pageReplacement(frameNumber);
+        if ((copyNumber == frameNumber) ||
+            ((swapPoolTable[copyNumber].asid != EMPTYFRAME) && (evictFrame(currentSupportStruct, copyNumber) != READY))) {
+            mutex(&swapPoolSemaphore, FALSE);
+            VMprogramTrapExceptionHandler(currentSupportStruct);
+        }
+        copyAddress = (memaddr *) ((copyNumber * PAGESIZE) + swapPoolStart);
+        for (i = 0; i < (PAGESIZE / WORDLEN); i++) {
+            copyAddress[i] = frameAddress[i];
+        }
+
+        /* The original stays with the other sharers; if none maps it after all (refs
+           and the page tables disagree), the frame is free */
+        swapPoolTable[frameNumber].refs--;
+        if (swapPoolTable[frameNumber].pte == page) {
+            swapPoolTable[frameNumber].pte  = findMapping(frameNumber, page, &asid);
+            swapPoolTable[frameNumber].asid = (swapPoolTable[frameNumber].pte != NULL) ? asid : EMPTYFRAME;
+        }
+    }
+
+    /* ------------------------------------------------------------ *
+     * 5. The page is private now: record its frame and map it writable
+     * ------------------------------------------------------------ */
+    swapPoolTable[copyNumber].asid  = currentSupportStruct->sup_asid;
+    swapPoolTable[copyNumber].vpn   = vpn;
+    swapPoolTable[copyNumber].flash = BACKINGDEV(page->pt_backing);
+    swapPoolTable[copyNumber].block = BACKINGBLK(page->pt_backing);
+    swapPoolTable[copyNumber].pte   = page;
+    swapPoolTable[copyNumber].refs  = 1;
+    swapPoolTable[copyNumber].dirty = TRUE;
+    swapPoolTable[copyNumber].hash  = 0;                    /* No longer a pristine image page */
+
+    setInterrupt(FALSE);
+    page->pt_entryLO = ((copyNumber * PAGESIZE) + swapPoolStart) | VALIDON | DIRTYON;
+    updateTLB(page);
+    setInterrupt(TRUE);
+
+    /* ------------------------------------------------------------ *
+     * 6. Release the Swap Pool table and retry the write
+     * ------------------------------------------------------------ */
+    mutex(&swapPoolSemaphore, FALSE);
+    LDST(savedState);
+}
+
+/************************* IMAGE PAGE SHARING *************************/
+
+/*
+ * Function     :   readImageHeader
+ * Purpose      :   Learn how many pages of a U-Proc's load image are .text from the aout
+ *                  header at the start of page 0, which the pager has just read. Those
+ *                  pages are mapped read-only, so identical images can share them
+ * Parameters   :   currentSupportStruct - support structure of the faulting U-Proc
+ *                  frameAddress - address of the frame holding text/data page 0
+ * Returns      :   None
+ */
+HIDDEN void readImageHeader(support_t *currentSupportStruct, memaddr frameAddress) {
+    unsigned int textSize = *((unsigned int *) (frameAddress + AOUTTEXTSIZE));
+
+    /* Only whole pages of .text: the last one may hold the start of .data */
+    currentSupportStruct->sup_imageText = MIN(textSize / PAGESIZE, MAXTEXTPAGES);
+}
+
+/*
+ * Function     :   isImageText
+ * Purpose      :   Tell whether a page is read-only .text of its U-Proc's load image
+ * Parameters   :   currentSupportStruct - support structure of the page's U-Proc
+ *                  vpn - virtual page number of the page
+ * Returns      :   TRUE if the page is image text
+ */
+HIDDEN int isImageText(support_t *currentSupportStruct, unsigned int vpn) {
+    return (vpn - VPNSTART) < (unsigned int) currentSupportStruct->sup_imageText;
+}
+
+/*
+ * Function     :   pageHash
+ * Purpose      :   Hash a frame's contents (FNV-1a over its words), so frames holding
+ *                  the same image page can be found without comparing every frame
+ * Parameters   :   frameAddress - address of the frame
+ * Returns      :   The hash, never 0 (which marks a frame that is not shareable)
+ */
+HIDDEN unsigned int pageHash(memaddr frameAddress) {
+    unsigned int *word = (unsigned int *) frameAddress;
+    unsigned int hash = FNVBASIS;
+    int i;
+
+    for (i = 0; i < (PAGESIZE / WORDLEN); i++) {
+        hash = (hash ^ word[i]) * FNVPRIME;
+    }
+    return (hash == 0) ? 1 : hash;
+}
+
+/*
+ * Function     :   findTwin
+ * Purpose      :   Find another resident frame holding the same image text page as the
+ *                  one just read: same VPN (sharers always map a frame at one VPN), same
+ *                  hash, and, so a hash collision never shares a page, the same words.
+ *                  Must be called while holding the Swap Pool semaphore
+ * Parameters   :   frameNumber - index into the Swap Pool table of the page just read
+ *                  vpn - its virtual page number
+ *                  hash - its pageHash
+ * Returns      :   Index into the Swap Pool table of the twin, or -1 if there is none
+ */
+HIDDEN int findTwin(int frameNumber, unsigned int vpn, unsigned int hash) {
+    unsigned int *page = (unsigned int *) ((frameNumber * PAGESIZE) + swapPoolStart);
+    unsigned int *twin;
+    int i, j;
+
+    for (i = 0; i < swapPoolSize; i++) {
+        if ((i == frameNumber) || (swapPoolTable[i].asid == EMPTYFRAME) ||
+            (swapPoolTable[i].hash != hash) || (swapPoolTable[i].vpn != (int) vpn)) {
+            continue;
+        }
+        twin = (unsigned int *) ((i * PAGESIZE) + swapPoolStart);
+        for (j = 0; (j < (PAGESIZE / WORDLEN)) && (twin[j] == page[j]); j++) {
+            ;
+        }
+        if (j == (PAGESIZE / WORDLEN)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
 /******************************* PAGER FUNCTION *******************************/
 
 /*
@@ -178,23 +1037,30 @@ void updateTLB(pte_t *ptEntry) {
  *                  It coordinates swap-out of victim pages, swap-in of requested page, 
  *                  updates page table and TLB, and resumes execution at faulting instruction.
  *                  Workflow includes 14 steps as described in the project description
- * Parameters   :   None
+ * Parameters   :   currentSupportStruct - the faulting U-Proc's support structure, delivered
+ *                                         in a0 by the nucleus when it passes the exception up
  * Returns      :   None
  *  
  */
-void pager(void) {
+void pager(support_t *currentSupportStruct) {
     /* --------------------------------------------------------------
      * 0. Initialize Local Variables 
      * -------------------------------------------------------------- */
     unsigned int exceptionCode;         /* Exception code for the TLB exception */
-    int missingPageNo;                  /* Page number of the missing TLB entry */
+    unsigned int missingPageNo;         /* Page number of the missing TLB entry */
+    pte_t *missingPage;                 /* Page table entry of the missing page */
     int frameNumber;                    /* Frame number of the page to be swapped in */
     int frameAddress;                   /* Frame address of the page to be swapped in */
+    unsigned int hash;                  /* Content hash of an image text page, else 0 */
+    int twin;                           /* Frame already holding the same image text page, or -1 */
 
     /*--------------------------------------------------------------*
-    * 1. Obtain the pointer to the Current Process's Support Structure
+    * 1. Check the stack the nucleus handed us (the Support Structure arrived in a0)
     *---------------------------------------------------------------*/
-    support_t *currentSupportStruct = (support_t *) SYSCALL(SYS8CALL, 0, 0, 0);
+    /* A pager that overran this stack last time has clobbered the guard band: treat as a trap */
+    if (stackIntact(currentSupportStruct->sup_exceptContext[PGFAULTEXCEPT].c_stackPtr) == FALSE) {
+        VMprogramTrapExceptionHandler(currentSupportStruct);
+    }
 
     /*--------------------------------------------------------------*
     * 2. Determine the case of the TLB exception
@@ -206,10 +1072,10 @@ void pager(void) {
     exceptionCode = ((savedState->s_cause) & GETEXCEPTIONCODE) >> CAUSESHIFT;
 
     /*--------------------------------------------------------------*
-    * 3. If the Cause if a TLB-Modification exception, treat as Program Trap
+    * 3. If the Cause is a TLB-Modification exception, the page is shared: copy it on write
     *---------------------------------------------------------------*/    
     if (exceptionCode == TLBMODIFICATION) {
-        VMprogramTrapExceptionHandler(currentSupportStruct);          /* Terminate the process */
+        copyOnWrite(currentSupportStruct, savedState);                /* Resumes the process */
     }
 
     /*--------------------------------------------------------------*
@@ -217,19 +1083,34 @@ void pager(void) {
     *---------------------------------------------------------------*/ 
     mutex(&swapPoolSemaphore, TRUE);
 
+    /* Update this U-Proc's working set estimate and rebalance the load; if the load
+       controller has suspended this U-Proc, it waits here until resumed */
+    noteFault(currentSupportStruct);
+    loadControl();
+    loadCheckpoint(currentSupportStruct);
+
     /*--------------------------------------------------------------*
     * 5. Determine the missing page number, found in saved exception state's entryHI
     *---------------------------------------------------------------*/ 
-    missingPageNo = (((savedState->s_entryHI) & VPNMASK) >> VPNSHIFT) % NUMPAGES;
+    missingPageNo = ((savedState->s_entryHI) & VPNMASK) >> VPNSHIFT;
+
+    /* Walk (and, on first touch, extend) the two-level page table */
+    missingPage = lookupPage(currentSupportStruct, missingPageNo);
+
+    /* An address outside the text/data and stack regions is reported, not aliased */
+    if (missingPage == NULL) {
+        mutex(&swapPoolSemaphore, FALSE);
+        VMprogramTrapExceptionHandler(currentSupportStruct);          /* Terminate the process */
+    }
 
     /*--------------------------------------------------------------*
     * 6. Pick a frame from the Swap Pool
     *---------------------------------------------------------------*/ 
     /* Frame is chosen by the page replacement algorithm provided above */
-    frameNumber = pageReplacement();                     
+    frameNumber = pageReplacement(-1);                   
 
     /* Calculate the frame address */
-    frameAddress = (frameNumber * PAGESIZE) + SWAPPOOLSTART;    
+    frameAddress = (frameNumber * PAGESIZE) + swapPoolStart;    
     
     /*--------------------------------------------------------------*
     * 7. Determine if the frame is occupied
@@ -237,48 +1118,67 @@ void pager(void) {
     /* Examine frameNumber entry in the Swap Pool table */
     if (swapPoolTable[frameNumber].asid != EMPTYFRAME)  {
         /*--------------------------------------------------------------*
-         * 8. If the frame is occupied, swap out the page
+         * 8. If the frame is occupied, swap out the page (from every sharer)
          *---------------------------------------------------------------*/ 
-        /* NOTE: Disable interrupt to ensure that the next two steps are performed atomically */
-        setInterrupt(FALSE); 
-
-        /* a. Update process's Page Table: mark Page Table entry as not valid */
-        swapPoolTable[frameNumber].pte->pt_entryLO = swapPoolTable[frameNumber].pte->pt_entryLO & VALIDOFF;
-
-        /* b. Update the TLB */
-        updateTLB(swapPoolTable[frameNumber].pte);      
-
-        /* NOTE: Enable interrupt again, end of atomically steps (a & b) */
-        setInterrupt(TRUE); 
-
-        /* c. Update process's backing store */
-        int status1 = flashOperation(currentSupportStruct, frameAddress, swapPoolTable[frameNumber].asid - 1, swapPoolTable[frameNumber].vpn, FLASHWRITE);  
+        int status1 = evictFrame(currentSupportStruct, frameNumber);
 
         /* Check the status code returned to see if an error occurred */
-
         if (status1 != READY) {
-            /* Terminate the current process */
+            /* Release the Swap Pool before terminating the current process */
+            mutex(&swapPoolSemaphore, FALSE);
             VMprogramTrapExceptionHandler(currentSupportStruct); 
         }
     }
     
     /*--------------------------------------------------------------*
-    * 9. Read the contents of the Current Process's backing store/flash device
+    * 9. Read the contents of the page's backing block (its home, or a shared block),
+    *    from the compressed tier if it holds the block
     *---------------------------------------------------------------*/ 
-    int status2 = flashOperation(currentSupportStruct, frameAddress, currentSupportStruct->sup_asid - 1, missingPageNo, FLASHREAD);
+    int status2 = zswapPageIn(currentSupportStruct, frameAddress, BACKINGDEV(missingPage->pt_backing),
+                              BACKINGBLK(missingPage->pt_backing));
     
     /* Check the status code returned to see if an error occurred */
     if (status2 != READY) {
-        /* Terminate the current process */
+        /* The frame no longer holds the evicted page; release it and the Swap Pool, then terminate */
+        swapPoolTable[frameNumber].asid = EMPTYFRAME;
+        mutex(&swapPoolSemaphore, FALSE);
         VMprogramTrapExceptionHandler(currentSupportStruct); 
     }
 
     /*--------------------------------------------------------------*
     * 10. Update the Swap Pool table's entry to reflect frame's new content
     *---------------------------------------------------------------*/ 
-    swapPoolTable[frameNumber].vpn  = missingPageNo;
-    swapPoolTable[frameNumber].asid = currentSupportStruct->sup_asid;
-    swapPoolTable[frameNumber].pte  = &(currentSupportStruct->sup_privatePgTbl[missingPageNo]);
+    /* Page 0 of the image carries the aout header: learn how much of it is .text */
+    if ((missingPageNo == VPNSTART) && (currentSupportStruct->sup_imageText == 0)) {
+        readImageHeader(currentSupportStruct, frameAddress);
+    }
+
+    /* Image text another U-Proc already has in a frame (an identical image) shares that frame */
+    hash = 0;
+    twin = -1;
+    if (isImageText(currentSupportStruct, missingPageNo) == TRUE) {
+        hash = pageHash(frameAddress);
+        twin = findTwin(frameNumber, missingPageNo, hash);
+    }
+
+    if (twin >= 0) {
+        swapPoolTable[frameNumber].asid = EMPTYFRAME;
+        frameNumber  = twin;
+        frameAddress = (frameNumber * PAGESIZE) + swapPoolStart;
+        swapPoolTable[frameNumber].refs++;
+    } else {
+        swapPoolTable[frameNumber].vpn   = missingPageNo;
+        swapPoolTable[frameNumber].flash = BACKINGDEV(missingPage->pt_backing);
+        swapPoolTable[frameNumber].block = BACKINGBLK(missingPage->pt_backing);
+        swapPoolTable[frameNumber].asid  = currentSupportStruct->sup_asid;
+        swapPoolTable[frameNumber].pte   = missingPage;
+        swapPoolTable[frameNumber].refs  = 1;
+        swapPoolTable[frameNumber].hash  = hash;
+
+        /* Only a page we alone use may be written: a shared one stays clean until copied
+           on write, and so does image text, which is seldom written at all */
+        swapPoolTable[frameNumber].dirty = (hash == 0) && isPrivate(currentSupportStruct, missingPage->pt_backing);
+    }
 
     /*--------------------------------------------------------------*
     * 11. Update the Current Process's Page Table entry 
@@ -287,12 +1187,13 @@ void pager(void) {
     setInterrupt(FALSE);
 
     /* Page missingPageNo is now present (V bit) and occupying frame frameAddress */
-    currentSupportStruct->sup_privatePgTbl[missingPageNo].pt_entryLO = frameAddress | VALIDON | DIRTYON;
+    missingPage->pt_entryLO = frameAddress | VALIDON | ((swapPoolTable[frameNumber].dirty == TRUE) ? DIRTYON : ALLOFF);
+    SUPTRACE(TRPAGEFAULT, currentSupportStruct->sup_asid, missingPageNo, frameNumber);
 
     /*--------------------------------------------------------------*
     * 12. Update the TLB
     *---------------------------------------------------------------*/ 
-    updateTLB(&(currentSupportStruct->sup_privatePgTbl[missingPageNo]));
+    updateTLB(missingPage);
     
     /* NOTE: Enable interrupt again, end of atomically step (11 & 12) */
     setInterrupt(TRUE);
@@ -0,0 +1,522 @@
+/******************************* ZSWAP.c ***************************************
+ *
+ * This module implements a compressed swap tier in RAM, in front of the flash
+ * devices. When the pager evicts a dirty page, zswapPageOut compresses it and
+ * keeps it in the tier instead of writing its backing block; zswapPageIn serves
+ * a later fault on the block from the tier, without device I/O. Only when the
+ * tier runs out of room is its oldest page written to flash, together with a few
+ * more of the same device's old pages, in block order, under one hold of the
+ * device (a cluster), so the device and SYS5 overheads are paid once per batch.
+ * If that write-back fails, the page being evicted goes straight to flash.
+ *
+ * Pages are compressed by run-length coding their words: the stream is a series
+ * of tokens, (count << 1) | 1 followed by one word repeated count times, or
+ * (count << 1) followed by count literal words. Zero-filled and sparsely used
+ * pages, the common case for stacks and heaps, shrink to a few words; a page
+ * that does not fit in 3/4 of a page is written to flash directly.
+ *
+ * The tier is 1/ZSWAPSHARE of the frames left after the Swap Pool, cut into
+ * chunks of ZCHUNKWORDS words. A compressed page occupies a chain of chunks
+ * (zNext), found through a hash of its (flash device, block), and all pages
+ * are kept in age order for write-back. A page stays in the tier after it is
+ * paged in, since the frame may be clean (a block shared by SYS26 is read by
+ * address spaces that never write it); the entry is replaced when the block
+ * is paged out again and dropped with the device's pages when the device gets
+ * a new address space. Every function here must be called while holding the
+ * Swap Pool semaphore, which also guards the bounce frame used for write-back.
+ *
+ * Written by  : Uyen Nguyen
+ * Last update : 2025/06/09
+ *
+ ***********************************************************************************/
+
+#include "../h/const.h"
+#include "../h/types.h"
+#include "../h/initProc.h"
+#include "../h/vmSupport.h"
+#include "../h/sysSupport.h"
+#include "../h/deviceSupportDMA.h"
+#include "../h/slab.h"
+#include "../h/zswap.h"
+#include "/usr/include/umps3/umps/libumps.h"
+
+/******************************* GLOBAL VARIABLES *****************************/
+
+HIDDEN unsigned int *zRegion;                   /* The chunks */
+HIDDEN int zChunks;                             /* Number of chunks, 0 if the tier is off */
+HIDDEN int *zNext;                              /* Per chunk: the next chunk of its page, or on the free list */
+HIDDEN int zFreeChunk;                          /* Head of the free chunk list */
+HIDDEN zentry_t *zEntries;                      /* One entry per stored page, at most one per chunk */
+HIDDEN int zFreeEntry;                          /* Head of the free entry list */
+HIDDEN int zBuckets[ZBUCKETS];                  /* Entries by hash of (flash device, block) */
+HIDDEN int zOldest, zNewest;                    /* Ends of the age list */
+HIDDEN unsigned int zStage[ZMAXWORDS];          /* A page being compressed */
+HIDDEN memaddr zBounce;                         /* Frame a page is decompressed into for write-back */
+HIDDEN zswapstat_t zStats;                      /* SYS28's counters */
+
+/******************************* HELPER FUNCTIONS *****************************/
+
+/*
+ * Function     :   zBucket
+ * Purpose      :   Hash a backing block to its bucket
+ * Parameters   :   flash - flash device number
+ *                  block - block number
+ * Returns      :   The bucket, in [0..ZBUCKETS - 1]
+ */
+HIDDEN int zBucket(int flash, int block) {
+    return ((flash * 31) + block) % ZBUCKETS;
+}
+
+/*
+ * Function     :   zFind
+ * Purpose      :   Find the stored page of a backing block
+ * Parameters   :   flash - flash device number
+ *                  block - block number
+ * Returns      :   Index of its entry, or ZNONE
+ */
+HIDDEN int zFind(int flash, int block) {
+    int e;
+
+    for (e = zBuckets[zBucket(flash, block)]; e != ZNONE; e = zEntries[e].ze_hashNext) {
+        if ((zEntries[e].ze_flash == flash) && (zEntries[e].ze_block == block)) {
+            return e;
+        }
+    }
+    return ZNONE;
+}
+
+/*
+ * Function     :   zRelease
+ * Purpose      :   Forget a stored page: unlink its entry from its bucket and the age
+ *                  list, and return the entry and its chunks to their free lists
+ * Parameters   :   e - index of the entry
+ * Returns      :   None
+ */
+HIDDEN void zRelease(int e) {
+    zentry_t *entry = &zEntries[e];
+    int *link;
+    int chunk, last;
+
+    /* 1. Out of its bucket */
+    for (link = &zBuckets[zBucket(entry->ze_flash, entry->ze_block)]; *link != e; link = &(zEntries[*link].ze_hashNext)) {
+        ;
+    }
+    *link = entry->ze_hashNext;
+
+    /* 2. Out of the age list */
+    if (entry->ze_older != ZNONE) {
+        zEntries[entry->ze_older].ze_newer = entry->ze_newer;
+    } else {
+        zOldest = entry->ze_newer;
+    }
+    if (entry->ze_newer != ZNONE) {
+        zEntries[entry->ze_newer].ze_older = entry->ze_older;
+    } else {
+        zNewest = entry->ze_older;
+    }
+
+    /* 3. Its chunk chain joins the free chunks */
+    last = entry->ze_first;
+    zStats.zs_usedChunks--;
+    for (chunk = zNext[last]; chunk != ZNONE; chunk = zNext[chunk]) {
+        last = chunk;
+        zStats.zs_usedChunks--;
+    }
+    zNext[last] = zFreeChunk;
+    zFreeChunk  = entry->ze_first;
+
+    /* 4. And the entry the free entries */
+    entry->ze_hashNext = zFreeEntry;
+    zFreeEntry = e;
+}
+
+/*
+ * Function     :   zCompress
+ * Purpose      :   Run-length code a page into zStage
+ * Parameters   :   page - the page's words
+ * Returns      :   The compressed length in words, or -1 if it exceeds ZMAXWORDS
+ */
+HIDDEN int zCompress(unsigned int *page) {
+    int words = PAGESIZE / WORDLEN;
+    int i = 0, out = 0;
+    int run, start, j;
+
+    while (i < words) {
+        /* 1. A run of one word long enough to pay for its token */
+        for (run = 1; (i + run < words) && (page[i + run] == page[i]); run++) {
+            ;
+        }
+        if (run >= ZMINRUN) {
+            if (out + 2 > ZMAXWORDS) {
+                return -1;
+            }
+            zStage[out++] = (run << 1) | 1;
+            zStage[out++] = page[i];
+            i += run;
+            continue;
+        }
+
+        /* 2. Otherwise literal words, up to the next such run */
+        start = i;
+        while (i < words) {
+            for (run = 1; (run < ZMINRUN) && (i + run < words) && (page[i + run] == page[i]); run++) {
+                ;
+            }
+            if (run >= ZMINRUN) {
+                break;
+            }
+            i++;
+        }
+        if (out + 1 + (i - start) > ZMAXWORDS) {
+            return -1;
+        }
+        zStage[out++] = (i - start) << 1;
+        for (j = start; j < i; j++) {
+            zStage[out++] = page[j];
+        }
+    }
+    return out;
+}
+
+/*
+ * Function     :   zRead
+ * Purpose      :   Read the next word of a compressed page, following its chunk chain
+ * Parameters   :   chunk - the current chunk, advanced when it is used up
+ *                  pos - position within it
+ * Returns      :   The word
+ */
+HIDDEN unsigned int zRead(int *chunk, int *pos) {
+    if (*pos == ZCHUNKWORDS) {
+        *chunk = zNext[*chunk];
+        *pos = 0;
+    }
+    return zRegion[(*chunk * ZCHUNKWORDS) + (*pos)++];
+}
+
+/*
+ * Function     :   zDecompress
+ * Purpose      :   Expand a stored page into a frame
+ * Parameters   :   e - index of the entry
+ *                  page - the frame's words
+ * Returns      :   None
+ */
+HIDDEN void zDecompress(int e, unsigned int *page) {
+    int chunk = zEntries[e].ze_first;
+    int pos = 0;
+    int read = 0, out = 0;
+    unsigned int token, value;
+    int count;
+
+    while (read < zEntries[e].ze_words) {
+        token = zRead(&chunk, &pos);
+        count = token >> 1;
+        read++;
+        if ((token & 1) != 0) {
+            value = zRead(&chunk, &pos);
+            read++;
+            while (count-- > 0) {
+                page[out++] = value;
+            }
+        } else {
+            read += count;
+            while (count-- > 0) {
+                page[out++] = zRead(&chunk, &pos);
+            }
+        }
+    }
+}
+
+/*
+ * Function     :   zWriteBack
+ * Purpose      :   Make room: write the oldest stored page to its backing block, with
+ *                  up to ZCLUSTER - 1 more of its flash device's pages from among the
+ *                  ZCLUSTERSCAN oldest, and forget them. The batch is written in block
+ *                  order, each page decompressed through the bounce frame, under one
+ *                  hold of the device, so consecutive blocks go out back to back
+ * Parameters   :   currentSupportStruct - support structure of the faulting U-Proc
+ * Returns      :   READY, or the negated device status if a write failed (the pages
+ *                  written before it are forgotten, the others stay in the tier), or
+ *                  BADBLOCKSTATUS if a page's block is past its device's end (that
+ *                  page is dropped). The device is often another U-Proc's, so the
+ *                  faulting U-Proc is never terminated while it is held here
+ */
+HIDDEN int zWriteBack(support_t *currentSupportStruct) {
+    int cluster[ZCLUSTER];
+    int flash = zEntries[zOldest].ze_flash;
+    int count = 0, scanned = 0;
+    int e, i, j, status = READY;
+
+    /* 1. Gather the oldest pages of the oldest page's device */
+    for (e = zOldest; (e != ZNONE) && (count < ZCLUSTER) && (scanned < ZCLUSTERSCAN); e = zEntries[e].ze_newer) {
+        if (zEntries[e].ze_flash == flash) {
+            cluster[count++] = e;
+        }
+        scanned++;
+    }
+
+    /* 2. Put them in block order */
+    for (i = 1; i < count; i++) {
+        e = cluster[i];
+        for (j = i; (j > 0) && (zEntries[cluster[j - 1]].ze_block > zEntries[e].ze_block); j--) {
+            cluster[j] = cluster[j - 1];
+        }
+        cluster[j] = e;
+    }
+
+    /* 3. Write them back to back, holding the device once */
+    flashLock(flash);
+    for (i = 0; (i < count) && (status == READY); i++) {
+        zDecompress(cluster[i], (unsigned int *) zBounce);
+        status = flashTransfer((int) zBounce, flash, zEntries[cluster[i]].ze_block, FLASHWRITE);
+        if (status == READY) {
+            zRelease(cluster[i]);
+            zStats.zs_writebacks++;
+        } else if (status == BADBLOCKSTATUS) {
+            /* Internal error: the block cannot take the page, and would stop every later write-back */
+            zRelease(cluster[i]);
+        }
+    }
+    flashUnlock(flash);
+
+    zStats.zs_clusters++;
+    return status;
+}
+
+/******************************* TIER OPERATIONS *****************************/
+
+/*
+ * Function     :   initZswap
+ * Purpose      :   Carve the tier, its chunk and entry tables and the bounce frame
+ *                  out of the free frames. Called by initSwapStructs once the Swap
+ *                  Pool has its frames. Without enough RAM the tier stays off and
+ *                  pages go straight to flash
+ * Parameters   :   None
+ * Returns      :   None
+ */
+void initZswap(void) {
+    int pages, metaPages, i;
+    char *meta;
+
+    /* 1. Size the region, then the tables its chunks need */
+    pages = freePageCount() / ZSWAPSHARE;
+    zChunks   = pages * ((PAGESIZE / WORDLEN) / ZCHUNKWORDS);
+    metaPages = ((zChunks * (sizeof(int) + sizeof(zentry_t))) + PAGESIZE - 1) / PAGESIZE;
+    pages     = pages - metaPages - 1;
+    zChunks   = pages * ((PAGESIZE / WORDLEN) / ZCHUNKWORDS);
+
+    /* 2. Take the frames; a page must fit in the tier, or there is no point */
+    zRegion = NULL;
+    meta    = NULL;
+    zBounce = (memaddr) NULL;
+    if (zChunks >= (ZMAXWORDS + ZCHUNKWORDS - 1) / ZCHUNKWORDS) {
+        zRegion = allocPages(pages);
+        meta    = allocPages(metaPages);
+        zBounce = (memaddr) allocPage();
+    }
+    if ((zRegion == NULL) || (meta == NULL) || (zBounce == (memaddr) NULL)) {
+        zChunks = 0;
+    }
+    zNext    = (int *) meta;
+    zEntries = (zentry_t *) (meta + (zChunks * sizeof(int)));
+
+    /* 3. Every chunk and entry is free */
+    for (i = 0; i < zChunks; i++) {
+        zNext[i] = i + 1;
+        zEntries[i].ze_hashNext = i + 1;
+    }
+    if (zChunks > 0) {
+        zNext[zChunks - 1] = ZNONE;
+        zEntries[zChunks - 1].ze_hashNext = ZNONE;
+    }
+    zFreeChunk = (zChunks > 0) ? 0 : ZNONE;
+    zFreeEntry = zFreeChunk;
+    for (i = 0; i < ZBUCKETS; i++) {
+        zBuckets[i] = ZNONE;
+    }
+    zOldest = ZNONE;
+    zNewest = ZNONE;
+
+    zStats.zs_stores = zStats.zs_rejects = zStats.zs_hits = zStats.zs_misses = 0;
+    zStats.zs_writebacks = zStats.zs_clusters = zStats.zs_inBytes = zStats.zs_outBytes = zStats.zs_usedChunks = 0;
+    zStats.zs_chunks = zChunks;
+}
+
+/*
+ * Function     :   zswapPageOut
+ * Purpose      :   Save a page evicted from a frame (or copied for another address
+ *                  space) as the new contents of a backing block: compressed in the
+ *                  tier, writing its oldest pages to flash if it is full, or, for a
+ *                  page that does not compress or when that write-back fails, directly
+ *                  to flash. Whatever the tier held for the block is dropped only once
+ *                  the new copy is stored, so a failed write never leaves a fault to
+ *                  read an older copy while the latest one is nowhere
+ * Parameters   :   currentSupportStruct - support structure of the faulting U-Proc
+ *                  frameAddress - address of the frame holding the page
+ *                  flash - flash device of the backing block
+ *                  block - the block
+ * Returns      :   READY, or the negated device status if the page could not be
+ *                  written (a failed write-back of another page is not reported)
+ */
+int zswapPageOut(support_t *currentSupportStruct, memaddr frameAddress, int flash, int block) {
+    int words, need, e, old, chunk, i, status;
+
+    /* 1. Compress the page */
+    words = (zChunks > 0) ? zCompress((unsigned int *) frameAddress) : -1;
+
+    /* 2. Make room by writing back the oldest pages */
+    need = (words + ZCHUNKWORDS - 1) / ZCHUNKWORDS;
+    status = READY;
+    while ((words >= 0) && (status == READY) &&
+           ((zChunks - (int) zStats.zs_usedChunks < need) || (zFreeEntry == ZNONE))) {
+        status = zWriteBack(currentSupportStruct);
+    }
+
+    /* 3. A page that does not compress, or finds no room, is written through */
+    if ((words < 0) || (status != READY)) {
+        if (zChunks > 0) {
+            zStats.zs_rejects++;
+        }
+        status = flashOperation(currentSupportStruct, (int) frameAddress, flash, block, FLASHWRITE);
+        if ((status == READY) && ((old = zFind(flash, block)) != ZNONE)) {
+            zRelease(old);
+        }
+        return status;
+    }
+
+    /* 4. Copy the compressed words into a chain of free chunks */
+    e = zFreeEntry;
+    zFreeEntry = zEntries[e].ze_hashNext;
+    zEntries[e].ze_flash = flash;
+    zEntries[e].ze_block = block;
+    zEntries[e].ze_words = words;
+    zEntries[e].ze_first = zFreeChunk;
+
+    chunk = zFreeChunk;
+    for (i = 0; i < words; i++) {
+        if ((i > 0) && ((i % ZCHUNKWORDS) == 0)) {
+            chunk = zNext[chunk];
+        }
+        zRegion[(chunk * ZCHUNKWORDS) + (i % ZCHUNKWORDS)] = zStage[i];
+    }
+    zFreeChunk   = zNext[chunk];
+    zNext[chunk] = ZNONE;
+
+    /* 5. The copy is stored: whatever the tier held for the block is stale now */
+    if ((old = zFind(flash, block)) != ZNONE) {
+        zRelease(old);
+    }
+
+    /* 6. Enter it in its bucket, as the newest page */
+    zEntries[e].ze_hashNext = zBuckets[zBucket(flash, block)];
+    zBuckets[zBucket(flash, block)] = e;
+    zEntries[e].ze_older = zNewest;
+    zEntries[e].ze_newer = ZNONE;
+    if (zNewest != ZNONE) {
+        zEntries[zNewest].ze_newer = e;
+    } else {
+        zOldest = e;
+    }
+    zNewest = e;
+
+    zStats.zs_stores++;
+    zStats.zs_usedChunks += need;
+    zStats.zs_inBytes    += PAGESIZE;
+    zStats.zs_outBytes   += words * WORDLEN;
+    return READY;
+}
+
+/*
+ * Function     :   zswapPageIn
+ * Purpose      :   Fill a frame with a backing block's contents: from the tier if it
+ *                  holds the block, else from flash
+ * Parameters   :   currentSupportStruct - support structure of the faulting U-Proc
+ *                  frameAddress - address of the frame
+ *                  flash - flash device of the backing block
+ *                  block - the block
+ * Returns      :   READY, or the negated device status if the read failed
+ */
+int zswapPageIn(support_t *currentSupportStruct, memaddr frameAddress, int flash, int block) {
+    int e;
+
+    if ((zChunks > 0) && ((e = zFind(flash, block)) != ZNONE)) {
+        zDecompress(e, (unsigned int *) frameAddress);
+        zStats.zs_hits++;
+        return READY;
+    }
+    zStats.zs_misses++;
+    return flashOperation(currentSupportStruct, (int) frameAddress, flash, block, FLASHREAD);
+}
+
+/*
+ * Function     :   zswapPurge
+ * Purpose      :   Forget every page of a flash device, which no address space uses
+ *                  any more (or which is about to back a new one)
+ * Parameters   :   flash - flash device number
+ * Returns      :   None
+ */
+void zswapPurge(int flash) {
+    int e, newer;
+
+    for (e = zOldest; e != ZNONE; e = newer) {
+        newer = zEntries[e].ze_newer;
+        if (zEntries[e].ze_flash == flash) {
+            zRelease(e);
+        }
+    }
+}
+
+/******************************* SYSCALL IMPLEMENTATION *******************************/
+
+/*
+ * Function     :   getSwapStats
+ * Purpose      :   Implement SYS28 to report the compressed swap tier's counters. a1
+ *                  holds the virtual address of a zswapstat_t to receive them, or 0.
+ *                  The counters are read under the Swap Pool semaphore and stored
+ *                  after releasing it, since the store may page fault. Compression
+ *                  ratio is zs_inBytes / zs_outBytes
+ * Parameters   :   savedState - pointer to the user's saved processor state
+ *                  currentSupportStruct - user's support struct
+ * Returns      :   None (v0 holds the tier's hit rate over all page-ins, in percent,
+ *                  or -1 if nothing was paged in yet)
+ */
+void getSwapStats(state_PTR savedState, support_t *currentSupportStruct) {
+    zswapstat_t *buffer = (zswapstat_t *) savedState->s_a1;    /* optional user buffer */
+    zswapstat_t stats;                                          /* counters, read together */
+
+    /* A buffer must lie in the user segment: be brutal otherwise */
+    if ((buffer != 0) && ((int) buffer < KUSEG)) {
+        VMprogramTrapExceptionHandler(currentSupportStruct);
+    }
+
+    SYSCALL(SYS30CALL, (unsigned int) &swapPoolSemaphore, 0, 0);
+    stats.zs_stores     = zStats.zs_stores;
+    stats.zs_rejects    = zStats.zs_rejects;
+    stats.zs_hits       = zStats.zs_hits;
+    stats.zs_misses     = zStats.zs_misses;
+    stats.zs_writebacks = zStats.zs_writebacks;
+    stats.zs_clusters   = zStats.zs_clusters;
+    stats.zs_inBytes    = zStats.zs_inBytes;
+    stats.zs_outBytes   = zStats.zs_outBytes;
+    stats.zs_usedChunks = zStats.zs_usedChunks;
+    stats.zs_chunks     = zStats.zs_chunks;
+    SYSCALL(SYS31CALL, (unsigned int) &swapPoolSemaphore, 0, 0);
+
+    if (buffer != 0) {
+        buffer->zs_stores     = stats.zs_stores;
+        buffer->zs_rejects    = stats.zs_rejects;
+        buffer->zs_hits       = stats.zs_hits;
+        buffer->zs_misses     = stats.zs_misses;
+        buffer->zs_writebacks = stats.zs_writebacks;
+        buffer->zs_clusters   = stats.zs_clusters;
+        buffer->zs_inBytes    = stats.zs_inBytes;
+        buffer->zs_outBytes   = stats.zs_outBytes;
+        buffer->zs_usedChunks = stats.zs_usedChunks;
+        buffer->zs_chunks     = stats.zs_chunks;
+    }
+
+    savedState->s_v0 = ((stats.zs_hits + stats.zs_misses) > 0) ?
+                       (int) ((stats.zs_hits * 100) / (stats.zs_hits + stats.zs_misses)) : -1;
+    LDST(savedState);
+}
+
+/******************************* END OF ZSWAP.c *****************************/
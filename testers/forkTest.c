@@ -0,0 +1,72 @@
+/* Copy-on-write fork test (SYS26). Load forkTest into flash0 and a short test
+   (fibSeven, say) into flash1: forkTest waits for flash1 to be freed, then forks
+   onto it. Parent and child each overwrite half of a shared array and check
+   that the other half still holds the values from before the fork, so a write
+   by one side must never show through to the other. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define CHILDFLASH		1
+#define TRIES			10
+#define WORDS			2048			/* two pages */
+
+int shared[WORDS];
+
+/* Fill half (0 or 1) of the array with base + i */
+void fill(int half, int base) {
+	int i;
+
+	for (i = half * (WORDS / 2); i < (half + 1) * (WORDS / 2); i++)
+		shared[i] = base + i;
+}
+
+/* Does half (0 or 1) of the array hold base + i */
+int holds(int half, int base) {
+	int i;
+
+	for (i = half * (WORDS / 2); i < (half + 1) * (WORDS / 2); i++) {
+		if (shared[i] != base + i)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+void main() {
+	int child, tries;
+
+	print(WRITETERMINAL, "forkTest starts\n");
+	fill(0, 0);
+	fill(1, 0);
+
+	/* flash1 is free once the U-Proc test() started on it has terminated */
+	child = -1;
+	for (tries = 0; (child < 0) && (tries < TRIES); tries++) {
+		child = SYSCALL(FORK, CHILDFLASH, 0, 0);
+		if (child < 0)
+			SYSCALL(DELAY, 1, 0, 0);
+	}
+
+	if (child < 0) {
+		print(WRITETERMINAL, "forkTest error: SYS26 failed\n");
+	} else if (child == 0) {
+		/* Child: overwrite the second half */
+		fill(1, 5000);
+		if (holds(0, 0) && holds(1, 5000))
+			print(WRITETERMINAL, "forkTest ok: child sees its own copy\n");
+		else
+			print(WRITETERMINAL, "forkTest error: child's copy changed\n");
+	} else {
+		/* Parent: overwrite the first half, then let the child write too */
+		fill(0, 9000);
+		SYSCALL(DELAY, 1, 0, 0);
+		if (holds(0, 9000) && holds(1, 0))
+			print(WRITETERMINAL, "forkTest ok: parent sees its own copy\n");
+		else
+			print(WRITETERMINAL, "forkTest error: parent's copy changed\n");
+	}
+
+	print(WRITETERMINAL, "forkTest completed\n");
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -31,6 +31,14 @@
 #define DELAY           18
 #define PSEMVIRT        19
 #define VSEMVIRT        20
+#define INTSTATS        22
+#define SETTICKETS      23
+#define SETREALTIME     24
+#define DEADLINEMISSES  25
+#define FORK            26
+#define SPAWN           27
+#define SWAPSTATS       28
+#define LOADCONTROL     29
 
 #define SEG0			0x00000000
 #define SEG1			0x40000000
@@ -0,0 +1,73 @@
+/* Load control test (SYS29). One source, built as loadStressOff (load control
+   off) and loadStressOn (on). Load eight copies of one of them: each sweeps
+   STRESSPAGES pages of kuseg SWEEPS times, so the eight working sets together
+   overflow the Swap Pool. Each copy reports how long its sweeps took and when
+   it finished; the last finish time is the run's makespan. With load control
+   on, some copies wait while the others run without thrashing, and the last
+   copy should finish sooner than with load control off. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define STRESSPAGES		24
+#define FIRSTPAGE		32					/* past the image */
+#define SWEEPS			20
+#define MILLISECOND		1000
+
+#ifndef LOADON
+#define LOADON			TRUE
+#endif
+
+/* Format n in decimal so that it ends at end; return its first digit */
+char *decimal(unsigned int n, char *end) {
+	*end = EOS;
+	do {
+		*--end = '0' + (n % 10);
+		n /= 10;
+	} while (n != 0);
+	return end;
+}
+
+void main() {
+	unsigned int start, finish;
+	int p, sweep, corrupt;
+	int *word;
+	char digits[12];
+	char *name = LOADON ? "loadStressOn" : "loadStressOff";
+
+	print(WRITETERMINAL, name);
+	print(WRITETERMINAL, " starts\n");
+
+	/* Every copy sets the same mode, then all line up on the same pseudo-clock tick */
+	SYSCALL(LOADCONTROL, LOADON, 0, 0);
+	SYSCALL(DELAY, 1, 0, 0);
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	corrupt = FALSE;
+	for (sweep = 0; sweep < SWEEPS; sweep++) {
+		for (p = 0; p < STRESSPAGES; p++) {
+			word = (int *) (SEG2 + ((FIRSTPAGE + p) * PAGESIZE));
+			if ((sweep > 0) && (*word != ((sweep - 1) * STRESSPAGES) + p))
+				corrupt = TRUE;
+			*word = (sweep * STRESSPAGES) + p;
+		}
+	}
+	finish = SYSCALL(GET_TOD, 0, 0, 0);
+
+	if (corrupt) {
+		print(WRITETERMINAL, name);
+		print(WRITETERMINAL, " error: a page came back changed\n");
+	}
+
+	print(WRITETERMINAL, name);
+	print(WRITETERMINAL, ": sweeps took ");
+	print(WRITETERMINAL, decimal((finish - start) / MILLISECOND, &digits[11]));
+	print(WRITETERMINAL, "ms, finished ");
+	print(WRITETERMINAL, decimal(finish / MILLISECOND, &digits[11]));
+	print(WRITETERMINAL, "ms after boot\n");
+
+	print(WRITETERMINAL, name);
+	print(WRITETERMINAL, " completed\n");
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
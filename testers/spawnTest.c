@@ -0,0 +1,39 @@
+/* Spawn test (SYS27). Load spawnTest into flash0 and a short test (fibSeven,
+   say) into flash1. test() starts both at boot; once the U-Proc on flash1 has
+   terminated, spawnTest starts its image again, so fibSeven runs twice. A
+   spawn from flash0, which spawnTest itself runs from, must be refused. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define OWNFLASH		0
+#define JOBFLASH		1
+#define TRIES			10
+
+void main() {
+	int asid, tries;
+
+	print(WRITETERMINAL, "spawnTest starts\n");
+
+	if (SYSCALL(SPAWN, OWNFLASH, 0, 0) >= 0)
+		print(WRITETERMINAL, "spawnTest error: spawned from a device in use\n");
+	else
+		print(WRITETERMINAL, "spawnTest ok: device in use refused\n");
+
+	/* flash1 is free once the U-Proc test() started on it has terminated */
+	asid = -1;
+	for (tries = 0; (asid < 0) && (tries < TRIES); tries++) {
+		asid = SYSCALL(SPAWN, JOBFLASH, 0, 0);
+		if (asid < 0)
+			SYSCALL(DELAY, 1, 0, 0);
+	}
+
+	if (asid < 0)
+		print(WRITETERMINAL, "spawnTest error: SYS27 failed\n");
+	else
+		print(WRITETERMINAL, "spawnTest ok: flash1 started again\n");
+
+	print(WRITETERMINAL, "spawnTest completed\n");
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,138 @@
+/* Stride scheduling test: the Makefile builds strideFib1.umps to strideFib5.umps
+   from this file, with TICKETS 1 to 5. Load them into five flash devices. Each
+   U-Proc takes TICKETS tickets (SETTICKETS), lines up with the others on one
+   pseudo-clock tick, runs the same Fibonacci workload and reports the time it
+   took. With cpu shared 1:2:3:4:5 the copies finish in order 5, 4, 3, 2, 1,
+   after 3, 3.5, 4, 4.5 and 5 times the workload's solo run (round-robin would
+   finish them all together, after 5 times it). Each copy records its start and
+   finish times in sector STRIDESECTOR + TICKETS of disk0; the 1-ticket copy,
+   which should finish last, reads the others' records and checks the order and
+   that each took 6, 7, 8 and 9 tenths of its own time, within STRIDETOL. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#ifndef TICKETS
+#define TICKETS			1
+#endif
+
+#define FIBN			15
+#define FIBVALUE		610
+#define FIBROUNDS		40
+
+#define COPIES			5
+#define STRIDEDISK		0
+#define STRIDESECTOR	40					/* records in sectors 41 to 45 */
+#define STRIDESKEW		100000				/* starts more than this apart are another run's */
+#define STRIDETOL		8					/* percent of the 1-ticket copy's time */
+
+/* What each copy leaves in its sector */
+typedef struct record_t {
+	unsigned int	r_tickets;
+	unsigned int	r_start;
+	unsigned int	r_finish;
+} record_t;
+
+int fib (int i) {
+	if ((i == 1) || (i ==2))
+		return (1);
+		
+	return(fib(i-1)+fib(i-2));
+}
+
+/* Format n in decimal so that it ends at end; return its first digit */
+char *decimal(unsigned int n, char *end) {
+	*end = EOS;
+	do {
+		*--end = '0' + (n % 10);
+		n /= 10;
+	} while (n != 0);
+	return end;
+}
+
+/* Check the other copies' records against the 1-ticket copy's: the copy with t
+   tickets finished before the one with t - 1, after (11 - t) tenths of its time */
+void checkRecords(record_t *mine) {
+	record_t *record = (record_t *) (SEG2 + (21 * PAGESIZE));
+	unsigned int later = mine->r_finish;
+	unsigned int elapsed = mine->r_finish - mine->r_start;
+	unsigned int percent, expect;
+	char digits[12];
+	int t;
+
+	for (t = 2; t <= COPIES; t++) {
+		SYSCALL(DISK_GET, (int) record, STRIDEDISK, STRIDESECTOR + t);
+		if ((record->r_tickets != t) || (record->r_start - mine->r_start + STRIDESKEW > 2 * STRIDESKEW)) {
+			print(WRITETERMINAL, "strideFib error: the copy with ");
+			print(WRITETERMINAL, decimal(t, &digits[11]));
+			print(WRITETERMINAL, " tickets finished after the 1-ticket copy\n");
+			return;
+		}
+		if (record->r_finish >= later) {
+			print(WRITETERMINAL, "strideFib error: the copy with ");
+			print(WRITETERMINAL, decimal(t, &digits[11]));
+			print(WRITETERMINAL, " tickets finished out of order\n");
+			return;
+		}
+		later = record->r_finish;
+
+		percent = (record->r_finish - record->r_start) / (elapsed / 100);
+		expect = (11 - t) * 10;
+		if ((percent + STRIDETOL < expect) || (percent > expect + STRIDETOL)) {
+			print(WRITETERMINAL, "strideFib error: the copy with ");
+			print(WRITETERMINAL, decimal(t, &digits[11]));
+			print(WRITETERMINAL, " tickets took ");
+			print(WRITETERMINAL, decimal(percent, &digits[11]));
+			print(WRITETERMINAL, "% of the 1-ticket copy's time, not ");
+			print(WRITETERMINAL, decimal(expect, &digits[11]));
+			print(WRITETERMINAL, "%\n");
+			return;
+		}
+	}
+	print(WRITETERMINAL, "strideFib ok: finish order and times follow the tickets\n");
+}
+
+void main() {
+	record_t *mine = (record_t *) (SEG2 + (20 * PAGESIZE));
+	unsigned int start, finish;
+	char digits[12];
+	int i, ok;
+
+	print(WRITETERMINAL, "strideFib starts with ");
+	print(WRITETERMINAL, decimal(TICKETS, &digits[11]));
+	print(WRITETERMINAL, " tickets\n");
+
+	SYSCALL(SETTICKETS, TICKETS, 0, 0);
+
+	/* Line up with the other copies: all wake on the same pseudo-clock tick */
+	SYSCALL(DELAY, 1, 0, 0);
+
+	start = SYSCALL(GET_TOD, 0, 0, 0);
+	ok = TRUE;
+	for (i = 0; i < FIBROUNDS; i++) {
+		if (fib(FIBN) != FIBVALUE)
+			ok = FALSE;
+	}
+	finish = SYSCALL(GET_TOD, 0, 0, 0);
+
+	if (!ok)
+		print(WRITETERMINAL, "strideFib error: recursion problems\n");
+
+	print(WRITETERMINAL, "strideFib: ");
+	print(WRITETERMINAL, decimal(TICKETS, &digits[11]));
+	print(WRITETERMINAL, " tickets, finished after ");
+	print(WRITETERMINAL, decimal((finish - start) / 1000, &digits[11]));
+	print(WRITETERMINAL, " ms\n");
+
+	mine->r_tickets = TICKETS;
+	mine->r_start = start;
+	mine->r_finish = finish;
+	if (SYSCALL(DISK_PUT, (int) mine, STRIDEDISK, STRIDESECTOR + TICKETS) != READY)
+		print(WRITETERMINAL, "strideFib error: cannot write the record to disk0\n");
+	else if (TICKETS == 1)
+		checkRecords(mine);
+
+	print(WRITETERMINAL, "strideFib completed\n");
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
@@ -0,0 +1,123 @@
+/* Compressed swap tier test (SYS28). Writes STATPAGES pages of kuseg, more
+   than the Swap Pool holds alongside a few other U-Procs: even pages are
+   sparse (one word set), odd pages full of pseudo-random words, so evicted
+   pages are both stored in the tier and rejected by it. Every page is then
+   checked twice, paging the others back in, and the tier's counters are
+   reported: the pages stored and rejected, the compression ratio and the
+   hit rate SYS28 returns. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define STATPAGES		64
+#define FIRSTPAGE		32					/* past the image */
+#define PASSES			2
+#define RATIOSCALE		100
+
+/* Layout of the kernel's zswapstat_t, filled in by SWAPSTATS */
+typedef struct zswapstat_t {
+	unsigned int	zs_stores;
+	unsigned int	zs_rejects;
+	unsigned int	zs_hits;
+	unsigned int	zs_misses;
+	unsigned int	zs_writebacks;
+	unsigned int	zs_clusters;
+	unsigned int	zs_inBytes;
+	unsigned int	zs_outBytes;
+	unsigned int	zs_usedChunks;
+	unsigned int	zs_chunks;
+} zswapstat_t;
+
+/* Format n in decimal so that it ends at end; return its first digit */
+char *decimal(unsigned int n, char *end) {
+	*end = EOS;
+	do {
+		*--end = '0' + (n % 10);
+		n /= 10;
+	} while (n != 0);
+	return end;
+}
+
+/* The word at position i of page p */
+unsigned int expected(int p, int i) {
+	unsigned int x = (p * 2654435761U) ^ (i * 40503U) ^ 0x5A5A5A5A;
+
+	if ((p % 2) == 0)
+		return (i == p) ? x : 0;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return x;
+}
+
+unsigned int *page(int p) {
+	return (unsigned int *) (SEG2 + ((FIRSTPAGE + p) * PAGESIZE));
+}
+
+void main() {
+	zswapstat_t stats;
+	unsigned int ratio;
+	int p, i, pass, hitRate, corrupt;
+	char digits[12];
+
+	print(WRITETERMINAL, "swapStats starts\n");
+
+	for (p = 0; p < STATPAGES; p++) {
+		for (i = 0; i < PAGESIZE / WORDLEN; i++)
+			page(p)[i] = expected(p, i);
+	}
+
+	corrupt = FALSE;
+	for (pass = 0; pass < PASSES; pass++) {
+		for (p = 0; p < STATPAGES; p++) {
+			for (i = 0; i < PAGESIZE / WORDLEN; i++) {
+				if (page(p)[i] != expected(p, i))
+					corrupt = TRUE;
+			}
+		}
+	}
+	if (corrupt)
+		print(WRITETERMINAL, "swapStats error: a page came back changed\n");
+	else
+		print(WRITETERMINAL, "swapStats ok: every page came back intact\n");
+
+	hitRate = SYSCALL(SWAPSTATS, (int) &stats, 0, 0);
+
+	print(WRITETERMINAL, "swapStats: stored ");
+	print(WRITETERMINAL, decimal(stats.zs_stores, &digits[11]));
+	print(WRITETERMINAL, ", rejected ");
+	print(WRITETERMINAL, decimal(stats.zs_rejects, &digits[11]));
+	print(WRITETERMINAL, ", written back ");
+	print(WRITETERMINAL, decimal(stats.zs_writebacks, &digits[11]));
+	print(WRITETERMINAL, " in ");
+	print(WRITETERMINAL, decimal(stats.zs_clusters, &digits[11]));
+	print(WRITETERMINAL, " clusters\n");
+
+	if (stats.zs_chunks == 0) {
+		print(WRITETERMINAL, "swapStats: the tier is off (too little RAM)\n");
+	} else if ((stats.zs_stores + stats.zs_rejects) == 0) {
+		print(WRITETERMINAL, "swapStats: no page was evicted (too much RAM)\n");
+	} else if (stats.zs_stores == 0) {
+		print(WRITETERMINAL, "swapStats error: no page was stored in the tier\n");
+	} else {
+		ratio = (stats.zs_inBytes / stats.zs_outBytes) * RATIOSCALE +
+		        ((stats.zs_inBytes % stats.zs_outBytes) * RATIOSCALE) / stats.zs_outBytes;
+		print(WRITETERMINAL, "swapStats: compression ratio ");
+		print(WRITETERMINAL, decimal(ratio / RATIOSCALE, &digits[11]));
+		print(WRITETERMINAL, (ratio % RATIOSCALE < 10) ? ".0" : ".");
+		print(WRITETERMINAL, decimal(ratio % RATIOSCALE, &digits[11]));
+		print(WRITETERMINAL, "\n");
+	}
+
+	if (hitRate < 0) {
+		print(WRITETERMINAL, "swapStats error: SYS28 counted no page-ins\n");
+	} else {
+		print(WRITETERMINAL, "swapStats: hit rate ");
+		print(WRITETERMINAL, decimal(hitRate, &digits[11]));
+		print(WRITETERMINAL, "%\n");
+	}
+
+	print(WRITETERMINAL, "swapStats completed\n");
+	SYSCALL(TERMINATE, 0, 0, 0);
+}
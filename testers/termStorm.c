@@ -0,0 +1,68 @@
+/* Interrupt coalescing test: load into all eight flash devices, so that
+   eight U-Procs write to their eight terminals at the same time. Each one
+   reports the peripheral interrupt entries per device interrupt serviced
+   (every terminal byte is one) over its writing window; with the devices
+   serviced in bursts this ratio is below 1. */
+
+#include "h/localLibumps.h"
+#include "h/tconst.h"
+#include "h/print.h"
+
+#define STORMLINES		16
+#define RATIOSCALE		100
+
+/* Layout of the kernel's intstat_t, filled in by INTSTATS */
+typedef struct intstat_t {
+	unsigned int	is_entries;
+	unsigned int	is_services;
+} intstat_t;
+
+/* Format n in decimal so that it ends at end; return its first digit */
+char *decimal(unsigned int n, char *end) {
+	*end = EOS;
+	do {
+		*--end = '0' + (n % 10);
+		n /= 10;
+	} while (n != 0);
+	return end;
+}
+
+void main() {
+	intstat_t before, after;
+	unsigned int entries, services, ratio;
+	char digits[12];
+	int i;
+
+	print(WRITETERMINAL, "termStorm starts\n");
+
+	/* Line up with the other copies: all wake on the same pseudo-clock tick */
+	SYSCALL(DELAY, 1, 0, 0);
+
+	SYSCALL(INTSTATS, (int) &before, 0, 0);
+	for (i = 0; i < STORMLINES; i++)
+		print(WRITETERMINAL, "the quick brown fox jumps over the lazy dog 0123456789 ABCDEFGH\n");
+	SYSCALL(INTSTATS, (int) &after, 0, 0);
+
+	entries  = after.is_entries - before.is_entries;
+	services = after.is_services - before.is_services;
+
+	print(WRITETERMINAL, "termStorm: interrupt entries ");
+	print(WRITETERMINAL, decimal(entries, &digits[11]));
+	print(WRITETERMINAL, ", devices serviced ");
+	print(WRITETERMINAL, decimal(services, &digits[11]));
+	print(WRITETERMINAL, "\n");
+
+	if (services == 0) {
+		print(WRITETERMINAL, "termStorm error: no device interrupts counted\n");
+	} else {
+		ratio = (entries * RATIOSCALE) / services;
+		print(WRITETERMINAL, "termStorm: entries per byte ");
+		print(WRITETERMINAL, decimal(ratio / RATIOSCALE, &digits[11]));
+		print(WRITETERMINAL, (ratio % RATIOSCALE < 10) ? ".0" : ".");
+		print(WRITETERMINAL, decimal(ratio % RATIOSCALE, &digits[11]));
+		print(WRITETERMINAL, "\n");
+	}
+
+	print(WRITETERMINAL, "termStorm completed\n");
+	SYSCALL(TERMINATE, 0, 0, 0);
+}